@@ -0,0 +1,105 @@
+#include "emulation_thread.h"
+#include <chrono>
+
+namespace chipotto
+{
+	static constexpr std::chrono::nanoseconds FrameDuration(1000000000 / 60);
+
+	EmulationThread::EmulationThread(Emulator& emulator, const ExecutionProfile& profile) : Target(emulator), Profile(profile), Ahead(profile.RunAheadFrames)
+	{
+	}
+
+	EmulationThread::~EmulationThread()
+	{
+		Stop();
+	}
+
+	void EmulationThread::Start()
+	{
+		if (Worker.joinable()) return;
+		StopRequested.store(false, std::memory_order_relaxed);
+		Running.store(true, std::memory_order_release);
+		Worker = std::thread(&EmulationThread::Run, this);
+	}
+
+	void EmulationThread::Stop()
+	{
+		StopRequested.store(true, std::memory_order_relaxed);
+		if (Worker.joinable()) Worker.join();
+	}
+
+	void EmulationThread::NotifyPresented(const std::chrono::steady_clock::time_point when)
+	{
+		const int64_t now = when.time_since_epoch().count();
+		if (PreviousPresent)
+		{
+			// Smooth the refresh period so one late present doesn't shift the schedule.
+			const int64_t interval = now - PreviousPresent;
+			const int64_t period = RefreshPeriod.load(std::memory_order_relaxed);
+			RefreshPeriod.store(period ? (period * 7 + interval) / 8 : interval, std::memory_order_relaxed);
+		}
+		PreviousPresent = now;
+		LastPresent.store(now, std::memory_order_relaxed);
+	}
+
+	std::chrono::steady_clock::time_point EmulationThread::AlignToPresent(const std::chrono::steady_clock::time_point deadline) const
+	{
+		const int64_t period = RefreshPeriod.load(std::memory_order_relaxed);
+		const int64_t last = LastPresent.load(std::memory_order_relaxed);
+		if (!period || !last) return deadline;
+
+		// The first predicted vsync at or after the nominal 60 Hz deadline.
+		const int64_t target = deadline.time_since_epoch().count();
+		const int64_t vsyncs = target > last ? (target - last + period - 1) / period : 0;
+		return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last + vsyncs * period));
+	}
+
+	void EmulationThread::Run()
+	{
+		auto deadline = std::chrono::steady_clock::now() + FrameDuration;
+		while (!StopRequested.load(std::memory_order_relaxed))
+		{
+			std::this_thread::sleep_until(AlignToPresent(deadline) - FrameCost - LatchMargin);
+
+			const auto start = std::chrono::steady_clock::now();
+			std::chrono::steady_clock::time_point input_time{};
+			KeyEvent event;
+			while (Input.Pop(event))
+			{
+				if (input_time == std::chrono::steady_clock::time_point{}) input_time = event.Time;
+				if (event.Pressed)
+					Target.KeyDown(event.Key);
+				else
+					Target.KeyUp(event.Key);
+			}
+
+			if (!Ahead.RunFrame(Target, Profile.InstructionsPerFrame, Profile.IdleSkipSafe))
+			{
+				break;
+			}
+			PublishFrame(input_time);
+
+			const auto finish = std::chrono::steady_clock::now();
+			FrameCost = (FrameCost * 7 + (finish - start)) / 8;
+			deadline += FrameDuration;
+			if (finish > deadline + FrameDuration)
+			{
+				// Fell more than a frame behind (debugger, suspended process): don't try to catch up.
+				deadline = finish;
+			}
+		}
+		Running.store(false, std::memory_order_release);
+	}
+
+	void EmulationThread::PublishFrame(const std::chrono::steady_clock::time_point input_time)
+	{
+		PresentedFrame& frame = Frames.GetWriteBuffer();
+		frame.Display = Ahead.GetFramebuffer(Target);
+		frame.SoundTimer = Target.GetSoundTimer();
+		frame.AudioPattern = Target.GetAudioPattern();
+		frame.AudioPlaybackRate = Target.GetAudioPlaybackRate();
+		frame.InputTime = input_time;
+		frame.RunAheadOverhead = Ahead.GetLastOverhead();
+		Frames.Publish();
+	}
+}
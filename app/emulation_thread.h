@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include "chip-8.h"
+#include "profile_db.h"
+#include "run_ahead.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+namespace chipotto
+{
+	// Everything the presenter needs from one emulated frame.
+	struct PresentedFrame
+	{
+		Framebuffer Display;
+		uint8_t SoundTimer = 0;
+		std::array<uint8_t, 0x10> AudioPattern{};
+		double AudioPlaybackRate = 4000.0;
+		// When the oldest key event latched into this frame was observed, or zero if none.
+		std::chrono::steady_clock::time_point InputTime{};
+		// Cost of this frame's run-ahead, zero when it is off.
+		std::chrono::nanoseconds RunAheadOverhead{ 0 };
+	};
+
+	struct KeyEvent
+	{
+		uint8_t Key = 0;
+		bool Pressed = false;
+		std::chrono::steady_clock::time_point Time{};
+	};
+
+	using InputQueue = SpscQueue<KeyEvent, 64>;
+
+	// Runs an Emulator at 60 frames per second on a worker thread. SDL stays on the main
+	// thread: it pushes key events into the input queue and presents whatever frame was
+	// published last, so a vsync stall never holds up the core and a slow frame never holds
+	// up presentation.
+	//
+	// Input is latched as late as possible: each frame is scheduled to finish LatchMargin
+	// before the presenter's next vsync (as reported through NotifyPresented), using a running
+	// estimate of how long a frame takes. The presenter consumes a frame right after vsync, so
+	// a frame that lands just before it is on screen one refresh later.
+	class EmulationThread
+	{
+	public:
+		EmulationThread(Emulator& emulator, const ExecutionProfile& profile);
+		~EmulationThread();
+		EmulationThread(const EmulationThread& other) = delete;
+		EmulationThread& operator=(const EmulationThread& other) = delete;
+		EmulationThread(EmulationThread&& other) = delete;
+
+		// How long before the predicted vsync a frame should be finished. Set before Start.
+		void SetLatchMargin(const std::chrono::microseconds margin) { LatchMargin = margin; };
+		void Start();
+		void Stop();
+		// Called by the presenting thread right after each present returns.
+		void NotifyPresented(const std::chrono::steady_clock::time_point when);
+		// False once the program exits or fails.
+		bool IsRunning() const { return Running.load(std::memory_order_acquire); };
+
+		InputQueue& GetInput() { return Input; };
+		TripleBuffer<PresentedFrame>& GetFrames() { return Frames; };
+		// Only safe to read while the thread is stopped.
+		const RunAhead& GetRunAhead() const { return Ahead; };
+
+	private:
+		void Run();
+		void PublishFrame(const std::chrono::steady_clock::time_point input_time);
+		std::chrono::steady_clock::time_point AlignToPresent(const std::chrono::steady_clock::time_point deadline) const;
+
+		Emulator& Target;
+		ExecutionProfile Profile;
+		RunAhead Ahead;
+		std::thread Worker;
+		std::atomic<bool> StopRequested{ false };
+		std::atomic<bool> Running{ false };
+
+		std::chrono::microseconds LatchMargin{ 2000 };
+		// Worker only: smoothed cost of draining input, running and publishing one frame.
+		std::chrono::nanoseconds FrameCost{ 0 };
+		// Written by the presenting thread, read by the worker.
+		std::atomic<int64_t> LastPresent{ 0 };
+		std::atomic<int64_t> RefreshPeriod{ 0 };
+		// Presenting thread only.
+		int64_t PreviousPresent = 0;
+
+		InputQueue Input;
+		TripleBuffer<PresentedFrame> Frames;
+	};
+}
@@ -0,0 +1,244 @@
+#include "frontend.h"
+
+namespace chipotto
+{
+	Frontend::Frontend()
+	{
+		KeyboardMap[SDLK_1] = 0x0;
+		KeyboardMap[SDLK_2] = 0x1;
+		KeyboardMap[SDLK_3] = 0x2;
+		KeyboardMap[SDLK_4] = 0x3;
+		KeyboardMap[SDLK_q] = 0x4;
+		KeyboardMap[SDLK_w] = 0x5;
+		KeyboardMap[SDLK_e] = 0x6;
+		KeyboardMap[SDLK_r] = 0x7;
+		KeyboardMap[SDLK_a] = 0x8;
+		KeyboardMap[SDLK_s] = 0x9;
+		KeyboardMap[SDLK_d] = 0xA;
+		KeyboardMap[SDLK_f] = 0xB;
+		KeyboardMap[SDLK_z] = 0xC;
+		KeyboardMap[SDLK_x] = 0xD;
+		KeyboardMap[SDLK_c] = 0xE;
+		KeyboardMap[SDLK_v] = 0xF;
+
+		Window = SDL_CreateWindow("Chip-8", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, Framebuffer::MaxWidth * 5, Framebuffer::MaxHeight * 5, 0);
+		if (!Window)
+		{
+			SDL_Log("Unable to create window: %s", SDL_GetError());
+			return;
+		}
+		Renderer = SDL_CreateRenderer(Window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+		if (!Renderer)
+		{
+			SDL_Log("Unable to create renderer: %s", SDL_GetError());
+			SDL_DestroyWindow(Window);
+			Window = nullptr;
+			return;
+		}
+		Texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, TextureWidth, TextureHeight);
+		if (!Texture)
+		{
+			SDL_Log("Unable to create texture: %s", SDL_GetError());
+			SDL_DestroyRenderer(Renderer);
+			SDL_DestroyWindow(Window);
+			Renderer = nullptr;
+			Window = nullptr;
+			return;
+		}
+
+		SDL_AudioSpec desired = {};
+		desired.freq = AudioFrequency;
+		desired.format = AUDIO_S8;
+		desired.channels = 1;
+		desired.samples = 512;
+		AudioDevice = SDL_OpenAudioDevice(nullptr, 0, &desired, nullptr, 0);
+		if (!AudioDevice)
+		{
+			// Sound is optional, keep running silent.
+			SDL_Log("Unable to open audio device: %s", SDL_GetError());
+		}
+		else
+		{
+			SDL_PauseAudioDevice(AudioDevice, 0);
+		}
+	}
+
+	Frontend::~Frontend()
+	{
+		if (AudioDevice) SDL_CloseAudioDevice(AudioDevice);
+		if (Texture) SDL_DestroyTexture(Texture);
+		if (Renderer) SDL_DestroyRenderer(Renderer);
+		if (Window) SDL_DestroyWindow(Window);
+	}
+
+	bool Frontend::IsValid() const
+	{
+		if (!Window || !Renderer || !Texture)
+			return false;
+		return true;
+	}
+
+	bool Frontend::PollEvents(InputQueue& input)
+	{
+		FlushPendingKeys(input);
+		SDL_Event event;
+		while (SDL_PollEvent(&event))
+		{
+			if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+			{
+				auto it = KeyboardMap.find(event.key.keysym.sym);
+				if (it != KeyboardMap.end())
+				{
+					// The event's timestamp is the SDL tick it was queued at, which can be a whole
+					// vsync-blocked present before this poll.
+					const auto time = std::chrono::steady_clock::now() - std::chrono::milliseconds(SDL_GetTicks() - event.key.timestamp);
+					ForwardKey(input, it->second, event.type == SDL_KEYDOWN, time);
+				}
+			}
+			if (event.type == SDL_QUIT)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void Frontend::ForwardKey(InputQueue& input, const uint8_t key, const bool pressed, const std::chrono::steady_clock::time_point time)
+	{
+		const uint16_t bit = static_cast<uint16_t>(1 << key);
+		HeldKeys = pressed ? HeldKeys | bit : HeldKeys & ~bit;
+		// A key with a state already held back stays behind it, so its events can't reorder.
+		if (!(PendingKeys & bit) && input.Push({ key, pressed, time })) return;
+		if (!PendingKeys) PendingTime = time;
+		PendingKeys |= bit;
+	}
+
+	void Frontend::FlushPendingKeys(InputQueue& input)
+	{
+		for (uint8_t key = 0; key < 0x10 && PendingKeys; ++key)
+		{
+			const uint16_t bit = static_cast<uint16_t>(1 << key);
+			if (!(PendingKeys & bit)) continue;
+			if (!input.Push({ key, (HeldKeys & bit) != 0, PendingTime })) return;
+			PendingKeys &= ~bit;
+		}
+	}
+
+	void Frontend::Present(const Framebuffer& framebuffer)
+	{
+		const int width = framebuffer.GetWidth();
+		const int height = framebuffer.GetHeight();
+
+		// Upload only the rows that differ from the last presented frame, coalesced into spans.
+		// A mode or palette change invalidates every row.
+		const bool full_upload = !ShadowValid || !framebuffer.HasSameLayout(Shadow);
+		int y = 0;
+		while (y < height)
+		{
+			if (!full_upload && framebuffer.RowEquals(Shadow, y))
+			{
+				++y;
+				continue;
+			}
+			const int first = y;
+			while (y < height && (full_upload || !framebuffer.RowEquals(Shadow, y)))
+			{
+				ExpandRow(framebuffer, y, Staging.data() + (y - first) * TextureWidth);
+				++y;
+			}
+			const SDL_Rect span = { 0, first, width, y - first };
+			if (SDL_UpdateTexture(Texture, &span, Staging.data(), TextureWidth * sizeof(uint32_t)) != 0)
+			{
+				SDL_Log("Failed to update texture: %s", SDL_GetError());
+			}
+		}
+		Shadow = framebuffer;
+		ShadowValid = true;
+
+		SetBlendMode(framebuffer);
+		SDL_SetRenderDrawColor(Renderer, 0, 0, 0, 0xFF);
+		SDL_RenderClear(Renderer);
+		const SDL_Rect source = { 0, 0, width, height };
+		SDL_RenderCopy(Renderer, Texture, &source, nullptr);
+		SDL_RenderPresent(Renderer);
+	}
+
+	void Frontend::ExpandRow(const Framebuffer& framebuffer, const int y, uint32_t* row) const
+	{
+		const int width = framebuffer.GetWidth();
+		if (framebuffer.Mega)
+		{
+			const MegaScreen& screen = *framebuffer.Mega;
+			ExpandMegaPalette(screen.GetRow(y), width, screen.Palette.data(), row);
+		}
+		else if (!framebuffer.HasExtraPlanes())
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				row[x] = Palette[framebuffer.GetPixel(x, y)];
+			}
+		}
+		else
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				row[x] = Palette[framebuffer.GetPixelIndex(x, y)];
+			}
+		}
+	}
+
+	void Frontend::SetTitle(const char* title)
+	{
+		SDL_SetWindowTitle(Window, title);
+	}
+
+	void Frontend::SetBlendMode(const Framebuffer& framebuffer)
+	{
+		// MEGA-CHIP's screen alpha and blend mode apply to the whole expanded frame.
+		SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+		uint8_t alpha = 0xFF;
+		if (framebuffer.Mega)
+		{
+			const MegaScreen& screen = *framebuffer.Mega;
+			mode = SDL_BLENDMODE_BLEND;
+			alpha = screen.Alpha;
+			switch (screen.Blend)
+			{
+			case MegaScreen::BlendMode::Normal: break;
+			case MegaScreen::BlendMode::Alpha25: alpha /= 4; break;
+			case MegaScreen::BlendMode::Alpha50: alpha /= 2; break;
+			case MegaScreen::BlendMode::Add: mode = SDL_BLENDMODE_ADD; break;
+			case MegaScreen::BlendMode::Multiply: mode = SDL_BLENDMODE_MOD; break;
+			}
+		}
+		SDL_SetTextureBlendMode(Texture, mode);
+		SDL_SetTextureAlphaMod(Texture, alpha);
+	}
+
+	void Frontend::PlayAudio(const PresentedFrame& frame)
+	{
+		if (!AudioDevice) return;
+
+		if (frame.SoundTimer == 0)
+		{
+			AudioPhase = 0.0;
+			return;
+		}
+
+		// Keep at most two frames queued so the sound stops promptly with the timer.
+		constexpr uint32_t samples_per_frame = AudioFrequency / 60;
+		if (SDL_GetQueuedAudioSize(AudioDevice) > samples_per_frame * 2) return;
+
+		const std::array<uint8_t, 0x10>& pattern = frame.AudioPattern;
+		const double step = frame.AudioPlaybackRate / AudioFrequency;
+		std::array<int8_t, samples_per_frame> samples;
+		for (int8_t& sample : samples)
+		{
+			const int bit = static_cast<int>(AudioPhase) & 0x7F;
+			sample = (pattern[bit >> 3] >> (7 - (bit & 0x7))) & 0x1 ? 32 : -32;
+			AudioPhase += step;
+			if (AudioPhase >= 128.0) AudioPhase -= 128.0;
+		}
+		SDL_QueueAudio(AudioDevice, samples.data(), static_cast<uint32_t>(samples.size()));
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "SDL.h"
+#include "chip-8.h"
+#include "emulation_thread.h"
+
+namespace chipotto
+{
+	// SDL window, texture and keyboard mapping for one Emulator. Everything here is
+	// cold from the interpreter's point of view and is kept out of the core on purpose.
+	class Frontend
+	{
+	public:
+		Frontend();
+		~Frontend();
+		Frontend(const Frontend& other) = delete;
+		Frontend& operator=(const Frontend& other) = delete;
+		Frontend(Frontend&& other) = delete;
+
+		bool IsValid() const;
+
+		// Forwards mapped key presses to the emulation thread, stamped with when SDL received
+		// them. Returns false on quit.
+		bool PollEvents(InputQueue& input);
+		void Present(const Framebuffer& framebuffer);
+		// Queues one frame of XO-CHIP pattern audio while the sound timer runs.
+		void PlayAudio(const PresentedFrame& frame);
+		void SetTitle(const char* title);
+
+	private:
+		static constexpr int TextureWidth = MegaScreen::Width;
+		static constexpr int TextureHeight = MegaScreen::Height;
+
+		// Sends a key event, or holds the key's latest state back while the input queue is full.
+		void ForwardKey(InputQueue& input, const uint8_t key, const bool pressed, const std::chrono::steady_clock::time_point time);
+		void FlushPendingKeys(InputQueue& input);
+		void SetBlendMode(const Framebuffer& framebuffer);
+		void ExpandRow(const Framebuffer& framebuffer, const int y, uint32_t* row) const;
+
+		std::unordered_map<SDL_Keycode, uint8_t> KeyboardMap;
+		// Keys currently held, and those whose state the full input queue hasn't taken yet: a
+		// dropped key-up would leave the key stuck. PendingTime is the oldest held-back event.
+		uint16_t HeldKeys = 0;
+		uint16_t PendingKeys = 0;
+		std::chrono::steady_clock::time_point PendingTime{};
+
+		SDL_Window* Window = nullptr;
+		SDL_Renderer* Renderer = nullptr;
+		SDL_Texture* Texture = nullptr;
+
+		// Copy of the last presented frame, diffed row by row to find what to upload, and the
+		// RGBA rows of the span being uploaded.
+		Framebuffer Shadow;
+		bool ShadowValid = false;
+		std::vector<uint32_t> Staging = std::vector<uint32_t>(TextureWidth * TextureHeight);
+
+		// XO-CHIP colours indexed by the plane bits of each pixel: four for two-plane programs, all
+		// sixteen once a program selects planes 2 and 3.
+		std::array<uint32_t, 16> Palette = {
+			0xFF000000, 0xFFFFFFFF, 0xFF0055AA, 0xFFAA5500,
+			0xFF7E2553, 0xFF008751, 0xFFFF004D, 0xFF5F574F,
+			0xFFC2C3C7, 0xFFFFF1E8, 0xFFFFA300, 0xFFFFEC27,
+			0xFF00E436, 0xFF29ADFF, 0xFF83769C, 0xFFFF77A8
+		};
+
+		static constexpr int AudioFrequency = 48000;
+		SDL_AudioDeviceID AudioDevice = 0;
+		// Position in the 128-bit pattern, carried across frames so the waveform stays continuous.
+		double AudioPhase = 0.0;
+	};
+}
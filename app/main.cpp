@@ -1,29 +1,106 @@
 #define SDL_MAIN_HANDLED
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include "SDL.h"
 #include "chip-8.h"
+#include "emulation_thread.h"
+#include "frontend.h"
+#include "latency_probe.h"
+#include "profile_db.h"
 
 int main(int argc, char** argv)
 {
+	if (argc < 2)
+	{
+		SDL_Log("Usage: %s <rom> [profile database] [latch margin in microseconds]", argv[0]);
+		return -1;
+	}
+
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0)
 	{
 		SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
 		return -1;
 	}
 
-	chipotto::Emulator emulator;
-
-	if (emulator.IsValid())
 	{
-		emulator.LoadFromFile("D:\\AIV\\Terzo anno\\C++\\c8games\\PONG");
-		while (true)
+		chipotto::Frontend frontend;
+		chipotto::Emulator emulator;
+
+		if (frontend.IsValid() && emulator.LoadFromFile(argv[1]))
 		{
-			if (!emulator.Tick())
+			chipotto::ProfileDatabase profiles;
+			profiles.LoadFromFile(argc > 2 ? argv[2] : "profiles.txt");
+			const chipotto::ExecutionProfile profile = profiles.Lookup(emulator.GetProgramHash());
+			if (profile.Quirks == chipotto::QuirkProfile::XoChip && emulator.GetMemoryMapping().GetSize() < chipotto::MemoryImage::ExtendedSize)
+			{
+				emulator.SetMemorySize(chipotto::MemoryImage::ExtendedSize);
+			}
+			else if (profile.Quirks == chipotto::QuirkProfile::MegaChip)
+			{
+				emulator.SetMemorySize(chipotto::MemoryImage::MegaSize);
+			}
+			emulator.SetQuirks(profile.Quirks);
+			SDL_Log("ROM %016llx: %u instructions per frame, %s quirks, %u frames of run-ahead", static_cast<unsigned long long>(emulator.GetProgramHash()),
+				profile.InstructionsPerFrame, chipotto::GetQuirkProfileName(profile.Quirks), profile.RunAheadFrames);
+
+			chipotto::EmulationThread emulation(emulator, profile);
+			if (argc > 3)
+			{
+				emulation.SetLatchMargin(std::chrono::microseconds(std::strtol(argv[3], nullptr, 10)));
+			}
+			chipotto::LatencyProbe latency;
+			std::chrono::nanoseconds run_ahead_overhead{ 0 };
+			uint32_t run_ahead_frames = 0;
+			emulation.Start();
+			while (emulation.IsRunning() && frontend.PollEvents(emulation.GetInput()))
+			{
+				const bool fresh = emulation.GetFrames().Consume();
+				const chipotto::PresentedFrame& frame = emulation.GetFrames().GetReadBuffer();
+				frontend.Present(frame.Display);
+				const auto presented = std::chrono::steady_clock::now();
+				emulation.NotifyPresented(presented);
+				if (fresh && frame.InputTime != std::chrono::steady_clock::time_point{})
+				{
+					latency.Record(presented - frame.InputTime);
+				}
+				frontend.PlayAudio(frame);
+
+				if (fresh && profile.RunAheadFrames)
+				{
+					// Report the run-ahead cost in the title bar, averaged over a second.
+					run_ahead_overhead += frame.RunAheadOverhead;
+					if (++run_ahead_frames == 60)
+					{
+						char title[64];
+						std::snprintf(title, sizeof(title), "Chip-8 - run-ahead %u: %.1f us/frame", profile.RunAheadFrames,
+							std::chrono::duration<double, std::micro>(run_ahead_overhead).count() / run_ahead_frames);
+						frontend.SetTitle(title);
+						run_ahead_overhead = std::chrono::nanoseconds(0);
+						run_ahead_frames = 0;
+					}
+				}
+			}
+			emulation.Stop();
+
+			if (profile.RunAheadFrames)
+			{
+				using microseconds = std::chrono::duration<double, std::micro>;
+				SDL_Log("Run-ahead overhead: mean %.1f us, max %.1f us per frame",
+					microseconds(emulation.GetRunAhead().GetMeanOverhead()).count(), microseconds(emulation.GetRunAhead().GetMaxOverhead()).count());
+			}
+
+			if (latency.GetCount())
 			{
-				break;
+				using milliseconds = std::chrono::duration<double, std::milli>;
+				SDL_Log("Input to present latency over %llu frames: mean %.1f ms, p50 %.1f ms, p99 %.1f ms, max %.1f ms",
+					static_cast<unsigned long long>(latency.GetCount()), milliseconds(latency.GetMean()).count(),
+					milliseconds(latency.GetPercentile(0.5)).count(), milliseconds(latency.GetPercentile(0.99)).count(),
+					milliseconds(latency.GetMax()).count());
 			}
 		}
 	}
 
 	SDL_Quit();
 	return 0;
-}
\ No newline at end of file
+}
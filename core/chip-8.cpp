@@ -1,197 +1,386 @@
 #include "chip-8.h"
-#include "SDL.h"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include "debugger.h"
+#include "rom_hash.h"
 
 namespace chipotto
 {
-	Emulator::Emulator()
-	{
-		KeyboardMap[SDLK_1] = 0x0;
-		KeyboardMap[SDLK_2] = 0x1;
-		KeyboardMap[SDLK_3] = 0x2;
-		KeyboardMap[SDLK_4] = 0x3;
-		KeyboardMap[SDLK_q] = 0x4;
-		KeyboardMap[SDLK_w] = 0x5;
-		KeyboardMap[SDLK_e] = 0x6;
-		KeyboardMap[SDLK_r] = 0x7;
-		KeyboardMap[SDLK_a] = 0x8;
-		KeyboardMap[SDLK_s] = 0x9;
-		KeyboardMap[SDLK_d] = 0xA;
-		KeyboardMap[SDLK_f] = 0xB;
-		KeyboardMap[SDLK_z] = 0xC;
-		KeyboardMap[SDLK_x] = 0xD;
-		KeyboardMap[SDLK_c] = 0xE;
-		KeyboardMap[SDLK_v] = 0xF;
-
-		for (const auto& pair : KeyboardMap)
-		{
-			KeyboardValuesMap[pair.second] = static_cast<SDL_Scancode>(pair.first);
-		}
-
-		Opcodes[0x0] = std::bind(&Emulator::Opcode0, this, std::placeholders::_1);
-		Opcodes[0x1] = std::bind(&Emulator::Opcode1, this, std::placeholders::_1);
-		Opcodes[0x2] = std::bind(&Emulator::Opcode2, this, std::placeholders::_1);
-		Opcodes[0x3] = std::bind(&Emulator::Opcode3, this, std::placeholders::_1);
-		Opcodes[0x4] = std::bind(&Emulator::Opcode4, this, std::placeholders::_1);
-		Opcodes[0x5] = std::bind(&Emulator::Opcode5, this, std::placeholders::_1);
-		Opcodes[0x6] = std::bind(&Emulator::Opcode6, this, std::placeholders::_1);
-		Opcodes[0x7] = std::bind(&Emulator::Opcode7, this, std::placeholders::_1);
-		Opcodes[0x8] = std::bind(&Emulator::Opcode8, this, std::placeholders::_1);
-		Opcodes[0x9] = std::bind(&Emulator::Opcode9, this, std::placeholders::_1);
-		Opcodes[0xA] = std::bind(&Emulator::OpcodeA, this, std::placeholders::_1);
-		Opcodes[0xB] = std::bind(&Emulator::OpcodeB, this, std::placeholders::_1);
-		Opcodes[0xC] = std::bind(&Emulator::OpcodeC, this, std::placeholders::_1);
-		Opcodes[0xD] = std::bind(&Emulator::OpcodeD, this, std::placeholders::_1);
-		Opcodes[0xE] = std::bind(&Emulator::OpcodeE, this, std::placeholders::_1);
-		Opcodes[0xF] = std::bind(&Emulator::OpcodeF, this, std::placeholders::_1);
-
-		//FINISH IMPLEMENTATION OF SPRITES
-		MemoryMapping[0x0] = 0xF0;
-		MemoryMapping[0x1] = 0x90;
-		MemoryMapping[0x2] = 0x90;
-		MemoryMapping[0x3] = 0x90;
-		MemoryMapping[0x4] = 0xF0;
-
-		Window = SDL_CreateWindow("Chip-8", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width * 10, height * 10, 0);
-		if (!Window)
-		{
-			SDL_Log("Unable to create window: %s", SDL_GetError());
-			return;
-		}
-		Renderer = SDL_CreateRenderer(Window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-		if (!Renderer)
-		{
-			SDL_Log("Unable to create renderer: %s", SDL_GetError());
-			SDL_DestroyWindow(Window);
-			return;
-		}
-		Texture = SDL_CreateTexture(Renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STREAMING, width, height);
-		if (!Texture)
-		{
-			SDL_Log("Unable to create texture: %s", SDL_GetError());
-			SDL_DestroyRenderer(Renderer);
-			SDL_DestroyWindow(Window);
-			return;
-		}
-	}
-
-	bool Emulator::LoadFromFile(std::filesystem::path Path)
+	template<typename Quirks>
+	const Emulator::OpcodeTable Emulator::QuirkOpcodes =
+	{
+		&Emulator::Opcode0, &Emulator::Opcode1, &Emulator::Opcode2, &Emulator::Opcode3,
+		&Emulator::Opcode4, &Emulator::Opcode5, &Emulator::Opcode6, &Emulator::Opcode7,
+		&Emulator::Opcode8<Quirks>, &Emulator::Opcode9, &Emulator::OpcodeA, &Emulator::OpcodeB<Quirks>,
+		&Emulator::OpcodeC, &Emulator::OpcodeD<Quirks>, &Emulator::OpcodeE, &Emulator::OpcodeF<Quirks>
+	};
+
+	Emulator::Emulator() : Opcodes(&QuirkOpcodes<ChipottoQuirks>)
+	{
+	}
+
+	bool Emulator::LoadFromFile(std::filesystem::path Path, const uint32_t memory_size)
 	{
 		std::ifstream file;
-		file.open(Path, std::ios::binary);
+		file.open(Path, std::ios::binary | std::ios::ate);
 		if (!file.is_open()) return false;
 
-		auto file_size = std::filesystem::file_size(Path);
+		const std::streamoff file_size = file.tellg();
+		if (file_size <= 0 || file_size > MemoryImage::MegaSize - MemoryImage::ProgramAddress) return false;
+
+		std::vector<uint8_t> program(static_cast<size_t>(file_size));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(program.data()), file_size);
+		if (!file) return false;
 
-		file.read(reinterpret_cast<char*>(MemoryMapping.data() + PC), file_size);
-		file.close();
+		return LoadFromMemory(program, memory_size);
 	}
 
-	bool Emulator::Tick()
+	bool Emulator::LoadFromMemory(std::span<const uint8_t> program, uint32_t memory_size)
 	{
-		uint64_t tick = SDL_GetTicks64();
+		if (memory_size == 0) memory_size = MemoryImage::GetFittingSize(program.size());
+		if (memory_size == 0 || program.size() > memory_size - MemoryImage::ProgramAddress) return false;
+
+		LoadFromImage(MemoryImage::Create(program, memory_size));
+		return true;
+	}
 
-		if (DelayTimer > 0 && tick >= DeltaTimerTicks)
+	void Emulator::SetMemorySize(const uint32_t memory_size)
+	{
+		if (MemoryMapping.GetSize() == memory_size) return;
+		LoadFromImage(MemoryImage::Resize(*MemoryMapping.GetImage(), memory_size));
+	}
+
+	void Emulator::LoadFromImage(std::shared_ptr<const MemoryImage> image)
+	{
+		MemoryMapping.Map(std::move(image));
+	}
+
+	void Emulator::SetQuirks(const QuirkProfile profile)
+	{
+		switch (profile)
 		{
-			DelayTimer--;
-			DeltaTimerTicks = 17 + SDL_GetTicks64();
+		case QuirkProfile::Chipotto: Opcodes = &QuirkOpcodes<ChipottoQuirks>; break;
+		case QuirkProfile::CosmacVip: Opcodes = &QuirkOpcodes<CosmacVipQuirks>; break;
+		case QuirkProfile::SuperChip: Opcodes = &QuirkOpcodes<SuperChipQuirks>; break;
+		case QuirkProfile::XoChip: Opcodes = &QuirkOpcodes<XoChipQuirks>; break;
+		case QuirkProfile::MegaChip: Opcodes = &QuirkOpcodes<MegaChipQuirks>; break;
 		}
+	}
 
-		SDL_Event event;
-		while (SDL_PollEvent(&event))
-		{
-			if (event.type == SDL_KEYDOWN)
-			{
-				SDL_Keycode key = event.key.keysym.sym;
-				if (KeyboardMap.contains(key))
-				{
-					Registers[WaitForKeyboardRegister_Index] = KeyboardMap[key];
-					Suspended = false;
-					PC += 2;
-				}
-			}
-			if (event.type == SDL_QUIT)
+	void Emulator::SaveState(Snapshot& snapshot) const
+	{
+		snapshot.Cpu = Cpu;
+		snapshot.Quirks = GetQuirks();
+		snapshot.Display = Display;
+		snapshot.Flags = Flags;
+		snapshot.AudioPattern = AudioPattern;
+		snapshot.Pitch = Pitch;
+		snapshot.Rng = Rng;
+		MemoryMapping.SaveTo(snapshot.Memory);
+	}
+
+	void Emulator::LoadState(const Snapshot& snapshot)
+	{
+		Cpu = snapshot.Cpu;
+		SetQuirks(snapshot.Quirks);
+		Display = snapshot.Display;
+		Flags = snapshot.Flags;
+		AudioPattern = snapshot.AudioPattern;
+		Pitch = snapshot.Pitch;
+		Rng = snapshot.Rng;
+		MemoryMapping.RestoreFrom(snapshot.Memory);
+	}
+
+	// Memory and the bitplanes bring their own incrementally kept hashes. The CPU is a single
+	// cache line, cheaper to hash when asked than to track through every instruction.
+	static uint64_t HashState(const CpuState& cpu_state, const Random& rng, const Framebuffer& display, const std::array<uint8_t, 0x10>& flags, const uint64_t image_hash, const uint64_t content_hash)
+	{
+		// Serialise the CPU field by field so struct padding never reaches the hash.
+		std::array<uint8_t, 128> cpu{};
+		size_t offset = 0;
+		auto put = [&cpu, &offset](const uint64_t value, const size_t bytes)
 			{
-				return false;
-			}
-		}
-		SDL_PumpEvents();
+				for (size_t i = 0; i < bytes; ++i) cpu[offset++] = static_cast<uint8_t>(value >> (8 * i));
+			};
+		for (const uint8_t value : cpu_state.Registers) put(value, 1);
+		for (const uint16_t value : cpu_state.Stack) put(value, 2);
+		put(cpu_state.I, 4);
+		put(cpu_state.PC, 2);
+		put(cpu_state.Keys, 2);
+		put(cpu_state.SP, 1);
+		put(cpu_state.DelayTimer, 1);
+		put(cpu_state.SoundTimer, 1);
+		put(cpu_state.WaitForKeyboardRegister_Index, 1);
+		put(cpu_state.Suspended, 1);
+		for (const uint32_t value : rng.GetState()) put(value, 4);
+		for (const uint8_t value : flags) put(value, 1);
+		put(content_hash, 8);
+		put(display.GetPixelHash(), 8);
+		put(display.SelectedPlanes, 1);
+		put(display.HighResolution, 1);
+
+		const uint64_t hash = HashRom(std::span<const uint8_t>(cpu.data(), offset), image_hash);
+		if (!display.Mega) return hash;
+		return HashRom(display.Mega->Pixels, hash);
+	}
+
+	uint64_t Snapshot::GetChecksum() const
+	{
+		return HashState(Cpu, Rng, Display, Flags, Memory.Image ? Memory.Image->GetHash() : 0, Memory.ContentHash);
+	}
 
-		if (Suspended) return true;
+	uint64_t Emulator::GetStateChecksum() const
+	{
+		return HashState(Cpu, Rng, Display, Flags, MemoryMapping.GetImage()->GetHash(), MemoryMapping.GetContentHash());
+	}
 
-		uint16_t opcode = MemoryMapping[PC + 1] + (static_cast<uint16_t>(MemoryMapping[PC]) << 8);
-		std::cout << std::hex << "0x" << PC << ": 0x" << opcode << "  -->  ";
+	QuirkProfile Emulator::GetQuirks() const
+	{
+		if (Opcodes == &QuirkOpcodes<CosmacVipQuirks>) return QuirkProfile::CosmacVip;
+		if (Opcodes == &QuirkOpcodes<SuperChipQuirks>) return QuirkProfile::SuperChip;
+		if (Opcodes == &QuirkOpcodes<XoChipQuirks>) return QuirkProfile::XoChip;
+		if (Opcodes == &QuirkOpcodes<MegaChipQuirks>) return QuirkProfile::MegaChip;
+		return QuirkProfile::Chipotto;
+	}
 
-		OpcodeStatus status = Opcodes[opcode >> 12](opcode);
+	bool Emulator::Tick()
+	{
+		if (Cpu.Suspended) return true;
 
-		std::cout << std::endl;
+		uint16_t opcode = MemoryMapping[Cpu.PC + 1] + (static_cast<uint16_t>(MemoryMapping[Cpu.PC]) << 8);
+		OpcodeStatus status = (this->*(*Opcodes)[opcode >> 12])(opcode);
 		if (status == OpcodeStatus::IncrementPC)
 		{
-			PC += 2;
+			Cpu.PC += 2;
 		}
-		return status != OpcodeStatus::NotImplemented && status != OpcodeStatus::StackOverflow && status != OpcodeStatus::Error;
+		return status != OpcodeStatus::NotImplemented && status != OpcodeStatus::StackOverflow && status != OpcodeStatus::Error && status != OpcodeStatus::Exit;
 	}
 
-	bool Emulator::IsValid() const
+	bool Emulator::RunFrame(const uint32_t instructions, const bool skip_idle)
 	{
-		if (!Window || !Renderer || !Texture)
-			return false;
+		for (uint32_t i = 0; i < instructions; ++i)
+		{
+			if (skip_idle)
+			{
+				// A jump to itself only burns cycles until the next timer tick.
+				const uint16_t opcode = MemoryMapping[Cpu.PC + 1] + (static_cast<uint16_t>(MemoryMapping[Cpu.PC]) << 8);
+				if (opcode == (0x1000 | Cpu.PC)) break;
+			}
+			if (!Tick()) return false;
+			if (Cpu.Suspended) break;
+		}
+		TickTimers();
 		return true;
 	}
 
+	void Emulator::TickTimers()
+	{
+		if (Cpu.DelayTimer > 0) Cpu.DelayTimer--;
+		if (Cpu.SoundTimer > 0) Cpu.SoundTimer--;
+	}
+
+	void Emulator::KeyDown(const uint8_t key)
+	{
+		Cpu.Keys |= 1 << (key & 0xF);
+		if (Cpu.Suspended)
+		{
+			Cpu.Registers[Cpu.WaitForKeyboardRegister_Index] = key & 0xF;
+			Cpu.Suspended = false;
+			Cpu.PC += 2;
+		}
+	}
+
+	void Emulator::KeyUp(const uint8_t key)
+	{
+		Cpu.Keys &= ~(1 << (key & 0xF));
+	}
+
+	void Emulator::SetKeys(const uint16_t keys)
+	{
+		const uint16_t changed = keys ^ Cpu.Keys;
+		for (uint8_t key = 0; key < 0x10; ++key)
+		{
+			if (!((changed >> key) & 0x1)) continue;
+			if ((keys >> key) & 0x1)
+				KeyDown(key);
+			else
+				KeyUp(key);
+		}
+	}
+
 	OpcodeStatus Emulator::Opcode0(const uint16_t opcode)
 	{
-		if ((opcode & 0xFF) == 0xE0)
+		if ((opcode & 0xFF00) != 0x0000)
+		{
+			return OpcodeMega(opcode);
+		}
+		else if ((opcode & 0xFFFF) == 0x0010)
+		{
+			Display.SetMegaMode(false);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFFFF) == 0x0011)
+		{
+			Display.SetMegaMode(true);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFFF0) == 0x00B0)
+		{
+			uint8_t lines = opcode & 0xF;
+			Display.ScrollUp(lines);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFFF0) == 0x00C0)
+		{
+			uint8_t lines = opcode & 0xF;
+			Display.ScrollDown(lines);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFFF0) == 0x00D0)
+		{
+			uint8_t lines = opcode & 0xF;
+			Display.ScrollUp(lines);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFF) == 0xE0)
 		{
-			std::cout << "CLS";
-			uint8_t* pixels = nullptr;
-			int pitch;
-			int result = SDL_LockTexture(Texture, nullptr, reinterpret_cast<void**>(&pixels), &pitch);
-			memset(pixels, 0, pitch * height);
-			SDL_UnlockTexture(Texture);
-			SDL_RenderCopy(Renderer, Texture, nullptr, nullptr);
-			SDL_RenderPresent(Renderer);
+			Display.Clear();
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0xEE)
 		{
-			if (SP > 0xF && SP < 0xFF) return OpcodeStatus::StackOverflow;
-			std::cout << "RET";
-			PC = Stack[SP & 0xF];
-			SP -= 1;
+			if (Cpu.SP > 0xF && Cpu.SP < 0xFF) return OpcodeStatus::StackOverflow;
+			Cpu.PC = Cpu.Stack[Cpu.SP & 0xF];
+			Cpu.SP -= 1;
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFFFF) == 0x00FB)
+		{
+			Display.ScrollRight(4);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFFFF) == 0x00FC)
+		{
+			Display.ScrollLeft(4);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFFFF) == 0x00FD)
+		{
+			return OpcodeStatus::Exit;
+		}
+		else if ((opcode & 0xFFFF) == 0x00FE)
+		{
+			Display.SetHighResolution(false);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFFFF) == 0x00FF)
+		{
+			Display.SetHighResolution(true);
 			return OpcodeStatus::IncrementPC;
 		}
 		return OpcodeStatus::NotImplemented;
 	}
 
+	// MEGA-CHIP's 01nn-09nn. Everything but the mode switch needs MEGA-CHIP mode on.
+	OpcodeStatus Emulator::OpcodeMega(const uint16_t opcode)
+	{
+		if (!Display.Mega) return OpcodeStatus::NotImplemented;
+		MegaScreen& screen = *Display.Mega;
+		const uint8_t value = opcode & 0xFF;
+		switch (opcode >> 8)
+		{
+		case 0x01:
+			Cpu.I = (static_cast<uint32_t>(value) << 16) | (static_cast<uint32_t>(MemoryMapping[Cpu.PC + 2]) << 8) | MemoryMapping[Cpu.PC + 3];
+			Cpu.PC += 2;
+			return OpcodeStatus::IncrementPC;
+		case 0x02:
+			if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Read, Cpu.I, value * 4);
+			// Colours are stored ARGB and fill the palette from index 1; index 0 stays transparent.
+			for (int i = 0; i < value; ++i)
+			{
+				const uint32_t address = Cpu.I + i * 4;
+				screen.SetPaletteEntry(static_cast<uint8_t>(i + 1), MemoryMapping[address], MemoryMapping[address + 1], MemoryMapping[address + 2], MemoryMapping[address + 3]);
+			}
+			return OpcodeStatus::IncrementPC;
+		case 0x03:
+			screen.SpriteWidth = value ? value : MegaScreen::Width;
+			return OpcodeStatus::IncrementPC;
+		case 0x04:
+			screen.SpriteHeight = value ? value : 0x100;
+			return OpcodeStatus::IncrementPC;
+		case 0x05:
+			screen.Alpha = value;
+			return OpcodeStatus::IncrementPC;
+		case 0x06:
+		case 0x07:
+			// Digitised sound is decoded but not played.
+			return OpcodeStatus::IncrementPC;
+		case 0x08:
+			if ((value & 0xF) > static_cast<uint8_t>(MegaScreen::BlendMode::Multiply)) return OpcodeStatus::NotImplemented;
+			screen.Blend = static_cast<MegaScreen::BlendMode>(value & 0xF);
+			return OpcodeStatus::IncrementPC;
+		case 0x09:
+			screen.CollisionIndex = value;
+			return OpcodeStatus::IncrementPC;
+		}
+		return OpcodeStatus::NotImplemented;
+	}
+
+	bool Emulator::DrawMegaSprite(const int x, const int y)
+	{
+		MegaScreen& screen = *Display.Mega;
+		// Sprites clip at the right and bottom edges.
+		const int visible_width = std::min(screen.SpriteWidth, MegaScreen::Width - x);
+		const int visible_height = std::min(screen.SpriteHeight, MegaScreen::Height - y);
+		if (visible_width <= 0) return false;
+
+		std::array<uint8_t, MegaScreen::Width> row;
+		bool collision = false;
+		for (int sprite_y = 0; sprite_y < visible_height; ++sprite_y)
+		{
+			MemoryMapping.ReadBlock(Cpu.I + sprite_y * screen.SpriteWidth, std::span<uint8_t>(row.data(), visible_width));
+			collision |= BlitMegaRow(screen.GetRow(y + sprite_y) + x, row.data(), visible_width, screen.CollisionIndex);
+		}
+		return collision;
+	}
+
+	void Emulator::SkipNextInstruction()
+	{
+		// XO-CHIP's F000 nnnn and MEGA-CHIP's 01nn nnnn are four bytes long; skipping them must skip both words.
+		const uint16_t next = Cpu.PC + 2;
+		const bool long_instruction = (MemoryMapping[next] == 0xF0 && MemoryMapping[next + 1] == 0x00) || (Display.Mega && MemoryMapping[next] == 0x01);
+		Cpu.PC += long_instruction ? 4 : 2;
+	}
+
 	OpcodeStatus Emulator::Opcode1(const uint16_t opcode)
 	{
 		uint16_t address = opcode & 0x0FFF;
-		std::cout << "JP 0x" << address;
-		PC = address - 2;
+		Cpu.PC = address - 2;
 		return OpcodeStatus::IncrementPC;
 	}
 
 	OpcodeStatus Emulator::Opcode2(const uint16_t opcode)
 	{
 		uint16_t address = opcode & 0xFFF;
-		std::cout << "CALL 0x" << (int)address;
-		if (SP > 0xF)
+		if (Cpu.SP > 0xF)
 		{
-			SP = 0;
+			Cpu.SP = 0;
 		}
 		else
 		{
-			if (SP < 0xF)
+			if (Cpu.SP < 0xF)
 			{
-				SP += 1;
+				Cpu.SP += 1;
 			}
 			else
 			{
 				return OpcodeStatus::StackOverflow;
 			}
 		}
-		Stack[SP] = PC;
-		PC = address;
+		Cpu.Stack[Cpu.SP] = Cpu.PC;
+		Cpu.PC = address;
 		return OpcodeStatus::NotIncrementPC;
 	}
 
@@ -199,9 +388,8 @@ namespace chipotto
 	{
 		uint8_t register_index = (opcode >> 8) & 0xF;
 		uint8_t value = opcode & 0xFF;
-		std::cout << "SE V" << (int)register_index << ", 0x" << (int)value;
-		if (Registers[register_index] == value)
-			PC += 2;
+		if (Cpu.Registers[register_index] == value)
+			SkipNextInstruction();
 		return OpcodeStatus::IncrementPC;
 	}
 
@@ -209,9 +397,8 @@ namespace chipotto
 	{
 		uint8_t register_index = (opcode >> 8) & 0xF;
 		uint8_t value = opcode & 0xFF;
-		std::cout << "SNE V" << (int)register_index << ", 0x" << (int)value;
-		if (Registers[register_index] != value)
-			PC += 2;
+		if (Cpu.Registers[register_index] != value)
+			SkipNextInstruction();
 		return OpcodeStatus::IncrementPC;
 	}
 
@@ -219,18 +406,42 @@ namespace chipotto
 	{
 		uint8_t registerX_index = (opcode >> 8) & 0xF;
 		uint8_t registerY_index = (opcode >> 4) & 0xF;
-		std::cout << "SE V" << (int)registerX_index << ", V" << (int)registerY_index;
-		if (Registers[registerX_index] == Registers[registerY_index])
-			PC += 2;
-		return OpcodeStatus::IncrementPC;
+		if ((opcode & 0xF) == 0x0)
+		{
+			if (Cpu.Registers[registerX_index] == Cpu.Registers[registerY_index])
+				SkipNextInstruction();
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xF) == 0x2)
+		{
+			const int step = registerX_index <= registerY_index ? 1 : -1;
+			if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Write, Cpu.I, std::abs(registerX_index - registerY_index) + 1);
+			for (int i = 0, register_index = registerX_index; ; ++i, register_index += step)
+			{
+				MemoryMapping.Write(Cpu.I + i, Cpu.Registers[register_index]);
+				if (register_index == registerY_index) break;
+			}
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xF) == 0x3)
+		{
+			const int step = registerX_index <= registerY_index ? 1 : -1;
+			if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Read, Cpu.I, std::abs(registerX_index - registerY_index) + 1);
+			for (int i = 0, register_index = registerX_index; ; ++i, register_index += step)
+			{
+				Cpu.Registers[register_index] = MemoryMapping[Cpu.I + i];
+				if (register_index == registerY_index) break;
+			}
+			return OpcodeStatus::IncrementPC;
+		}
+		return OpcodeStatus::NotImplemented;
 	}
 
 	OpcodeStatus Emulator::Opcode6(const uint16_t opcode)
 	{
 		uint8_t register_index = (opcode >> 8) & 0xF;
 		uint8_t register_value = opcode & 0xFF;
-		Registers[register_index] = register_value;
-		std::cout << "LD V" << (int)register_index << ", 0x" << (int)register_value;
+		Cpu.Registers[register_index] = register_value;
 		return OpcodeStatus::IncrementPC;
 	}
 
@@ -238,92 +449,89 @@ namespace chipotto
 	{
 		uint8_t register_index = (opcode >> 8) & 0xF;
 		uint8_t value = opcode & 0xFF;
-		std::cout << "ADD V" << (int)register_index << ", 0x" << (int)value;
-		Registers[register_index] += value;
+		Cpu.Registers[register_index] += value;
 		return OpcodeStatus::IncrementPC;
 	}
 
+	template<typename Quirks>
 	OpcodeStatus Emulator::Opcode8(const uint16_t opcode)
 	{
 		if ((opcode & 0xF) == 0x0)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			Registers[registerX_index] = Registers[registerY_index];
-			std::cout << "LD V" << (int)registerX_index << ", V" << (int)registerY_index;
+			Cpu.Registers[registerX_index] = Cpu.Registers[registerY_index];
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xF) == 0x1)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			Registers[registerX_index] |= Registers[registerY_index];
-			std::cout << "OR V" << (int)registerX_index << ", V" << (int)registerY_index;
+			Cpu.Registers[registerX_index] |= Cpu.Registers[registerY_index];
+			if constexpr (Quirks::LogicResetsVF) Cpu.Registers[0xF] = 0;
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xF) == 0x2)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			Registers[registerX_index] &= Registers[registerY_index];
-			std::cout << "AND V" << (int)registerX_index << ", V" << (int)registerY_index;
+			Cpu.Registers[registerX_index] &= Cpu.Registers[registerY_index];
+			if constexpr (Quirks::LogicResetsVF) Cpu.Registers[0xF] = 0;
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xF) == 0x3)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			Registers[registerX_index] ^= Registers[registerY_index];
-			std::cout << "XOR V" << (int)registerX_index << ", V" << (int)registerY_index;
+			Cpu.Registers[registerX_index] ^= Cpu.Registers[registerY_index];
+			if constexpr (Quirks::LogicResetsVF) Cpu.Registers[0xF] = 0;
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xF) == 0x4)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			int result = static_cast<int>(Registers[registerX_index]) + Registers[registerY_index];
-			if (result > 255) Registers[0xF] = 1;
-			else Registers[0xF] = 0;
-			Registers[registerX_index] += Registers[registerY_index];
-			std::cout << "ADD V" << (int)registerX_index << ", V" << (int)registerY_index;
+			int result = static_cast<int>(Cpu.Registers[registerX_index]) + Cpu.Registers[registerY_index];
+			if (result > 255) Cpu.Registers[0xF] = 1;
+			else Cpu.Registers[0xF] = 0;
+			Cpu.Registers[registerX_index] += Cpu.Registers[registerY_index];
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xF) == 0x5)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			if (Registers[registerX_index] > Registers[registerY_index]) Registers[0xF] = 1;
-			else Registers[0xF] = 0;
-			Registers[registerX_index] -= Registers[registerY_index];
-			std::cout << "SUB V" << (int)registerX_index << ", V" << (int)registerY_index;
+			if (Cpu.Registers[registerX_index] > Cpu.Registers[registerY_index]) Cpu.Registers[0xF] = 1;
+			else Cpu.Registers[0xF] = 0;
+			Cpu.Registers[registerX_index] -= Cpu.Registers[registerY_index];
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xF) == 0x6)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			Registers[0xF] = Registers[registerX_index] << 7;
-			Registers[registerX_index] >>= 1;
-			std::cout << "SHR V" << (int)registerX_index << "{, V" << (int)registerY_index << "}";
+			const uint8_t source = Quirks::ShiftUsesVY ? Cpu.Registers[registerY_index] : Cpu.Registers[registerX_index];
+			Cpu.Registers[registerX_index] = source >> 1;
+			Cpu.Registers[0xF] = source & 0x1;
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xF) == 0x7)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			if (Registers[registerY_index] > Registers[registerX_index]) Registers[0xF] = 1;
-			else Registers[0xF] = 0;
-			Registers[registerY_index] -= Registers[registerX_index];
-			std::cout << "SUBN V" << (int)registerX_index << ", V" << (int)registerY_index;
+			// The flag goes in last, so it survives 8Fy7.
+			const uint8_t flag = Cpu.Registers[registerY_index] > Cpu.Registers[registerX_index] ? 1 : 0;
+			Cpu.Registers[registerX_index] = Cpu.Registers[registerY_index] - Cpu.Registers[registerX_index];
+			Cpu.Registers[0xF] = flag;
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xF) == 0xE)
 		{
 			uint8_t registerX_index = (opcode >> 8) & 0xF;
 			uint8_t registerY_index = (opcode >> 4) & 0xF;
-			Registers[0xF] = Registers[registerX_index] >> 7;
-			Registers[registerX_index] <<= 1;
-			std::cout << "SHL V" << (int)registerX_index << "{, V" << (int)registerY_index << "}";
+			const uint8_t source = Quirks::ShiftUsesVY ? Cpu.Registers[registerY_index] : Cpu.Registers[registerX_index];
+			Cpu.Registers[registerX_index] = source << 1;
+			Cpu.Registers[0xF] = source >> 7;
 			return OpcodeStatus::IncrementPC;
 		}
 		else
@@ -336,26 +544,27 @@ namespace chipotto
 	{
 		uint8_t registerX_index = (opcode >> 8) & 0xF;
 		uint8_t registerY_index = (opcode >> 4) & 0xF;
-		std::cout << "SNE V" << (int)registerX_index << ", V" << (int)registerY_index;
-		if (Registers[registerX_index] != Registers[registerY_index])
-			PC += 2;
+		if (Cpu.Registers[registerX_index] != Cpu.Registers[registerY_index])
+			SkipNextInstruction();
 		return OpcodeStatus::IncrementPC;
 	}
 
 	OpcodeStatus Emulator::OpcodeA(const uint16_t opcode)
 	{
 		uint16_t value = (opcode & 0xFFF);
-		std::cout << "LD I, 0x" << (int)value;
-		I = value;
+		Cpu.I = value;
 		return OpcodeStatus::IncrementPC;
 	}
 
+	template<typename Quirks>
 	OpcodeStatus Emulator::OpcodeB(const uint16_t opcode)
 	{
 		uint16_t address = opcode & 0xFFF;
-		address += Registers[0];
-		std::cout << "JP 0x" << address;
-		PC = address - 2;
+		if constexpr (Quirks::JumpUsesVX)
+			address += Cpu.Registers[(opcode >> 8) & 0xF];
+		else
+			address += Cpu.Registers[0];
+		Cpu.PC = address - 2;
 		return OpcodeStatus::IncrementPC;
 	}
 
@@ -363,64 +572,61 @@ namespace chipotto
 	{
 		uint8_t register_index = (opcode >> 8) & 0xF;
 		uint8_t random_mask = opcode & 0xFF;
-		std::cout << "RND V" << (int)register_index << ", 0x" << (int)random_mask;
-		Registers[register_index] = (std::rand() % 256) & random_mask;
+		Cpu.Registers[register_index] = Rng.NextByte() & random_mask;
 		return OpcodeStatus::IncrementPC;
 	}
 
+	template<typename Quirks>
 	OpcodeStatus Emulator::OpcodeD(const uint16_t opcode)
 	{
 		uint8_t registerX_index = (opcode >> 8) & 0xF;
 		uint8_t registerY_index = (opcode >> 4) & 0xF;
 		uint8_t sprite_height = opcode & 0xF;
-		std::cout << "DRW V" << (int)registerX_index << ", V" << (int)registerY_index << ", " << (int)sprite_height;
 
-		uint8_t x_coord = Registers[registerX_index] % width;
-		uint8_t y_coord = Registers[registerY_index] % height;
-
-		uint8_t* pixels = nullptr;
-		int pitch;
-		int result = SDL_LockTexture(Texture, nullptr, reinterpret_cast<void**>(&pixels), &pitch);
-		if (result != 0)
+		if (Display.Mega)
 		{
-			SDL_Log("Failed to lock texture");
-			return OpcodeStatus::Error;
+			if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Read, Cpu.I, Display.Mega->SpriteWidth * Display.Mega->SpriteHeight);
+			Cpu.Registers[0xF] = DrawMegaSprite(Cpu.Registers[registerX_index], Cpu.Registers[registerY_index]) ? 0x1 : 0x0;
+			return OpcodeStatus::IncrementPC;
 		}
 
-		for (int y = 0; y < sprite_height; ++y)
+		const int width = Display.GetWidth();
+		const int height = Display.GetHeight();
+		uint8_t x_coord = Cpu.Registers[registerX_index] % width;
+		uint8_t y_coord = Cpu.Registers[registerY_index] % height;
+
+		// Dxy0 draws a 16x16 SUPER-CHIP sprite stored as two bytes per row.
+		// With several XO-CHIP planes selected, the sprite data for each plane follows the previous one.
+		const bool large_sprite = sprite_height == 0;
+		const int rows = large_sprite ? 16 : sprite_height;
+		const int bytes_per_row = large_sprite ? 2 : 1;
+		if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Read, Cpu.I, std::popcount(static_cast<uint8_t>(Display.SelectedPlanes & 0xF)) * rows * bytes_per_row);
+
+		Cpu.Registers[0xF] = 0x0;
+		uint32_t address = Cpu.I;
+		for (int plane = 0; plane < Framebuffer::MaxPlanes; ++plane)
 		{
-			if (y + y_coord >= height) break;
-			uint8_t row_byte = MemoryMapping[I + y];
-			for (int x = 0; x < 8; x++)
+			if (!(Display.SelectedPlanes & (1 << plane))) continue;
+			for (int y = 0; y < rows; ++y)
 			{
-				uint8_t pixel_color = (row_byte >> (7 - x)) & 0x1;
-				uint8_t color = 0;
-				if (pixel_color)
+				int row_index = y + y_coord;
+				if (row_index >= height)
 				{
-					color = 0xFF;
+					if constexpr (!Quirks::WrapSprites) break;
+					row_index -= height;
 				}
-				if (x + x_coord >= width) break;
-				int pixel_index = (x + x_coord) * 4 + pitch * (y + y_coord);
-				uint8_t existing_pixel = pixels[pixel_index];
-				color ^= existing_pixel;
-
-				if (existing_pixel != 0 && color != 0)
+				const uint16_t row_address = address + y * bytes_per_row;
+				uint16_t bits = static_cast<uint16_t>(MemoryMapping[row_address]) << 8;
+				if (large_sprite)
+					bits |= MemoryMapping[row_address + 1];
+				if (Display.DrawSpriteRow<Quirks::WrapSprites>(plane, x_coord, row_index, bits))
 				{
-					Registers[0xF] = 0x1;
+					Cpu.Registers[0xF] = 0x1;
 				}
-
-				pixels[pixel_index + 0] = color;
-				pixels[pixel_index + 1] = color;
-				pixels[pixel_index + 2] = color;
-				pixels[pixel_index + 3] = color;
 			}
+			address += rows * bytes_per_row;
 		}
 
-		SDL_UnlockTexture(Texture);
-
-		SDL_RenderCopy(Renderer, Texture, nullptr, nullptr);
-		SDL_RenderPresent(Renderer);
-
 		return OpcodeStatus::IncrementPC;
 	}
 
@@ -429,102 +635,146 @@ namespace chipotto
 		if ((opcode & 0xFF) == 0xA1)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "SKNP V" << (int)register_index;
-			const uint8_t* keys_state = SDL_GetKeyboardState(nullptr);
-			if (keys_state[KeyboardValuesMap[Registers[register_index]]] == 0)
+			if (((Cpu.Keys >> (Cpu.Registers[register_index] & 0xF)) & 0x1) == 0)
 			{
-				PC += 2;
+				SkipNextInstruction();
 			}
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0x9E)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "SKP V" << (int)register_index;
-			const uint8_t* keys_state = SDL_GetKeyboardState(nullptr);
-			if (keys_state[KeyboardValuesMap[Registers[register_index]]] == 1)
+			if (((Cpu.Keys >> (Cpu.Registers[register_index] & 0xF)) & 0x1) == 1)
 			{
-				PC += 2;
+				SkipNextInstruction();
 			}
 			return OpcodeStatus::IncrementPC;
 		}
 		return OpcodeStatus::NotImplemented;
 	}
 
+	template<typename Quirks>
 	OpcodeStatus Emulator::OpcodeF(const uint16_t opcode)
 	{
-		if ((opcode & 0xFF) == 0x55)
+		if (opcode == 0xF000)
+		{
+			const uint16_t address = (static_cast<uint16_t>(MemoryMapping[Cpu.PC + 2]) << 8) | MemoryMapping[Cpu.PC + 3];
+			Cpu.I = address;
+			Cpu.PC += 2;
+			return OpcodeStatus::IncrementPC;
+		}
+		else if (opcode == 0xF002)
+		{
+			if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Read, Cpu.I, static_cast<uint32_t>(AudioPattern.size()));
+			for (uint8_t i = 0; i < AudioPattern.size(); ++i)
+			{
+				AudioPattern[i] = MemoryMapping[Cpu.I + i];
+			}
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFF) == 0x01)
+		{
+			uint8_t planes = (opcode >> 8) & 0xF;
+			Display.SelectPlanes(planes);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFF) == 0x3A)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "LD [I], V" << (int)register_index;
-			for (uint8_t i = 0; i < register_index; ++i)
+			Pitch = Cpu.Registers[register_index];
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFF) == 0x55)
+		{
+			uint8_t register_index = (opcode >> 8) & 0xF;
+			if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Write, Cpu.I, register_index + 1);
+			for (uint8_t i = 0; i <= register_index; ++i)
 			{
-				MemoryMapping[I + i] = Registers[i];
+				MemoryMapping.Write(Cpu.I + i, Cpu.Registers[i]);
 			}
+			if constexpr (Quirks::LoadStoreIncrementsI) Cpu.I += register_index + 1;
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0x65)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "LD V" << (int)register_index << ", [I]";
-			for (uint8_t i = 0; i < register_index; ++i)
+			if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Read, Cpu.I, register_index + 1);
+			for (uint8_t i = 0; i <= register_index; ++i)
 			{
-				Registers[i] = MemoryMapping[I + 1];
+				Cpu.Registers[i] = MemoryMapping[Cpu.I + i];
 			}
+			if constexpr (Quirks::LoadStoreIncrementsI) Cpu.I += register_index + 1;
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0x33)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			uint8_t value = Registers[register_index];
-			MemoryMapping[I] = value / 100;
-			MemoryMapping[I + 1] = (value - (MemoryMapping[I] * 100)) / 10;
-			MemoryMapping[I + 2] = value % 10;
-			std::cout << "LD B, V" << (int)register_index;
+			uint8_t value = Cpu.Registers[register_index];
+			if (Watchpoints) [[unlikely]] Watchpoints->Check(MemoryAccess::Write, Cpu.I, 3);
+			MemoryMapping.Write(Cpu.I, value / 100);
+			MemoryMapping.Write(Cpu.I + 1, (value / 10) % 10);
+			MemoryMapping.Write(Cpu.I + 2, value % 10);
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0x29)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "LD F, V" << (int)register_index;
-			I = 5 * Registers[register_index];
+			Cpu.I = 5 * Cpu.Registers[register_index];
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFF) == 0x30)
+		{
+			uint8_t register_index = (opcode >> 8) & 0xF;
+			Cpu.I = MemoryImage::BigFontAddress + 10 * (Cpu.Registers[register_index] & 0xF);
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFF) == 0x75)
+		{
+			uint8_t register_index = (opcode >> 8) & 0xF;
+			for (uint8_t i = 0; i <= register_index; ++i)
+			{
+				Flags[i] = Cpu.Registers[i];
+			}
+			return OpcodeStatus::IncrementPC;
+		}
+		else if ((opcode & 0xFF) == 0x85)
+		{
+			uint8_t register_index = (opcode >> 8) & 0xF;
+			for (uint8_t i = 0; i <= register_index; ++i)
+			{
+				Cpu.Registers[i] = Flags[i];
+			}
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0x0A)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "LD V" << (int)register_index << ", K";
-			WaitForKeyboardRegister_Index = register_index;
-			Suspended = true;
+			Cpu.WaitForKeyboardRegister_Index = register_index;
+			Cpu.Suspended = true;
 			return OpcodeStatus::WaitForKeyboard;
 		}
 		else if ((opcode & 0xFF) == 0x1E)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "ADD I, V" << (int)register_index;
-			I += Registers[register_index];
+			Cpu.I += Cpu.Registers[register_index];
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0x18)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "LD ST, V" << (int)register_index;
-			SoundTimer = Registers[register_index];
+			Cpu.SoundTimer = Cpu.Registers[register_index];
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0x15)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "LD DT, V" << (int)register_index;
-			DelayTimer = Registers[register_index];
-			DeltaTimerTicks = 17 + SDL_GetTicks64();
+			Cpu.DelayTimer = Cpu.Registers[register_index];
 			return OpcodeStatus::IncrementPC;
 		}
 		else if ((opcode & 0xFF) == 0x07)
 		{
 			uint8_t register_index = (opcode >> 8) & 0xF;
-			std::cout << "LD V" << (int)register_index << ", DT";
-			Registers[register_index] = DelayTimer;
+			Cpu.Registers[register_index] = Cpu.DelayTimer;
 			return OpcodeStatus::IncrementPC;
 		}
 		else
@@ -532,5 +782,16 @@ namespace chipotto
 			return OpcodeStatus::NotImplemented;
 		}
 	}
-}
 
+#define CHIPOTTO_INSTANTIATE_QUIRKS(Quirks) \
+	template OpcodeStatus Emulator::Opcode8<Quirks>(const uint16_t opcode); \
+	template OpcodeStatus Emulator::OpcodeB<Quirks>(const uint16_t opcode); \
+	template OpcodeStatus Emulator::OpcodeD<Quirks>(const uint16_t opcode); \
+	template OpcodeStatus Emulator::OpcodeF<Quirks>(const uint16_t opcode);
+
+	CHIPOTTO_INSTANTIATE_QUIRKS(ChipottoQuirks)
+	CHIPOTTO_INSTANTIATE_QUIRKS(CosmacVipQuirks)
+	CHIPOTTO_INSTANTIATE_QUIRKS(SuperChipQuirks)
+	CHIPOTTO_INSTANTIATE_QUIRKS(XoChipQuirks)
+	CHIPOTTO_INSTANTIATE_QUIRKS(MegaChipQuirks)
+}
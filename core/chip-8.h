@@ -1,15 +1,16 @@
+#pragma once
+
 #include <array>
+#include <cmath>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
-#include <iostream>
-#include <functional>
-#include <unordered_map>
-#include "SDL.h"
-
-class SDL_Window;
-class SDL_Renderer;
-class SDL_Texture;
+#include <memory>
+#include <span>
+#include "framebuffer.h"
+#include "memory.h"
+#include "quirks.h"
+#include "random.h"
 
 namespace chipotto
 {
@@ -20,22 +21,109 @@ namespace chipotto
 		NotImplemented,
 		StackOverflow,
 		WaitForKeyboard,
+		Exit,
 		Error
 	};
 
+	// Everything the fetch/decode/execute loop touches on every instruction.
+	// Kept in a single cache line: 16 + 32 + 15 bytes, padded to 64. I is 32 bits wide for
+	// MEGA-CHIP's 24-bit addresses.
+	struct alignas(64) CpuState
+	{
+		std::array<uint8_t, 0x10> Registers{};
+		std::array<uint16_t, 0x10> Stack{};
+		uint32_t I = 0x0;
+		uint16_t PC = 0x200;
+		uint16_t Keys = 0x0;
+		uint8_t SP = 0xFF;
+		uint8_t DelayTimer = 0x0;
+		uint8_t SoundTimer = 0x0;
+		uint8_t WaitForKeyboardRegister_Index = 0;
+		bool Suspended = false;
+	};
+	static_assert(sizeof(CpuState) == 64, "CpuState must fit in one cache line");
+
+	// Watched memory ranges, defined in debugger.h.
+	struct MemoryWatchpoints;
+
+	// Full mutable state of an Emulator, for run-ahead, rollback and save states. Reuse one
+	// Snapshot for repeated captures: after the first, saving and loading don't allocate.
+	struct Snapshot
+	{
+		CpuState Cpu;
+		QuirkProfile Quirks = QuirkProfile::Chipotto;
+		Framebuffer Display;
+		std::array<uint8_t, 0x10> Flags{};
+		std::array<uint8_t, 0x10> AudioPattern{};
+		uint8_t Pitch = 64;
+		Random Rng;
+		MemorySnapshot Memory;
+
+		// The saved emulator's GetStateChecksum, without restoring it.
+		uint64_t GetChecksum() const;
+	};
+
+	// Headless interpreter core. The window, renderer and keyboard mapping live in the
+	// frontend (see app/frontend.h), so an Emulator is plain data that can be copied
+	// around and instantiated by the thousand.
+	//
+	// Memory is a copy-on-write view over a MemoryImage, so instances running the same ROM
+	// share its font and program pages and only own the 256-byte pages they write to.
+	//
+	// Per-instance budget (sizeof(Emulator)):
+	//   CpuState       64 bytes  (1 cache line)
+	//   Opcodes        8 bytes   (handler table specialised for the ROM's quirk profile)
+	//   MemoryMapping  40 bytes  (page table pointer, image reference, content hash, address mask)
+	//   Watchpoints    8 bytes   (debugger hook, null unless a watchpoint is set)
+	//   padding        8 bytes
+	//   Framebuffer    1088 bytes (plane 0 as 128x64 packed rows, extra plane and MEGA-CHIP screen pointers, pixel hash, mode)
+	//   Flags          16 bytes  (SUPER-CHIP RPL user flags)
+	//   AudioPattern   17 bytes  (XO-CHIP 128-bit sample pattern and pitch)
+	//   Rng            16 bytes  (Cxnn generator state, padded to 64)
+	//   total          1280 bytes
+	// plus 8 bytes of page table on the heap per 256 bytes of address space (128 for 4 KB,
+	// 2 KB for XO-CHIP's 64 KB), 256 bytes per page the program writes, and 3 KB for the
+	// extra bitplanes once an XO-CHIP program selects them, or 50 KB for the MEGA-CHIP screen.
 	class Emulator
 	{
 	public:
+		static constexpr uint32_t SizeBudget = 1280;
+
 		Emulator();
 		~Emulator() = default;
 		Emulator(const Emulator& other) = delete;
 		Emulator& operator=(const Emulator& other) = delete;
 		Emulator(Emulator&& other) = delete;
 
-		bool LoadFromFile(std::filesystem::path Path);
+		// A memory_size of 0 picks the smallest of 4 KB, 64 KB (XO-CHIP) and 16 MB (MEGA-CHIP) that fits the program.
+		bool LoadFromFile(std::filesystem::path Path, const uint32_t memory_size = 0);
+		bool LoadFromMemory(std::span<const uint8_t> program, uint32_t memory_size = 0);
+		void SetMemorySize(const uint32_t memory_size);
+		void LoadFromImage(std::shared_ptr<const MemoryImage> image);
+		void SetQuirks(const QuirkProfile profile);
+		// Cxnn draws from a per-instance generator, so the same seed and inputs replay the same run.
+		void SetSeed(const uint64_t seed) { Rng.Seed(seed); };
+		void SaveState(Snapshot& snapshot) const;
+		void LoadState(const Snapshot& snapshot);
+		// Hash of everything the program can observe (CPU, display, written memory). Two
+		// instances running the same ROM with the same inputs always agree on it. Memory and the
+		// bitplanes are covered by Zobrist hashes kept up to date as they are written, so this
+		// costs the same for 4 KB as for 16 MB, apart from the MEGA-CHIP screen.
+		uint64_t GetStateChecksum() const;
 		bool Tick();
+		bool RunFrame(const uint32_t instructions, const bool skip_idle = false);
+		void TickTimers();
 
-		bool IsValid() const;
+		void KeyDown(const uint8_t key);
+		void KeyUp(const uint8_t key);
+		// Presses and releases keys to match the mask, so a newly pressed key ends an Fx0A wait
+		// as KeyDown does.
+		void SetKeys(const uint16_t keys);
+		// For cheats and debuggers; programs write through the handlers.
+		void WriteMemory(const uint32_t address, const uint8_t value) { MemoryMapping.Write(address, value); };
+		// The handlers that read or write memory through I (5xy2, 5xy3, Dxyn, F002, Fx33, Fx55,
+		// Fx65 and MEGA-CHIP's 02nn) report their accesses to watchpoints while it is set.
+		void SetWatchpoints(MemoryWatchpoints* watchpoints) { Watchpoints = watchpoints; };
 
 		OpcodeStatus Opcode0(const uint16_t opcode);
 		OpcodeStatus Opcode1(const uint16_t opcode);
@@ -45,53 +133,65 @@ namespace chipotto
 		OpcodeStatus Opcode5(const uint16_t opcode);
 		OpcodeStatus Opcode6(const uint16_t opcode);
 		OpcodeStatus Opcode7(const uint16_t opcode);
+		template<typename Quirks = ChipottoQuirks>
 		OpcodeStatus Opcode8(const uint16_t opcode);
 		OpcodeStatus Opcode9(const uint16_t opcode);
 		OpcodeStatus OpcodeA(const uint16_t opcode);
+		template<typename Quirks = ChipottoQuirks>
 		OpcodeStatus OpcodeB(const uint16_t opcode);
 		OpcodeStatus OpcodeC(const uint16_t opcode);
+		template<typename Quirks = ChipottoQuirks>
 		OpcodeStatus OpcodeD(const uint16_t opcode);
 		OpcodeStatus OpcodeE(const uint16_t opcode);
+		template<typename Quirks = ChipottoQuirks>
 		OpcodeStatus OpcodeF(const uint16_t opcode);
+		OpcodeStatus OpcodeMega(const uint16_t opcode);
 
-		std::array<uint8_t, 0x1000> GetMemoryMapping() const { return MemoryMapping; };
-		std::array<uint8_t, 0x10> GetRegisters() const { return Registers; };
-		std::array<uint16_t, 0x10>& GetStack() { return Stack; };
-		uint16_t GetI() { return I; };
-		uint16_t GetPC() const { return PC; };
-		uint8_t GetSP() const { return SP; };
-		int GetHeight() const { return height; };
-		int GetWidth() const { return width; };
-		SDL_Texture* GetTexture() const { return Texture; };
-		uint8_t GetDelayTimer() const { return DelayTimer; };
-		bool GetSuspended() const { return Suspended; };
-		uint8_t GetWaitForKeyboardRegister_Index() const { return WaitForKeyboardRegister_Index; }
-		uint64_t GetDeltaTimerTicks() const { return DeltaTimerTicks; };
-		uint8_t GetSoundTimer() const { return SoundTimer; };
+		const PagedMemory& GetMemoryMapping() const { return MemoryMapping; };
+		const CpuState& GetCpuState() const { return Cpu; };
+		// Direct access for code outside the interpreter loop, such as recompiled blocks.
+		CpuState& GetCpuState() { return Cpu; };
+		const std::array<uint8_t, 0x10>& GetRegisters() const { return Cpu.Registers; };
+		std::array<uint16_t, 0x10>& GetStack() { return Cpu.Stack; };
+		const Framebuffer& GetFramebuffer() const { return Display; };
+		uint32_t GetI() { return Cpu.I; };
+		uint16_t GetPC() const { return Cpu.PC; };
+		uint8_t GetSP() const { return Cpu.SP; };
+		int GetHeight() const { return Display.GetHeight(); };
+		int GetWidth() const { return Display.GetWidth(); };
+		const std::array<uint8_t, 0x10>& GetFlags() const { return Flags; };
+		const std::array<uint8_t, 0x10>& GetAudioPattern() const { return AudioPattern; };
+		uint8_t GetPitch() const { return Pitch; };
+		// XO-CHIP pattern playback rate in bits per second.
+		double GetAudioPlaybackRate() const { return 4000.0 * std::pow(2.0, (Pitch - 64) / 48.0); };
+		uint8_t GetDelayTimer() const { return Cpu.DelayTimer; };
+		bool GetSuspended() const { return Cpu.Suspended; };
+		uint8_t GetWaitForKeyboardRegister_Index() const { return Cpu.WaitForKeyboardRegister_Index; }
+		uint8_t GetSoundTimer() const { return Cpu.SoundTimer; };
+		uint16_t GetKeys() const { return Cpu.Keys; };
+		QuirkProfile GetQuirks() const;
+		uint64_t GetProgramHash() const { return MemoryMapping.GetImage()->GetHash(); };
+		const Random& GetRandom() const { return Rng; };
 	private:
-		std::array<uint8_t, 0x1000> MemoryMapping;
-		std::array<uint8_t, 0x10> Registers;
-		std::array<uint16_t, 0x10> Stack;
-		std::array<std::function<OpcodeStatus(const uint16_t)>, 0x10> Opcodes;
+		void SkipNextInstruction();
+		bool DrawMegaSprite(const int x, const int y);
 
-		std::unordered_map<SDL_Keycode, uint8_t> KeyboardMap;
-		std::array<SDL_Scancode, 0x10> KeyboardValuesMap;
+		using OpcodeHandler = OpcodeStatus(Emulator::*)(const uint16_t);
+		using OpcodeTable = std::array<OpcodeHandler, 0x10>;
+		template<typename Quirks>
+		static const OpcodeTable QuirkOpcodes;
 
-		uint16_t I = 0x0;
-		uint8_t DelayTimer = 0x0;
-		uint8_t SoundTimer = 0x0;
-		uint16_t PC = 0x200;
-		uint8_t SP = 0xFF;
-
-		bool Suspended = false;
-		uint8_t WaitForKeyboardRegister_Index = 0;
-		uint64_t DeltaTimerTicks = 0;
-
-		SDL_Window* Window = nullptr;
-		SDL_Renderer* Renderer = nullptr;
-		SDL_Texture* Texture = nullptr;
-		int width = 64;
-		int height = 32;
+		CpuState Cpu;
+		// Second cache line: the handler table picked at load time, the page table view and the
+		// debugger hook.
+		alignas(64) const OpcodeTable* Opcodes;
+		PagedMemory MemoryMapping;
+		MemoryWatchpoints* Watchpoints = nullptr;
+		Framebuffer Display;
+		std::array<uint8_t, 0x10> Flags{};
+		std::array<uint8_t, 0x10> AudioPattern = { 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0 };
+		uint8_t Pitch = 64;
+		Random Rng;
 	};
+	static_assert(sizeof(Emulator) <= Emulator::SizeBudget, "Emulator grew past its per-instance budget");
 }
-
@@ -0,0 +1,202 @@
+#include "debugger.h"
+#include <algorithm>
+
+namespace chipotto
+{
+	void MemoryWatchpoints::Check(const MemoryAccess access, const uint32_t address, const uint32_t length)
+	{
+		if (Hit) return;
+		for (const Range& range : Ranges)
+		{
+			if (!(static_cast<uint8_t>(range.Access) & static_cast<uint8_t>(access))) continue;
+			const uint32_t first = std::max(address, range.Start);
+			if (first < range.End && first < address + length)
+			{
+				Hit = true;
+				HitAccess = access;
+				HitAddress = first;
+				return;
+			}
+		}
+	}
+
+	void Debugger::SetBreakpoint(const uint16_t address)
+	{
+		if (HasBreakpoint(address)) return;
+		Breakpoints[address >> 6] |= 1ULL << (address & 63);
+		BreakpointCount++;
+	}
+
+	void Debugger::ClearBreakpoint(const uint16_t address)
+	{
+		if (!HasBreakpoint(address)) return;
+		Breakpoints[address >> 6] &= ~(1ULL << (address & 63));
+		BreakpointCount--;
+	}
+
+	void Debugger::ClearBreakpoints()
+	{
+		Breakpoints.fill(0);
+		BreakpointCount = 0;
+	}
+
+	void Debugger::AddWatchpoint(const uint32_t address, const uint32_t length, const MemoryAccess access)
+	{
+		if (length == 0) return;
+		Watchpoints.Ranges.push_back({ address, address + length, access });
+	}
+
+	void Debugger::BreakOnRegisterChange(const uint8_t register_index)
+	{
+		ChangeMask |= 1 << (register_index & 0xF);
+		ValueMask &= ~(1 << (register_index & 0xF));
+	}
+
+	void Debugger::BreakOnRegisterValue(const uint8_t register_index, const uint8_t value)
+	{
+		ChangeMask |= 1 << (register_index & 0xF);
+		ValueMask |= 1 << (register_index & 0xF);
+		Values[register_index & 0xF] = value;
+	}
+
+	void Debugger::ClearRegisterConditions()
+	{
+		ChangeMask = 0;
+		ValueMask = 0;
+	}
+
+	// Whether the instruction after opcode may not be the one that follows it in memory (jumps,
+	// calls, returns, skips, key waits), or opcode may have rewritten it (5xy2, Fx33, Fx55).
+	// MEGA-CHIP's 01nn is only four bytes long in MEGA-CHIP mode, so it ends blocks too.
+	static bool EndsBlock(const uint16_t opcode)
+	{
+		switch (opcode >> 12)
+		{
+		case 0x0:
+			return opcode == 0x00EE || opcode == 0x00FD || (opcode >> 8) == 0x01;
+		case 0x1:
+		case 0x2:
+		case 0x3:
+		case 0x4:
+		case 0x9:
+		case 0xB:
+		case 0xE:
+			return true;
+		case 0x5:
+			return (opcode & 0xF) != 0x3;
+		case 0xF:
+			return (opcode & 0xFF) == 0x0A || (opcode & 0xFF) == 0x33 || (opcode & 0xFF) == 0x55;
+		default:
+			return false;
+		}
+	}
+
+	uint32_t Debugger::ScanBlock(const PagedMemory& memory, const uint16_t pc, const uint32_t limit, uint16_t& end) const
+	{
+		uint32_t count = 0;
+		uint16_t address = pc;
+		while (count < limit)
+		{
+			const uint16_t opcode = memory[address + 1] + (static_cast<uint16_t>(memory[address]) << 8);
+			count++;
+			address += opcode == 0xF000 ? 4 : 2;
+			if (EndsBlock(opcode)) break;
+		}
+		end = address;
+		return count;
+	}
+
+	bool Debugger::HasBreakpointIn(const uint16_t start, const uint16_t end) const
+	{
+		// A word of the bitmap at a time; the range may wrap around the end of the address space.
+		uint16_t address = start;
+		while (address != end)
+		{
+			const uint32_t word = address >> 6;
+			const uint32_t bit = address & 63;
+			const uint32_t count = end > address && (end >> 6) == word ? end - address : 64 - bit;
+			const uint64_t mask = (count == 64 ? ~0ULL : (1ULL << count) - 1) << bit;
+			if (Breakpoints[word] & mask) return true;
+			address = static_cast<uint16_t>(address + count);
+		}
+		return false;
+	}
+
+	bool Debugger::CheckRegisters(const std::array<uint8_t, 0x10>& before, const std::array<uint8_t, 0x10>& after, DebugStop& stop) const
+	{
+		for (uint8_t index = 0; index < 0x10; ++index)
+		{
+			if (!((ChangeMask >> index) & 0x1) || before[index] == after[index]) continue;
+			if (((ValueMask >> index) & 0x1) && after[index] != Values[index]) continue;
+			stop.Reason = StopReason::RegisterCondition;
+			stop.Register = index;
+			stop.Value = after[index];
+			return true;
+		}
+		return false;
+	}
+
+	DebugStop Debugger::Run(Emulator& emulator, const uint32_t instructions)
+	{
+		DebugStop stop;
+		const bool watching = !Watchpoints.Ranges.empty();
+		if (BreakpointCount == 0 && !watching && ChangeMask == 0)
+		{
+			while (stop.Executed < instructions && !emulator.GetSuspended())
+			{
+				stop.Executed++;
+				if (!emulator.Tick())
+				{
+					stop.Reason = StopReason::Halted;
+					break;
+				}
+			}
+			return stop;
+		}
+
+		emulator.SetWatchpoints(watching ? &Watchpoints : nullptr);
+		Watchpoints.Hit = false;
+		bool resuming = true;
+		while (stop.Reason == StopReason::None && stop.Executed < instructions && !emulator.GetSuspended())
+		{
+			const uint16_t pc = emulator.GetPC();
+			// Without breakpoints there are no blocks to look into: run everything that's left.
+			uint32_t count = instructions - stop.Executed;
+			bool check_breakpoints = false;
+			if (BreakpointCount)
+			{
+				uint16_t end = pc;
+				count = ScanBlock(emulator.GetMemoryMapping(), pc, count, end);
+				check_breakpoints = HasBreakpointIn(resuming ? static_cast<uint16_t>(pc + 1) : pc, end);
+			}
+
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (check_breakpoints && !resuming && HasBreakpoint(emulator.GetPC()))
+				{
+					stop.Reason = StopReason::Breakpoint;
+					break;
+				}
+				resuming = false;
+				const std::array<uint8_t, 0x10> before = emulator.GetRegisters();
+				stop.Executed++;
+				if (!emulator.Tick())
+				{
+					stop.Reason = StopReason::Halted;
+					break;
+				}
+				if (Watchpoints.Hit)
+				{
+					stop.Reason = StopReason::Watchpoint;
+					stop.Access = Watchpoints.HitAccess;
+					stop.Address = Watchpoints.HitAddress;
+					break;
+				}
+				if (ChangeMask && CheckRegisters(before, emulator.GetRegisters(), stop)) break;
+				if (emulator.GetSuspended()) break;
+			}
+		}
+		emulator.SetWatchpoints(nullptr);
+		return stop;
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "chip-8.h"
+
+namespace chipotto
+{
+	enum class MemoryAccess : uint8_t
+	{
+		Read = 0x1,
+		Write = 0x2,
+		ReadWrite = 0x3
+	};
+
+	// Address ranges the memory handlers check their accesses against while an Emulator points
+	// at them (see Emulator::SetWatchpoints). Addresses are I-relative as the handlers compute
+	// them, before the address space wraps.
+	struct MemoryWatchpoints
+	{
+		struct Range
+		{
+			uint32_t Start = 0;
+			// One past the last watched address.
+			uint32_t End = 0;
+			MemoryAccess Access = MemoryAccess::ReadWrite;
+		};
+
+		std::vector<Range> Ranges;
+		// The first watched access since Hit was last cleared.
+		bool Hit = false;
+		MemoryAccess HitAccess = MemoryAccess::Read;
+		uint32_t HitAddress = 0;
+
+		void Check(const MemoryAccess access, const uint32_t address, const uint32_t length);
+	};
+
+	enum class StopReason : uint8_t
+	{
+		// Ran every instruction asked for, or the program is waiting for a key.
+		None,
+		// About to run an instruction with a breakpoint.
+		Breakpoint,
+		// The last instruction touched a watched address.
+		Watchpoint,
+		// The last instruction changed a watched register.
+		RegisterCondition,
+		// The last instruction was invalid, overflowed the stack or exited (Tick returned false).
+		Halted
+	};
+
+	struct DebugStop
+	{
+		StopReason Reason = StopReason::None;
+		uint32_t Executed = 0;
+		// Watchpoint: the first watched address touched and how.
+		MemoryAccess Access = MemoryAccess::Read;
+		uint32_t Address = 0;
+		// RegisterCondition: the register and its new value.
+		uint8_t Register = 0;
+		uint8_t Value = 0;
+	};
+
+	// PC breakpoints, memory watchpoints and register conditions for an Emulator. With none of
+	// them set, Run is the interpreter loop and nothing else.
+	//
+	// Breakpoints are a bitmap over the 16-bit PC. Run executes a straight-line block of
+	// instructions at a time and only looks at the bitmap when entering one, testing the whole
+	// block's address range at once. Blocks end at anything that can change control flow and
+	// at memory writes, which could rewrite the rest of the block, so every instruction a block
+	// runs is one the range test covered.
+	//
+	// Watchpoints are checked by the memory handlers themselves, so running with them costs
+	// the handlers a pointer test and the loop a flag test per instruction. Register conditions
+	// compare the registers after every instruction.
+	class Debugger
+	{
+	public:
+		static constexpr uint32_t AddressSpace = 0x10000;
+
+		void SetBreakpoint(const uint16_t address);
+		void ClearBreakpoint(const uint16_t address);
+		bool HasBreakpoint(const uint16_t address) const { return (Breakpoints[address >> 6] >> (address & 63)) & 0x1; };
+		void ClearBreakpoints();
+
+		void AddWatchpoint(const uint32_t address, const uint32_t length, const MemoryAccess access);
+		void ClearWatchpoints() { Watchpoints.Ranges.clear(); };
+
+		// Stops after an instruction that changes Vx, or only when it changes Vx to value.
+		void BreakOnRegisterChange(const uint8_t register_index);
+		void BreakOnRegisterValue(const uint8_t register_index, const uint8_t value);
+		void ClearRegisterConditions();
+
+		// Runs up to instructions instructions like Emulator::RunFrame without idle skipping,
+		// but leaves the timers alone so a frame can be resumed after a stop. The breakpoint at
+		// the current PC, if any, is passed over: Run continues from a breakpoint stop.
+		DebugStop Run(Emulator& emulator, const uint32_t instructions);
+
+	private:
+		// Number of instructions from pc up to and including the one that ends its block, at
+		// most limit; end is the address after them.
+		uint32_t ScanBlock(const PagedMemory& memory, const uint16_t pc, const uint32_t limit, uint16_t& end) const;
+		bool HasBreakpointIn(const uint16_t start, const uint16_t end) const;
+		bool CheckRegisters(const std::array<uint8_t, 0x10>& before, const std::array<uint8_t, 0x10>& after, DebugStop& stop) const;
+
+		std::array<uint64_t, AddressSpace / 64> Breakpoints{};
+		uint32_t BreakpointCount = 0;
+		MemoryWatchpoints Watchpoints;
+		uint16_t ChangeMask = 0;
+		// Registers whose condition is a value rather than any change.
+		uint16_t ValueMask = 0;
+		std::array<uint8_t, 0x10> Values{};
+	};
+}
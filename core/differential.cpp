@@ -0,0 +1,402 @@
+#include "differential.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+namespace chipotto
+{
+	// Opcode shapes the generator draws from: Pattern with the bits in RandomBits randomised.
+	// Jumps and calls get a target inside the program instead of random address bits, and
+	// long instructions are followed by a random operand word.
+	enum class OperandKind : uint8_t
+	{
+		None,
+		Target,
+		LongWord
+	};
+
+	struct OpcodeShape
+	{
+		uint16_t Pattern;
+		uint16_t RandomBits;
+		OperandKind Operand;
+	};
+
+	static constexpr OpcodeShape CommonShapes[] = {
+		{ 0x00E0, 0x0000, OperandKind::None }, { 0x00EE, 0x0000, OperandKind::None },
+		{ 0x00B0, 0x000F, OperandKind::None }, { 0x00C0, 0x000F, OperandKind::None }, { 0x00D0, 0x000F, OperandKind::None },
+		{ 0x00FB, 0x0000, OperandKind::None }, { 0x00FC, 0x0000, OperandKind::None },
+		{ 0x00FE, 0x0000, OperandKind::None }, { 0x00FF, 0x0000, OperandKind::None },
+		{ 0x1000, 0x0000, OperandKind::Target }, { 0x2000, 0x0000, OperandKind::Target },
+		{ 0x3000, 0x0FFF, OperandKind::None }, { 0x4000, 0x0FFF, OperandKind::None },
+		{ 0x5000, 0x0FF0, OperandKind::None }, { 0x5002, 0x0FF0, OperandKind::None }, { 0x5003, 0x0FF0, OperandKind::None },
+		{ 0x6000, 0x0FFF, OperandKind::None }, { 0x7000, 0x0FFF, OperandKind::None },
+		{ 0x8000, 0x0FF0, OperandKind::None }, { 0x8001, 0x0FF0, OperandKind::None }, { 0x8002, 0x0FF0, OperandKind::None },
+		{ 0x8003, 0x0FF0, OperandKind::None }, { 0x8004, 0x0FF0, OperandKind::None }, { 0x8005, 0x0FF0, OperandKind::None },
+		{ 0x8006, 0x0FF0, OperandKind::None }, { 0x8007, 0x0FF0, OperandKind::None }, { 0x800E, 0x0FF0, OperandKind::None },
+		{ 0x9000, 0x0FF0, OperandKind::None }, { 0xA000, 0x0FFF, OperandKind::None }, { 0xB000, 0x0000, OperandKind::Target },
+		{ 0xC000, 0x0FFF, OperandKind::None }, { 0xD000, 0x0FFF, OperandKind::None },
+		{ 0xE09E, 0x0F00, OperandKind::None }, { 0xE0A1, 0x0F00, OperandKind::None },
+		{ 0xF000, 0x0000, OperandKind::LongWord }, { 0xF001, 0x0F00, OperandKind::None }, { 0xF002, 0x0000, OperandKind::None },
+		{ 0xF007, 0x0F00, OperandKind::None }, { 0xF00A, 0x0F00, OperandKind::None }, { 0xF015, 0x0F00, OperandKind::None },
+		{ 0xF018, 0x0F00, OperandKind::None }, { 0xF01E, 0x0F00, OperandKind::None }, { 0xF029, 0x0F00, OperandKind::None },
+		{ 0xF030, 0x0F00, OperandKind::None }, { 0xF033, 0x0F00, OperandKind::None }, { 0xF03A, 0x0F00, OperandKind::None },
+		{ 0xF055, 0x0F00, OperandKind::None }, { 0xF065, 0x0F00, OperandKind::None }, { 0xF075, 0x0F00, OperandKind::None },
+		{ 0xF085, 0x0F00, OperandKind::None }
+	};
+
+	static constexpr OpcodeShape MegaShapes[] = {
+		{ 0x0010, 0x0000, OperandKind::None }, { 0x0011, 0x0000, OperandKind::None },
+		{ 0x0100, 0x00FF, OperandKind::LongWord }, { 0x0200, 0x000F, OperandKind::None }, { 0x0300, 0x00FF, OperandKind::None },
+		{ 0x0400, 0x00FF, OperandKind::None }, { 0x0500, 0x00FF, OperandKind::None }, { 0x0800, 0x0007, OperandKind::None },
+		{ 0x0900, 0x00FF, OperandKind::None }
+	};
+
+	// XO-CHIP and MEGA-CHIP programs get 64 KB. MEGA-CHIP ROMs too large for that get the
+	// full 16 MB from LoadFromMemory, but random programs don't: comparing states walks the
+	// whole page table, which at 16 MB costs more than running the instructions.
+	static uint32_t GetMemorySize(const QuirkProfile quirks, const size_t program_size)
+	{
+		const uint32_t size = quirks == QuirkProfile::XoChip || quirks == QuirkProfile::MegaChip ? MemoryImage::ExtendedSize : MemoryImage::DefaultSize;
+		return program_size <= size - MemoryImage::ProgramAddress ? size : 0;
+	}
+
+	std::vector<uint8_t> GenerateRandomProgram(const uint64_t seed, const uint32_t instructions, const QuirkProfile quirks)
+	{
+		constexpr size_t common_count = std::size(CommonShapes);
+		const size_t shape_count = common_count + (quirks == QuirkProfile::MegaChip ? std::size(MegaShapes) : 0);
+		Random random(seed);
+		std::vector<uint8_t> program;
+		program.reserve(instructions * 2);
+		for (uint32_t index = 0; index < instructions; ++index)
+		{
+			const size_t pick = random.Next() % shape_count;
+			const OpcodeShape& shape = pick < common_count ? CommonShapes[pick] : MegaShapes[pick - common_count];
+			uint16_t opcode = shape.Pattern | (static_cast<uint16_t>(random.Next()) & shape.RandomBits);
+			if (shape.Operand == OperandKind::Target)
+			{
+				opcode |= (MemoryImage::ProgramAddress + 2 * (random.Next() % instructions)) & 0x0FFF;
+			}
+			program.push_back(static_cast<uint8_t>(opcode >> 8));
+			program.push_back(static_cast<uint8_t>(opcode));
+			if (shape.Operand == OperandKind::LongWord)
+			{
+				const uint16_t operand = static_cast<uint16_t>(random.Next());
+				program.push_back(static_cast<uint8_t>(operand >> 8));
+				program.push_back(static_cast<uint8_t>(operand));
+			}
+		}
+		return program;
+	}
+
+	static bool Differs(std::string& difference, const char* name, const uint32_t expected, const uint32_t actual)
+	{
+		if (expected == actual) return false;
+		char text[96];
+		std::snprintf(text, sizeof(text), "%s: 0x%02X != 0x%02X", name, expected, actual);
+		difference = text;
+		return true;
+	}
+
+	// State GetStateChecksum leaves out: the display mode, MEGA-CHIP drawing settings, audio
+	// and the quirk profile.
+	static bool SameUnhashedState(const Emulator& expected, const Emulator& actual)
+	{
+		const Framebuffer& expected_display = expected.GetFramebuffer();
+		const Framebuffer& actual_display = actual.GetFramebuffer();
+		if (expected_display.HighResolution != actual_display.HighResolution || expected_display.SelectedPlanes != actual_display.SelectedPlanes) return false;
+		if ((expected_display.Mega != nullptr) != (actual_display.Mega != nullptr)) return false;
+		if (expected_display.Mega)
+		{
+			const MegaScreen& expected_screen = *expected_display.Mega;
+			const MegaScreen& actual_screen = *actual_display.Mega;
+			if (expected_screen.Palette != actual_screen.Palette || expected_screen.SpriteWidth != actual_screen.SpriteWidth ||
+				expected_screen.SpriteHeight != actual_screen.SpriteHeight || expected_screen.CollisionIndex != actual_screen.CollisionIndex ||
+				expected_screen.Alpha != actual_screen.Alpha || expected_screen.Blend != actual_screen.Blend) return false;
+		}
+		return expected.GetAudioPattern() == actual.GetAudioPattern() && expected.GetPitch() == actual.GetPitch() && expected.GetQuirks() == actual.GetQuirks();
+	}
+
+	static bool SameState(const Emulator& expected, const Emulator& actual)
+	{
+		return SameUnhashedState(expected, actual) && expected.GetStateChecksum() == actual.GetStateChecksum();
+	}
+
+	// Names the first part of two states that differs. Only called once SameState has failed,
+	// so it can afford to walk memory.
+	static std::string DescribeDifference(const Emulator& expected, const Emulator& actual)
+	{
+		std::string difference;
+		const CpuState& a = expected.GetCpuState();
+		const CpuState& b = actual.GetCpuState();
+		char name[32];
+		if (Differs(difference, "PC", a.PC, b.PC)) return difference;
+		for (int index = 0; index < 0x10; ++index)
+		{
+			std::snprintf(name, sizeof(name), "V%X", index);
+			if (Differs(difference, name, a.Registers[index], b.Registers[index])) return difference;
+		}
+		if (Differs(difference, "I", a.I, b.I)) return difference;
+		if (Differs(difference, "SP", a.SP, b.SP)) return difference;
+		for (int index = 0; index < 0x10; ++index)
+		{
+			std::snprintf(name, sizeof(name), "stack[%d]", index);
+			if (Differs(difference, name, a.Stack[index], b.Stack[index])) return difference;
+		}
+		if (Differs(difference, "delay timer", a.DelayTimer, b.DelayTimer)) return difference;
+		if (Differs(difference, "sound timer", a.SoundTimer, b.SoundTimer)) return difference;
+		if (Differs(difference, "keys", a.Keys, b.Keys)) return difference;
+		if (Differs(difference, "suspended", a.Suspended, b.Suspended)) return difference;
+		if (Differs(difference, "key register", a.WaitForKeyboardRegister_Index, b.WaitForKeyboardRegister_Index)) return difference;
+		for (size_t index = 0; index < 4; ++index)
+		{
+			std::snprintf(name, sizeof(name), "rng[%zu]", index);
+			if (Differs(difference, name, expected.GetRandom().GetState()[index], actual.GetRandom().GetState()[index])) return difference;
+		}
+		if (Differs(difference, "quirks", static_cast<uint32_t>(expected.GetQuirks()), static_cast<uint32_t>(actual.GetQuirks()))) return difference;
+
+		const Framebuffer& expected_display = expected.GetFramebuffer();
+		const Framebuffer& actual_display = actual.GetFramebuffer();
+		if (Differs(difference, "high resolution", expected_display.HighResolution, actual_display.HighResolution)) return difference;
+		if (Differs(difference, "selected planes", expected_display.SelectedPlanes, actual_display.SelectedPlanes)) return difference;
+		if (Differs(difference, "extra planes", expected_display.HasExtraPlanes(), actual_display.HasExtraPlanes())) return difference;
+		const int planes = expected_display.HasExtraPlanes() ? Framebuffer::MaxPlanes : 1;
+		for (int plane = 0; plane < planes; ++plane)
+		{
+			for (int y = 0; y < Framebuffer::MaxHeight; ++y)
+			{
+				if (expected_display.GetPlane(plane)[y] == actual_display.GetPlane(plane)[y]) continue;
+				std::snprintf(name, sizeof(name), "plane %d row %d", plane, y);
+				difference = name;
+				return difference;
+			}
+		}
+		if (Differs(difference, "MEGA-CHIP mode", expected_display.Mega != nullptr, actual_display.Mega != nullptr)) return difference;
+		if (expected_display.Mega)
+		{
+			const MegaScreen& expected_screen = *expected_display.Mega;
+			const MegaScreen& actual_screen = *actual_display.Mega;
+			if (Differs(difference, "sprite width", expected_screen.SpriteWidth, actual_screen.SpriteWidth)) return difference;
+			if (Differs(difference, "sprite height", expected_screen.SpriteHeight, actual_screen.SpriteHeight)) return difference;
+			if (Differs(difference, "collision index", expected_screen.CollisionIndex, actual_screen.CollisionIndex)) return difference;
+			if (Differs(difference, "alpha", expected_screen.Alpha, actual_screen.Alpha)) return difference;
+			if (Differs(difference, "blend mode", static_cast<uint32_t>(expected_screen.Blend), static_cast<uint32_t>(actual_screen.Blend))) return difference;
+			for (size_t index = 0; index < expected_screen.Palette.size(); ++index)
+			{
+				std::snprintf(name, sizeof(name), "palette[%zu]", index);
+				if (Differs(difference, name, expected_screen.Palette[index], actual_screen.Palette[index])) return difference;
+			}
+			for (size_t index = 0; index < expected_screen.Pixels.size(); ++index)
+			{
+				std::snprintf(name, sizeof(name), "pixel (%zu, %zu)", index % MegaScreen::Width, index / MegaScreen::Width);
+				if (Differs(difference, name, expected_screen.Pixels[index], actual_screen.Pixels[index])) return difference;
+			}
+		}
+		for (int index = 0; index < 0x10; ++index)
+		{
+			std::snprintf(name, sizeof(name), "flag[%d]", index);
+			if (Differs(difference, name, expected.GetFlags()[index], actual.GetFlags()[index])) return difference;
+			std::snprintf(name, sizeof(name), "audio pattern[%d]", index);
+			if (Differs(difference, name, expected.GetAudioPattern()[index], actual.GetAudioPattern()[index])) return difference;
+		}
+		if (Differs(difference, "pitch", expected.GetPitch(), actual.GetPitch())) return difference;
+
+		const PagedMemory& expected_memory = expected.GetMemoryMapping();
+		const PagedMemory& actual_memory = actual.GetMemoryMapping();
+		if (Differs(difference, "memory size", expected_memory.GetSize(), actual_memory.GetSize())) return difference;
+		std::array<uint8_t, MemoryPage::Size> expected_page;
+		std::array<uint8_t, MemoryPage::Size> actual_page;
+		for (uint32_t page = 0; page < expected_memory.GetSize() >> MemoryPage::Shift; ++page)
+		{
+			if (!expected_memory.IsPrivatePage(page) && !actual_memory.IsPrivatePage(page)) continue;
+			expected_memory.ReadBlock(page << MemoryPage::Shift, expected_page);
+			actual_memory.ReadBlock(page << MemoryPage::Shift, actual_page);
+			for (uint32_t offset = 0; offset < MemoryPage::Size; ++offset)
+			{
+				std::snprintf(name, sizeof(name), "memory[0x%06X]", (page << MemoryPage::Shift) + offset);
+				if (Differs(difference, name, expected_page[offset], actual_page[offset])) return difference;
+			}
+		}
+		return "state checksum";
+	}
+
+	struct LockstepResult
+	{
+		bool Diverged = false;
+		// Steps run, including the one the states differed after.
+		uint32_t Steps = 0;
+		std::string Difference;
+	};
+
+	static LockstepResult RunLockstep(const DifferentialEngine& engine, std::span<const uint8_t> program, const DifferentialOptions& options, const uint64_t seed, const bool describe)
+	{
+		LockstepResult result;
+		Emulator reference;
+		Emulator candidate;
+		if (!reference.LoadFromMemory(program, GetMemorySize(options.Quirks, program.size()))) return result;
+		// Both run the same ROM image, so their checksums share its hash.
+		candidate.LoadFromImage(reference.GetMemoryMapping().GetImage());
+		reference.SetQuirks(options.Quirks);
+		candidate.SetQuirks(options.Quirks);
+		reference.SetSeed(seed);
+		candidate.SetSeed(seed);
+
+		// Key presses come from their own generator so they don't depend on the program's Cxnn.
+		Random keys(~seed);
+		for (uint32_t step = 0; step < options.Steps; ++step)
+		{
+			if (reference.GetSuspended())
+			{
+				const uint8_t key = keys.NextByte() & 0xF;
+				reference.KeyDown(key);
+				candidate.KeyDown(key);
+			}
+			else
+			{
+				// Sparse key masks, so both skip directions of Ex9E/ExA1 get taken.
+				const uint16_t pressed = static_cast<uint16_t>(keys.Next() & keys.Next() & keys.Next());
+				reference.SetKeys(pressed);
+				candidate.SetKeys(pressed);
+			}
+
+			const bool reference_running = reference.RunFrame(options.InstructionsPerStep);
+			const bool candidate_running = engine.RunFrame(candidate, options.InstructionsPerStep);
+			result.Steps = step + 1;
+			if (reference_running != candidate_running || !SameState(reference, candidate))
+			{
+				result.Diverged = true;
+				if (describe)
+				{
+					result.Difference = reference_running != candidate_running ? (reference_running ? "candidate stopped" : "candidate kept running") : DescribeDifference(reference, candidate);
+				}
+				return result;
+			}
+			if (!reference_running) break;
+		}
+		return result;
+	}
+
+	// Greedy delta debugging over instruction words: drop ever smaller runs of words for as
+	// long as the program still fails. Removing words shifts jump targets, which is fine: any
+	// smaller failing program will do.
+	static std::vector<uint8_t> ShrinkProgram(const DifferentialEngine& engine, std::vector<uint8_t> program, const DifferentialOptions& options, const uint64_t seed)
+	{
+		constexpr uint32_t MaxRuns = 4096;
+		uint32_t runs = 0;
+		bool shrunk = true;
+		while (shrunk && runs < MaxRuns)
+		{
+			shrunk = false;
+			for (size_t chunk = std::max<size_t>(1, program.size() / 4); chunk > 0 && runs < MaxRuns; chunk /= 2)
+			{
+				const size_t chunk_bytes = chunk * 2;
+				for (size_t start = 0; start < program.size() && runs < MaxRuns;)
+				{
+					std::vector<uint8_t> smaller(program.begin(), program.begin() + start);
+					smaller.insert(smaller.end(), program.begin() + std::min(program.size(), start + chunk_bytes), program.end());
+					runs++;
+					if (!smaller.empty() && RunLockstep(engine, smaller, options, seed, false).Diverged)
+					{
+						program = std::move(smaller);
+						shrunk = true;
+					}
+					else
+					{
+						start += chunk_bytes;
+					}
+				}
+			}
+		}
+		return program;
+	}
+
+	bool CheckProgram(const DifferentialEngine& engine, std::span<const uint8_t> program, const DifferentialOptions& options, const uint64_t seed, DifferentialFailure& failure)
+	{
+		LockstepResult result = RunLockstep(engine, program, options, seed, !options.Shrink);
+		if (!result.Diverged) return true;
+
+		failure.Seed = seed;
+		failure.OriginalSize = static_cast<uint32_t>(program.size());
+		failure.Program.assign(program.begin(), program.end());
+		if (options.Shrink)
+		{
+			failure.Program = ShrinkProgram(engine, std::move(failure.Program), options, seed);
+			result = RunLockstep(engine, failure.Program, options, seed, true);
+		}
+		failure.Step = result.Steps - 1;
+		failure.Difference = std::move(result.Difference);
+		return false;
+	}
+
+	// Shared by both RunDifferentialTests: threads take the next program as they finish, and
+	// stop taking new ones once MaxFailures have been found.
+	template<typename ProgramSource>
+	static DifferentialReport RunPrograms(const DifferentialEngine& engine, const uint64_t count, const DifferentialOptions& options, ProgramSource source)
+	{
+		DifferentialReport report;
+		unsigned thread_count = options.ThreadCount ? options.ThreadCount : std::max(1u, std::thread::hardware_concurrency());
+		thread_count = static_cast<unsigned>(std::min<uint64_t>(thread_count, std::max<uint64_t>(1, count)));
+
+		std::atomic<uint64_t> next{ 0 };
+		std::atomic<bool> done{ false };
+		std::mutex lock;
+		auto worker = [&]()
+			{
+				uint64_t programs = 0;
+				uint64_t steps = 0;
+				std::vector<uint8_t> program;
+				for (uint64_t index = next++; index < count && !done; index = next++)
+				{
+					uint64_t seed = 0;
+					source(index, program, seed);
+					const LockstepResult result = RunLockstep(engine, program, options, seed, false);
+					programs++;
+					steps += result.Steps;
+					if (!result.Diverged) continue;
+
+					DifferentialFailure failure;
+					failure.Index = index;
+					CheckProgram(engine, program, options, seed, failure);
+					std::lock_guard<std::mutex> guard(lock);
+					if (report.Failures.size() < options.MaxFailures) report.Failures.push_back(std::move(failure));
+					if (report.Failures.size() >= options.MaxFailures) done = true;
+				}
+				std::lock_guard<std::mutex> guard(lock);
+				report.Programs += programs;
+				report.Steps += steps;
+			};
+		std::vector<std::thread> threads;
+		for (unsigned thread = 1; thread < thread_count; ++thread)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		// Threads finish in any order; report failures in program order.
+		std::sort(report.Failures.begin(), report.Failures.end(), [](const DifferentialFailure& a, const DifferentialFailure& b) { return a.Index < b.Index; });
+		return report;
+	}
+
+	DifferentialReport RunDifferentialTests(const DifferentialEngine& engine, const uint64_t programs, const DifferentialOptions& options)
+	{
+		return RunPrograms(engine, programs, options, [&options](const uint64_t index, std::vector<uint8_t>& program, uint64_t& seed)
+			{
+				seed = options.Seed * 0x9E3779B97F4A7C15ULL + index;
+				program = GenerateRandomProgram(seed, options.ProgramInstructions, options.Quirks);
+			});
+	}
+
+	DifferentialReport RunDifferentialTests(const DifferentialEngine& engine, std::span<const std::vector<uint8_t>> roms, const DifferentialOptions& options)
+	{
+		return RunPrograms(engine, roms.size(), options, [&options, roms](const uint64_t index, std::vector<uint8_t>& program, uint64_t& seed)
+			{
+				seed = options.Seed;
+				program = roms[index];
+			});
+	}
+}
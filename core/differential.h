@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "chip-8.h"
+
+namespace chipotto
+{
+	// An execution engine checked against the reference interpreter. RunFrame must behave
+	// like Emulator::RunFrame without idle skipping, which a RecompiledProgram's RunFrame
+	// already does. Differential runs call it from several threads at once.
+	struct DifferentialEngine
+	{
+		const char* Name = "";
+		bool (*RunFrame)(Emulator& emulator, const uint32_t instructions) = nullptr;
+	};
+
+	struct DifferentialOptions
+	{
+		QuirkProfile Quirks = QuirkProfile::Chipotto;
+		// Length of generated programs. Long instructions (F000 nnnn, 01nn nnnn) count as one.
+		uint32_t ProgramInstructions = 64;
+		// States are compared after every step of InstructionsPerStep instructions: 1 checks
+		// each instruction, larger values let block-based engines run whole blocks.
+		uint32_t Steps = 1000;
+		uint32_t InstructionsPerStep = 1;
+		uint64_t Seed = 1;
+		// 0 uses every hardware thread.
+		unsigned ThreadCount = 0;
+		// A run stops looking once it has found this many failures.
+		uint32_t MaxFailures = 16;
+		bool Shrink = true;
+	};
+
+	struct DifferentialFailure
+	{
+		// Position of the program in the run: the nth random program or ROM.
+		uint64_t Index = 0;
+		// Seeds the program generator (random runs), the emulators' Rng and the key presses.
+		uint64_t Seed = 0;
+		// Program loaded at 0x200, shrunk when DifferentialOptions::Shrink is set.
+		std::vector<uint8_t> Program;
+		uint32_t OriginalSize = 0;
+		// Step after which the states first differed, counted from 0.
+		uint32_t Step = 0;
+		// First differing part of the state, reference value first, e.g. "V3: 0x05 != 0x07".
+		std::string Difference;
+	};
+
+	struct DifferentialReport
+	{
+		uint64_t Programs = 0;
+		// Comparisons made, each after up to InstructionsPerStep instructions.
+		uint64_t Steps = 0;
+		std::vector<DifferentialFailure> Failures;
+	};
+
+	// A random program for the profile: every opcode the interpreter implements (bar 00FD),
+	// with jump and call targets inside the program. Deterministic for a given seed.
+	std::vector<uint8_t> GenerateRandomProgram(const uint64_t seed, const uint32_t instructions, const QuirkProfile quirks);
+
+	// Runs program on the interpreter and on engine in lockstep, from the same seed and with
+	// the same key presses, until the states differ or options.Steps steps have run. Returns
+	// false and fills failure (shrunk if asked) when they differ.
+	bool CheckProgram(const DifferentialEngine& engine, std::span<const uint8_t> program, const DifferentialOptions& options, const uint64_t seed, DifferentialFailure& failure);
+
+	// Checks that many random programs, the nth generated from options.Seed and n, spread
+	// over options.ThreadCount threads.
+	DifferentialReport RunDifferentialTests(const DifferentialEngine& engine, const uint64_t programs, const DifferentialOptions& options);
+	// Checks real ROMs, each seeded with options.Seed.
+	DifferentialReport RunDifferentialTests(const DifferentialEngine& engine, std::span<const std::vector<uint8_t>> roms, const DifferentialOptions& options);
+}
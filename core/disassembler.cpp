@@ -0,0 +1,119 @@
+#include "disassembler.h"
+#include "opcode_table.h"
+
+namespace chipotto
+{
+	static constexpr char HexDigits[] = "0123456789ABCDEF";
+
+	static char* Put(char* out, const char* text)
+	{
+		while (*text) *out++ = *text++;
+		return out;
+	}
+
+	static char* PutDigits(char* out, const uint32_t value, const int digits)
+	{
+		for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+		{
+			*out++ = HexDigits[(value >> shift) & 0xF];
+		}
+		return out;
+	}
+
+	static char* PutHex(char* out, const uint32_t value, const int digits)
+	{
+		*out++ = '0';
+		*out++ = 'x';
+		return PutDigits(out, value, digits);
+	}
+
+	static char* PutRegister(char* out, const uint32_t index)
+	{
+		*out++ = 'V';
+		*out++ = HexDigits[index & 0xF];
+		return out;
+	}
+
+	static char* PutUnknown(char* out, const uint16_t opcode)
+	{
+		return PutHex(Put(out, "DW "), opcode, 4);
+	}
+
+	// Expands the operand fields of an OpcodeForm's Format.
+	static char* PutFormat(char* out, const char* format, const uint16_t opcode, const uint16_t operand)
+	{
+		for (; *format; ++format)
+		{
+			if (*format != '%')
+			{
+				*out++ = *format;
+				continue;
+			}
+			switch (*++format)
+			{
+			case 'x': out = PutRegister(out, opcode >> 8); break;
+			case 'y': out = PutRegister(out, opcode >> 4); break;
+			case 'X': out = PutDigits(out, opcode >> 8, 1); break;
+			case 'n': out = PutDigits(out, opcode, 1); break;
+			case 'b': out = PutHex(out, opcode & 0xFF, 2); break;
+			case 'a': out = PutHex(out, opcode & 0xFFF, 3); break;
+			case 'l': out = PutHex(out, operand, 4); break;
+			case 'h': out = PutHex(out, (static_cast<uint32_t>(opcode & 0xFF) << 16) | operand, 6); break;
+			}
+		}
+		return out;
+	}
+
+	size_t Disassemble(const uint16_t opcode, const uint16_t operand, const QuirkProfile quirks, char* text)
+	{
+		const OpcodeForm* form = IsValidOpcode(opcode, quirks) ? FindOpcodeForm(opcode) : nullptr;
+		char* end = form ? PutFormat(text, form->Format, opcode, operand) : PutUnknown(text, opcode);
+		*end = '\0';
+		return end - text;
+	}
+
+	size_t DisassembleListing(std::span<const uint8_t> code, const uint32_t address, const QuirkProfile quirks, std::span<char> out, size_t& consumed, const bool final)
+	{
+		char* const begin = out.data();
+		char* line = begin;
+		size_t offset = 0;
+		while (offset < code.size() && static_cast<size_t>(begin + out.size() - line) >= MaxListingLineLength)
+		{
+			const uint32_t line_address = address + static_cast<uint32_t>(offset);
+			if (offset + 1 == code.size())
+			{
+				// A trailing odd byte, which the next chunk may complete.
+				if (!final) break;
+				line = Put(PutDigits(line, line_address, line_address > 0xFFFF ? 6 : 4), ": ");
+				line = PutHex(Put(PutDigits(line, code[offset], 2), "         DB "), code[offset], 2);
+				*line++ = '\n';
+				offset++;
+				break;
+			}
+
+			const uint16_t opcode = static_cast<uint16_t>((code[offset] << 8) | code[offset + 1]);
+			const OpcodeForm* form = FindOpcodeForm(opcode);
+			const bool long_instruction = form && form->Length == 4 && IsValidOpcode(opcode, quirks);
+			if (long_instruction && offset + 3 >= code.size() && !final) break;
+
+			line = Put(PutDigits(line, line_address, line_address > 0xFFFF ? 6 : 4), ": ");
+			if (long_instruction && offset + 3 < code.size())
+			{
+				const uint16_t operand = static_cast<uint16_t>((code[offset + 2] << 8) | code[offset + 3]);
+				line = Put(PutDigits(Put(PutDigits(line, opcode, 4), " "), operand, 4), "  ");
+				line += Disassemble(opcode, operand, quirks, line);
+				offset += 4;
+			}
+			else
+			{
+				line = Put(PutDigits(line, opcode, 4), "       ");
+				// A long instruction cut off by the end of code has no operand to show.
+				line = long_instruction ? PutUnknown(line, opcode) : line + Disassemble(opcode, 0, quirks, line);
+				offset += 2;
+			}
+			*line++ = '\n';
+		}
+		consumed = offset;
+		return line - begin;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "quirks.h"
+
+namespace chipotto
+{
+	// Longest mnemonic Disassemble writes, including the terminating NUL.
+	static constexpr size_t MaxDisassemblyLength = 24;
+	// Longest line DisassembleListing writes, including the newline.
+	static constexpr size_t MaxListingLineLength = 48;
+
+	// Writes the mnemonic of opcode to text, NUL-terminated, and returns its length. Decoding
+	// goes through the opcode table (opcode_table.h), and opcodes that do not run under quirks,
+	// such as MEGA-CHIP forms outside the MEGA-CHIP profile, come out as "DW 0xNNNN". operand is
+	// the second word of F000 nnnn and 01nn nnnn and ignored otherwise. text must hold
+	// MaxDisassemblyLength bytes. Nothing is allocated and nothing is executed.
+	size_t Disassemble(const uint16_t opcode, const uint16_t operand, const QuirkProfile quirks, char* text);
+
+	// Lists code, whose first byte sits at address, as "0200: A22A       LD I, 0x22A" lines.
+	// Writes as many whole lines as fit in out and returns the bytes written; consumed receives
+	// how many bytes of code they cover, so a caller can flush out and carry on with
+	// code.subspan(consumed). 01nn nnnn is four bytes long only under the MEGA-CHIP profile.
+	// Unless final is set, an instruction cut off by the end of code is left unconsumed, so a
+	// caller reading the ROM in chunks can prepend it to the next one; with final set it is
+	// listed as DB or DW.
+	size_t DisassembleListing(std::span<const uint8_t> code, const uint32_t address, const QuirkProfile quirks, std::span<char> out, size_t& consumed, const bool final = true);
+}
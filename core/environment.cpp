@@ -0,0 +1,180 @@
+#include "environment.h"
+#include <algorithm>
+#include <bit>
+
+namespace chipotto
+{
+	// SplitMix64: one multiply-xorshift step per draw is plenty for picking no-op counts.
+	static uint64_t NextSeed(uint64_t& state)
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	BatchedEnvironment::BatchedEnvironment(std::shared_ptr<const MemoryImage> rom, const EnvironmentConfig& config, const size_t count) :
+		Config(config), Count(count), Instances(std::make_unique<Emulator[]>(count)), States(count), Scores(count)
+	{
+		// Blocks must not straddle the 64-bit words of a row.
+		Config.Downsample = static_cast<int>(std::bit_floor(static_cast<unsigned>(std::clamp(Config.Downsample, 1, 64))));
+
+		// Every reset restores this state, so episodes start from a freshly loaded ROM without
+		// remapping memory.
+		Emulator fresh;
+		fresh.LoadFromImage(rom);
+		fresh.SetQuirks(Config.Quirks);
+		fresh.SaveState(Initial);
+		for (size_t i = 0; i < Count; ++i)
+		{
+			Instances[i].LoadState(Initial);
+		}
+	}
+
+	int BatchedEnvironment::GetObservationWidth() const
+	{
+		const int width = Config.HighResolution ? Framebuffer::MaxWidth : Framebuffer::LowResWidth;
+		return Config.Observation == ObservationFormat::Packed ? width : width / Config.Downsample;
+	}
+
+	int BatchedEnvironment::GetObservationHeight() const
+	{
+		const int height = Config.HighResolution ? Framebuffer::MaxHeight : Framebuffer::LowResHeight;
+		return Config.Observation == ObservationFormat::Packed ? height : height / Config.Downsample;
+	}
+
+	size_t BatchedEnvironment::GetObservationSize() const
+	{
+		const size_t width = GetObservationWidth();
+		const size_t height = GetObservationHeight();
+		return Config.Observation == ObservationFormat::Packed ? width / 8 * height : width * height;
+	}
+
+	void BatchedEnvironment::Reset(const uint64_t seed, uint8_t* observations)
+	{
+		const size_t observation_size = GetObservationSize();
+		for (size_t i = 0; i < Count; ++i)
+		{
+			States[i].Seed = seed + i;
+			ResetInstance(i);
+			Observe(i, observations + i * observation_size);
+		}
+	}
+
+	void BatchedEnvironment::Step(const uint16_t* actions, uint8_t* observations, float* rewards, uint8_t* dones)
+	{
+		const size_t observation_size = GetObservationSize();
+		for (size_t i = 0; i < Count; ++i)
+		{
+			if (States[i].Done) ResetInstance(i);
+
+			Emulator& emulator = Instances[i];
+			emulator.SetKeys(actions[i]);
+			bool stopped = false;
+			for (uint32_t frame = 0; frame < Config.FramesPerStep && !stopped; ++frame)
+			{
+				stopped = !emulator.RunFrame(Config.InstructionsPerFrame, true);
+				States[i].EpisodeFrames++;
+			}
+
+			const float score = ReadScore(emulator);
+			rewards[i] = score - Scores[i];
+			Scores[i] = score;
+			States[i].Done = IsDone(i, stopped);
+			dones[i] = States[i].Done ? 1 : 0;
+			Observe(i, observations + i * observation_size);
+		}
+	}
+
+	void BatchedEnvironment::ResetInstance(const size_t index)
+	{
+		Emulator& emulator = Instances[index];
+		InstanceState& state = States[index];
+		emulator.LoadState(Initial);
+
+		uint64_t random = state.Seed;
+		const uint32_t noops = Config.MaxNoopFrames ? static_cast<uint32_t>(NextSeed(random) % (Config.MaxNoopFrames + 1)) : 0;
+		// Each episode of the same instance gets a different no-op count and Cxnn sequence.
+		emulator.SetSeed(NextSeed(random));
+		state.Seed = NextSeed(random);
+		for (uint32_t frame = 0; frame < noops; ++frame)
+		{
+			if (!emulator.RunFrame(Config.InstructionsPerFrame, true)) break;
+		}
+		state.EpisodeFrames = 0;
+		state.Done = false;
+		Scores[index] = ReadScore(emulator);
+	}
+
+	void BatchedEnvironment::Observe(const size_t index, uint8_t* observation) const
+	{
+		const Framebuffer& display = Instances[index].GetFramebuffer();
+		const int width = Config.HighResolution ? Framebuffer::MaxWidth : Framebuffer::LowResWidth;
+		const int height = Config.HighResolution ? Framebuffer::MaxHeight : Framebuffer::LowResHeight;
+
+		if (Config.Observation == ObservationFormat::Packed)
+		{
+			// Each 64-bit word of a row is already 64 pixels MSB first; emit it big-endian.
+			for (int y = 0; y < height; ++y)
+			{
+				for (int word = 0; word < width / 64; ++word)
+				{
+					const uint64_t pixels = display.Rows[y][word];
+					for (int byte = 0; byte < 8; ++byte)
+					{
+						*observation++ = static_cast<uint8_t>(pixels >> (56 - 8 * byte));
+					}
+				}
+			}
+			return;
+		}
+
+		const int factor = Config.Downsample;
+		const uint64_t block_mask = (factor >= 64 ? ~0ULL : ((1ULL << factor) - 1)) << (64 - factor);
+		const int block_pixels = factor * factor;
+		for (int y = 0; y < height / factor; ++y)
+		{
+			for (int x = 0; x < width / factor; ++x)
+			{
+				const int column = x * factor;
+				int lit = 0;
+				for (int row = y * factor; row < (y + 1) * factor; ++row)
+				{
+					const uint64_t word = display.Rows[row][column >> 6];
+					lit += std::popcount(word & (block_mask >> (column & 63)));
+				}
+				*observation++ = static_cast<uint8_t>(lit * 255 / block_pixels);
+			}
+		}
+	}
+
+	float BatchedEnvironment::ReadScore(const Emulator& emulator) const
+	{
+		const PagedMemory& memory = emulator.GetMemoryMapping();
+		float score = 0.0f;
+		for (const RewardSource& source : Config.Rewards)
+		{
+			int value = 0;
+			switch (source.Encoding)
+			{
+			case RewardEncoding::Byte: value = memory[source.Address]; break;
+			case RewardEncoding::Word: value = (memory[source.Address] << 8) | memory[source.Address + 1]; break;
+			case RewardEncoding::Bcd: value = memory[source.Address] * 100 + memory[source.Address + 1] * 10 + memory[source.Address + 2]; break;
+			}
+			score += value * source.Scale;
+		}
+		return score;
+	}
+
+	bool BatchedEnvironment::IsDone(const size_t index, const bool stopped) const
+	{
+		if (stopped) return true;
+		if (Config.MaxEpisodeFrames && States[index].EpisodeFrames >= Config.MaxEpisodeFrames) return true;
+		if (Config.UseDoneAddress)
+		{
+			const uint8_t value = Instances[index].GetMemoryMapping()[Config.DoneAddress];
+			if ((value & Config.DoneMask) == Config.DoneValue) return true;
+		}
+		return false;
+	}
+}
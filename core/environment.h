@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "chip-8.h"
+
+namespace chipotto
+{
+	enum class ObservationFormat : uint8_t
+	{
+		// 1 bit per pixel, rows packed most significant bit first.
+		Packed,
+		// One byte per Downsample x Downsample block: the fraction of lit pixels, 0-255.
+		Downsampled
+	};
+
+	enum class RewardEncoding : uint8_t
+	{
+		Byte,
+		// Big-endian 16-bit value.
+		Word,
+		// Three BCD digits as written by Fx33.
+		Bcd
+	};
+
+	// Score location in RAM; the reward of a step is the change in its value times Scale.
+	struct RewardSource
+	{
+		uint32_t Address = 0;
+		RewardEncoding Encoding = RewardEncoding::Byte;
+		float Scale = 1.0f;
+	};
+
+	struct EnvironmentConfig
+	{
+		QuirkProfile Quirks = QuirkProfile::Chipotto;
+		uint32_t InstructionsPerFrame = 10;
+		// Emulated frames per step, all with the same action.
+		uint32_t FramesPerStep = 4;
+		// Episodes end after this many frames; 0 means never.
+		uint32_t MaxEpisodeFrames = 0;
+		// Reset runs a seeded random number (0 to this) of idle frames so episodes differ.
+		uint32_t MaxNoopFrames = 30;
+
+		ObservationFormat Observation = ObservationFormat::Packed;
+		// Observe the 128x64 SUPER-CHIP screen instead of the 64x32 one.
+		bool HighResolution = false;
+		// Rounded down to a power of two.
+		int Downsample = 2;
+
+		std::vector<RewardSource> Rewards;
+		// Optional game-over test: done when (RAM[DoneAddress] & DoneMask) == DoneValue.
+		bool UseDoneAddress = false;
+		uint32_t DoneAddress = 0;
+		uint8_t DoneMask = 0xFF;
+		uint8_t DoneValue = 0;
+	};
+
+	// N independent instances of one ROM stepped together for reinforcement learning. All
+	// outputs go into caller-owned arrays laid out instance after instance, so a step never
+	// allocates. Instances that finish an episode are reset at the start of their next step.
+	//
+	// Instances share nothing mutable, so large batches can be split across threads by giving
+	// each thread its own BatchedEnvironment and a slice of the output arrays.
+	class BatchedEnvironment
+	{
+	public:
+		BatchedEnvironment(std::shared_ptr<const MemoryImage> rom, const EnvironmentConfig& config, const size_t count);
+
+		size_t GetCount() const { return Count; };
+		int GetObservationWidth() const;
+		int GetObservationHeight() const;
+		// Bytes of observation per instance.
+		size_t GetObservationSize() const;
+
+		// Resets every instance; instance i is seeded with seed + i, which also seeds its Cxnn generator.
+		void Reset(const uint64_t seed, uint8_t* observations);
+		// actions holds one 16-bit key state per instance; keys pressed since the previous step
+		// end an Fx0A wait. dones is set to 1 for instances whose episode ended on this step.
+		void Step(const uint16_t* actions, uint8_t* observations, float* rewards, uint8_t* dones);
+
+	private:
+		struct InstanceState
+		{
+			uint64_t Seed = 0;
+			uint32_t EpisodeFrames = 0;
+			bool Done = false;
+		};
+
+		void ResetInstance(const size_t index);
+		void Observe(const size_t index, uint8_t* observation) const;
+		float ReadScore(const Emulator& emulator) const;
+		bool IsDone(const size_t index, const bool stopped) const;
+
+		EnvironmentConfig Config;
+		size_t Count;
+		std::unique_ptr<Emulator[]> Instances;
+		std::vector<InstanceState> States;
+		std::vector<float> Scores;
+		Snapshot Initial;
+	};
+}
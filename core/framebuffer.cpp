@@ -0,0 +1,234 @@
+#include "framebuffer.h"
+#include <algorithm>
+
+namespace chipotto
+{
+	static const Framebuffer::Plane EmptyPlane{};
+
+	Framebuffer::Framebuffer(const Framebuffer& other)
+	{
+		*this = other;
+	}
+
+	Framebuffer& Framebuffer::operator=(const Framebuffer& other)
+	{
+		if (this == &other) return *this;
+		Rows = other.Rows;
+		if (other.ExtraPlanes)
+		{
+			if (!ExtraPlanes) ExtraPlanes = std::make_unique<std::array<Plane, MaxPlanes - 1>>();
+			*ExtraPlanes = *other.ExtraPlanes;
+		}
+		else
+		{
+			ExtraPlanes.reset();
+		}
+		if (other.Mega)
+		{
+			if (!Mega) Mega = std::make_unique<MegaScreen>();
+			*Mega = *other.Mega;
+		}
+		else
+		{
+			Mega.reset();
+		}
+		PixelHash = other.PixelHash;
+		SelectedPlanes = other.SelectedPlanes;
+		HighResolution = other.HighResolution;
+		return *this;
+	}
+
+	uint8_t Framebuffer::GetPixelIndex(const int x, const int y) const
+	{
+		const int word = x >> 6;
+		const int shift = 63 - (x & 63);
+		uint8_t index = (Rows[y][word] >> shift) & 0x1;
+		if (ExtraPlanes)
+		{
+			for (int plane = 1; plane < MaxPlanes; ++plane)
+			{
+				index |= (((*ExtraPlanes)[plane - 1][y][word] >> shift) & 0x1) << plane;
+			}
+		}
+		return index;
+	}
+
+	const Framebuffer::Plane& Framebuffer::GetPlane(const int plane) const
+	{
+		if (plane == 0) return Rows;
+		if (!ExtraPlanes) return EmptyPlane;
+		return (*ExtraPlanes)[plane - 1];
+	}
+
+	Framebuffer::Plane& Framebuffer::GetPlane(const int plane)
+	{
+		if (plane == 0) return Rows;
+		if (!ExtraPlanes) ExtraPlanes = std::make_unique<std::array<Plane, MaxPlanes - 1>>();
+		return (*ExtraPlanes)[plane - 1];
+	}
+
+	bool Framebuffer::HasSameLayout(const Framebuffer& other) const
+	{
+		if (HighResolution != other.HighResolution) return false;
+		if ((ExtraPlanes != nullptr) != (other.ExtraPlanes != nullptr)) return false;
+		if ((Mega != nullptr) != (other.Mega != nullptr)) return false;
+		return !Mega || Mega->Palette == other.Mega->Palette;
+	}
+
+	bool Framebuffer::RowEquals(const Framebuffer& other, const int y) const
+	{
+		if (Mega)
+		{
+			return std::equal(Mega->GetRow(y), Mega->GetRow(y) + MegaScreen::Width, other.Mega->GetRow(y));
+		}
+		if (Rows[y] != other.Rows[y]) return false;
+		if (ExtraPlanes)
+		{
+			for (int plane = 0; plane < MaxPlanes - 1; ++plane)
+			{
+				if ((*ExtraPlanes)[plane][y] != (*other.ExtraPlanes)[plane][y]) return false;
+			}
+		}
+		return true;
+	}
+
+	uint64_t Framebuffer::ComputePixelHash() const
+	{
+		uint64_t hash = 0;
+		const int planes = ExtraPlanes ? MaxPlanes : 1;
+		for (int index = 0; index < planes; ++index)
+		{
+			const Plane& plane = GetPlane(index);
+			for (int y = 0; y < MaxHeight; ++y)
+			{
+				for (int word = 0; word < WordsPerRow; ++word)
+				{
+					if (!plane[y][word]) continue;
+					const uint64_t position = (static_cast<uint64_t>(index) * MaxHeight + y) * WordsPerRow + word;
+					hash ^= ZobristKey(position, plane[y][word]) ^ ZobristKey(position, 0);
+				}
+			}
+		}
+		return hash;
+	}
+
+	void Framebuffer::SelectPlanes(const uint8_t planes)
+	{
+		SelectedPlanes = planes & ((1 << MaxPlanes) - 1);
+		if (SelectedPlanes & ~0x1) GetPlane(1);
+	}
+
+	void Framebuffer::Clear()
+	{
+		if (Mega)
+		{
+			Mega->Pixels.fill(0);
+			return;
+		}
+		for (int plane = 0; plane < MaxPlanes; ++plane)
+		{
+			if (SelectedPlanes & (1 << plane)) GetPlane(plane).fill({});
+		}
+		PixelHash = ComputePixelHash();
+	}
+
+	void Framebuffer::SetHighResolution(const bool enabled)
+	{
+		HighResolution = enabled;
+		Rows.fill({});
+		if (ExtraPlanes)
+		{
+			for (Plane& plane : *ExtraPlanes) plane.fill({});
+		}
+		PixelHash = 0;
+	}
+
+	void Framebuffer::SetMegaMode(const bool enabled)
+	{
+		if (enabled)
+		{
+			if (!Mega) Mega = std::make_unique<MegaScreen>();
+		}
+		else
+		{
+			Mega.reset();
+		}
+		SetHighResolution(enabled);
+	}
+
+	void Framebuffer::ScrollDown(const int lines)
+	{
+		if (Mega) return Mega->ScrollDown(lines);
+		const int height = GetHeight();
+		const int count = std::min(lines, height);
+		for (int index = 0; index < MaxPlanes; ++index)
+		{
+			if (!(SelectedPlanes & (1 << index))) continue;
+			Plane& plane = GetPlane(index);
+			std::copy_backward(plane.begin(), plane.begin() + (height - count), plane.begin() + height);
+			std::fill(plane.begin(), plane.begin() + count, Row{});
+		}
+		PixelHash = ComputePixelHash();
+	}
+
+	void Framebuffer::ScrollUp(const int lines)
+	{
+		if (Mega) return Mega->ScrollUp(lines);
+		const int height = GetHeight();
+		const int count = std::min(lines, height);
+		for (int index = 0; index < MaxPlanes; ++index)
+		{
+			if (!(SelectedPlanes & (1 << index))) continue;
+			Plane& plane = GetPlane(index);
+			std::copy(plane.begin() + count, plane.begin() + height, plane.begin());
+			std::fill(plane.begin() + (height - count), plane.begin() + height, Row{});
+		}
+		PixelHash = ComputePixelHash();
+	}
+
+	void Framebuffer::ScrollRight(const int pixels)
+	{
+		if (Mega) return Mega->ScrollRight(pixels);
+		const int height = GetHeight();
+		for (int index = 0; index < MaxPlanes; ++index)
+		{
+			if (!(SelectedPlanes & (1 << index))) continue;
+			Plane& plane = GetPlane(index);
+			for (int y = 0; y < height; ++y)
+			{
+				Row& row = plane[y];
+				if (!HighResolution)
+				{
+					row[0] >>= pixels;
+					continue;
+				}
+				row[1] = (row[1] >> pixels) | (row[0] << (64 - pixels));
+				row[0] >>= pixels;
+			}
+		}
+		PixelHash = ComputePixelHash();
+	}
+
+	void Framebuffer::ScrollLeft(const int pixels)
+	{
+		if (Mega) return Mega->ScrollLeft(pixels);
+		const int height = GetHeight();
+		for (int index = 0; index < MaxPlanes; ++index)
+		{
+			if (!(SelectedPlanes & (1 << index))) continue;
+			Plane& plane = GetPlane(index);
+			for (int y = 0; y < height; ++y)
+			{
+				Row& row = plane[y];
+				if (!HighResolution)
+				{
+					row[0] <<= pixels;
+					continue;
+				}
+				row[0] = (row[0] << pixels) | (row[1] >> (64 - pixels));
+				row[1] <<= pixels;
+			}
+		}
+		PixelHash = ComputePixelHash();
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include "mega_chip.h"
+#include "rom_hash.h"
+
+namespace chipotto
+{
+	// 1bpp bitplanes packed as 128-bit rows (two 64-bit words, leftmost pixel in the most
+	// significant bit of the first word). Low resolution mode uses the top-left 64x32 corner,
+	// i.e. only the first word of the first 32 rows, so scrolls stay word shifts and row copies.
+	//
+	// Plane 0 is stored inline. The XO-CHIP planes 1-3 are allocated the first time a program
+	// selects them, so plain CHIP-8 and SUPER-CHIP instances don't pay for them. Pixels are
+	// combined into palette indices only by the presenter.
+	//
+	// MEGA-CHIP mode swaps the bitplanes for an indexed-colour MegaScreen, allocated while the
+	// mode is on. Clears and scrolls then act on it instead of the planes.
+	//
+	// PixelHash is a Zobrist hash of the planes: the XOR, over every word, of the keys of its
+	// value and of 0. DrawSpriteRow updates it word by word; clears and scrolls, which rewrite
+	// whole planes anyway, recompute it. The MEGA-CHIP screen isn't covered.
+	struct alignas(64) Framebuffer
+	{
+		static constexpr int MaxWidth = 128;
+		static constexpr int MaxHeight = 64;
+		static constexpr int LowResWidth = 64;
+		static constexpr int LowResHeight = 32;
+		static constexpr int WordsPerRow = MaxWidth / 64;
+		static constexpr int MaxPlanes = 4;
+
+		using Row = std::array<uint64_t, WordsPerRow>;
+		using Plane = std::array<Row, MaxHeight>;
+
+		Plane Rows{};
+		std::unique_ptr<std::array<Plane, MaxPlanes - 1>> ExtraPlanes;
+		std::unique_ptr<MegaScreen> Mega;
+		uint64_t PixelHash = 0;
+		uint8_t SelectedPlanes = 0x1;
+		bool HighResolution = false;
+
+		Framebuffer() = default;
+		Framebuffer(const Framebuffer& other);
+		Framebuffer& operator=(const Framebuffer& other);
+
+		int GetWidth() const { return Mega ? MegaScreen::Width : (HighResolution ? MaxWidth : LowResWidth); };
+		int GetHeight() const { return Mega ? MegaScreen::Height : (HighResolution ? MaxHeight : LowResHeight); };
+		bool GetPixel(const int x, const int y) const { return (Rows[y][x >> 6] >> (63 - (x & 63))) & 0x1; };
+		uint8_t GetPixelIndex(const int x, const int y) const;
+		bool HasExtraPlanes() const { return ExtraPlanes != nullptr; };
+		const Plane& GetPlane(const int plane) const;
+		Plane& GetPlane(const int plane);
+
+		// Used by presenters to upload only what changed since the last frame. Rows are only
+		// comparable when both framebuffers have the same layout (mode, planes and palette).
+		bool HasSameLayout(const Framebuffer& other) const;
+		bool RowEquals(const Framebuffer& other, const int y) const;
+
+		uint64_t GetPixelHash() const { return PixelHash; };
+		uint64_t ComputePixelHash() const;
+
+		void SelectPlanes(const uint8_t planes);
+		void Clear();
+		void SetHighResolution(const bool enabled);
+		void SetMegaMode(const bool enabled);
+		void ScrollDown(const int lines);
+		void ScrollUp(const int lines);
+		void ScrollRight(const int pixels);
+		void ScrollLeft(const int pixels);
+
+		// XORs up to 16 pixels (most significant bit first) into row y of a plane starting at
+		// column x. Returns true if any lit pixel was turned off.
+		template<bool Wrap>
+		bool DrawSpriteRow(const int plane, const int x, const int y, const uint16_t bits)
+		{
+			Row& row = GetPlane(plane)[y];
+			const uint64_t sprite = static_cast<uint64_t>(bits) << 48;
+			if (!HighResolution)
+			{
+				uint64_t pixels = sprite >> x;
+				if constexpr (Wrap)
+				{
+					if (x) pixels |= sprite << (64 - x);
+				}
+				const bool collision = (row[0] & pixels) != 0;
+				HashWord(plane, y, 0, row[0], row[0] ^ pixels);
+				row[0] ^= pixels;
+				return collision;
+			}
+
+			uint64_t high = x < 64 ? sprite >> x : 0;
+			uint64_t low = x == 0 ? 0 : (x < 64 ? sprite << (64 - x) : sprite >> (x - 64));
+			if constexpr (Wrap)
+			{
+				// Bits pushed past column 127 come back in at column 0.
+				if (x > 64) high |= sprite << (128 - x);
+			}
+			const bool collision = ((row[0] & high) | (row[1] & low)) != 0;
+			HashWord(plane, y, 0, row[0], row[0] ^ high);
+			HashWord(plane, y, 1, row[1], row[1] ^ low);
+			row[0] ^= high;
+			row[1] ^= low;
+			return collision;
+		}
+
+		void HashWord(const int plane, const int y, const int word, const uint64_t old_value, const uint64_t value)
+		{
+			if (old_value == value) return;
+			const uint64_t position = (static_cast<uint64_t>(plane) * MaxHeight + y) * WordsPerRow + word;
+			PixelHash ^= ZobristKey(position, old_value) ^ ZobristKey(position, value);
+		}
+	};
+}
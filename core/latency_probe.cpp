@@ -0,0 +1,40 @@
+#include "latency_probe.h"
+#include <algorithm>
+
+namespace chipotto
+{
+	void LatencyProbe::Record(const std::chrono::nanoseconds latency)
+	{
+		const std::chrono::nanoseconds clamped = std::max(latency, std::chrono::nanoseconds(0));
+		const int64_t bucket = std::min<int64_t>(clamped / BucketWidth, BucketCount - 1);
+		Buckets[bucket]++;
+		Count++;
+		Total += clamped;
+		Min = std::min(Min, clamped);
+		Max = std::max(Max, clamped);
+	}
+
+	void LatencyProbe::Reset()
+	{
+		*this = LatencyProbe();
+	}
+
+	std::chrono::nanoseconds LatencyProbe::GetMean() const
+	{
+		if (!Count) return std::chrono::nanoseconds(0);
+		return Total / static_cast<int64_t>(Count);
+	}
+
+	std::chrono::nanoseconds LatencyProbe::GetPercentile(const double fraction) const
+	{
+		if (!Count) return std::chrono::nanoseconds(0);
+		const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * Count + 0.5));
+		uint64_t seen = 0;
+		for (int bucket = 0; bucket < BucketCount; ++bucket)
+		{
+			seen += Buckets[bucket];
+			if (seen >= target) return BucketWidth * (bucket + 1);
+		}
+		return BucketWidth * BucketCount;
+	}
+}
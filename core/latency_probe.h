@@ -0,0 +1,34 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace chipotto
+{
+	// Fixed-size latency histogram: 0.1 ms buckets up to 100 ms, with everything slower counted
+	// in the last bucket. Recording never allocates, so it can run on the present path.
+	class LatencyProbe
+	{
+	public:
+		static constexpr int BucketCount = 1000;
+		static constexpr std::chrono::nanoseconds BucketWidth{ 100000 };
+
+		void Record(const std::chrono::nanoseconds latency);
+		void Reset();
+
+		uint64_t GetCount() const { return Count; };
+		std::chrono::nanoseconds GetMin() const { return Count ? Min : std::chrono::nanoseconds(0); };
+		std::chrono::nanoseconds GetMax() const { return Max; };
+		std::chrono::nanoseconds GetMean() const;
+		// Upper edge of the bucket holding the given fraction (0-1) of the samples.
+		std::chrono::nanoseconds GetPercentile(const double fraction) const;
+
+	private:
+		std::array<uint32_t, BucketCount> Buckets{};
+		uint64_t Count = 0;
+		std::chrono::nanoseconds Total{ 0 };
+		std::chrono::nanoseconds Min = std::chrono::nanoseconds::max();
+		std::chrono::nanoseconds Max{ 0 };
+	};
+}
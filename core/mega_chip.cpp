@@ -0,0 +1,120 @@
+#include "mega_chip.h"
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHIPOTTO_SSE2
+#endif
+
+namespace chipotto
+{
+	void MegaScreen::SetPaletteEntry(const uint8_t index, const uint8_t a, const uint8_t r, const uint8_t g, const uint8_t b)
+	{
+		Palette[index] = static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) | (static_cast<uint32_t>(b) << 16) | (static_cast<uint32_t>(a) << 24);
+	}
+
+	void MegaScreen::ScrollDown(const int lines)
+	{
+		const int count = std::min(lines, Height) * Width;
+		std::copy_backward(Pixels.begin(), Pixels.end() - count, Pixels.end());
+		std::fill(Pixels.begin(), Pixels.begin() + count, 0);
+	}
+
+	void MegaScreen::ScrollUp(const int lines)
+	{
+		const int count = std::min(lines, Height) * Width;
+		std::copy(Pixels.begin() + count, Pixels.end(), Pixels.begin());
+		std::fill(Pixels.end() - count, Pixels.end(), 0);
+	}
+
+	void MegaScreen::ScrollRight(const int pixels)
+	{
+		for (int y = 0; y < Height; ++y)
+		{
+			uint8_t* row = GetRow(y);
+			std::copy_backward(row, row + Width - pixels, row + Width);
+			std::fill(row, row + pixels, 0);
+		}
+	}
+
+	void MegaScreen::ScrollLeft(const int pixels)
+	{
+		for (int y = 0; y < Height; ++y)
+		{
+			uint8_t* row = GetRow(y);
+			std::copy(row + pixels, row + Width, row);
+			std::fill(row + Width - pixels, row + Width, 0);
+		}
+	}
+
+	bool BlitMegaRow(uint8_t* destination, const uint8_t* sprite, const int count, const uint8_t collision_index)
+	{
+		int x = 0;
+		bool collision = false;
+#if defined(__AVX2__)
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i collision_mask = _mm256_set1_epi8(static_cast<char>(collision_index));
+		int hits = 0;
+		for (; x + 32 <= count; x += 32)
+		{
+			const __m256i source = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sprite + x));
+			const __m256i target = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(destination + x));
+			const __m256i transparent = _mm256_cmpeq_epi8(source, zero);
+			hits |= _mm256_movemask_epi8(_mm256_andnot_si256(transparent, _mm256_cmpeq_epi8(target, collision_mask)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x), _mm256_blendv_epi8(source, target, transparent));
+		}
+		collision = hits != 0;
+#elif defined(CHIPOTTO_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i collision_mask = _mm_set1_epi8(static_cast<char>(collision_index));
+		int hits = 0;
+		for (; x + 16 <= count; x += 16)
+		{
+			const __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sprite + x));
+			const __m128i target = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination + x));
+			const __m128i transparent = _mm_cmpeq_epi8(source, zero);
+			hits |= _mm_movemask_epi8(_mm_andnot_si128(transparent, _mm_cmpeq_epi8(target, collision_mask)));
+			// No blendv before SSE4.1: select with and/andnot/or.
+			const __m128i blended = _mm_or_si128(_mm_and_si128(transparent, target), _mm_andnot_si128(transparent, source));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x), blended);
+		}
+		collision = hits != 0;
+#endif
+		for (; x < count; ++x)
+		{
+			if (sprite[x] == 0) continue;
+			collision |= destination[x] == collision_index;
+			destination[x] = sprite[x];
+		}
+		return collision;
+	}
+
+	void ExpandMegaPalette(const uint8_t* indices, const int count, const uint32_t* palette, uint32_t* output)
+	{
+		int x = 0;
+#if defined(__AVX2__)
+		for (; x + 8 <= count; x += 8)
+		{
+			const __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + x)));
+			const __m256i colours = _mm256_i32gather_epi32(reinterpret_cast<const int*>(palette), lanes, 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + x), colours);
+		}
+#else
+		// SSE2 has no gather and a 256-entry table is too big for shuffles, so this stays a scalar
+		// table lookup, unrolled.
+		for (; x + 4 <= count; x += 4)
+		{
+			output[x] = palette[indices[x]];
+			output[x + 1] = palette[indices[x + 1]];
+			output[x + 2] = palette[indices[x + 2]];
+			output[x + 3] = palette[indices[x + 3]];
+		}
+#endif
+		for (; x < count; ++x)
+		{
+			output[x] = palette[indices[x]];
+		}
+	}
+}
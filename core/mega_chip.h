@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace chipotto
+{
+	// MEGA-CHIP screen: one palette index per pixel and the 256-entry palette it is expanded
+	// through. Palette entries are stored in SDL_PIXELFORMAT_RGBA32 byte order so the presenter
+	// can copy expanded rows straight into a texture.
+	//
+	// Index 0 is transparent when drawing sprites. The screen alpha and blend mode set by
+	// 05nn/080n apply to the whole expanded frame and are left to the presenter.
+	struct alignas(64) MegaScreen
+	{
+		static constexpr int Width = 256;
+		static constexpr int Height = 192;
+
+		enum class BlendMode : uint8_t
+		{
+			Normal,
+			Alpha25,
+			Alpha50,
+			Add,
+			Multiply
+		};
+
+		std::array<uint8_t, Width * Height> Pixels{};
+		std::array<uint32_t, 0x100> Palette{};
+		int SpriteWidth = 0;
+		int SpriteHeight = 0;
+		uint8_t CollisionIndex = 0;
+		uint8_t Alpha = 0xFF;
+		BlendMode Blend = BlendMode::Normal;
+
+		uint8_t* GetRow(const int y) { return Pixels.data() + y * Width; };
+		const uint8_t* GetRow(const int y) const { return Pixels.data() + y * Width; };
+
+		void SetPaletteEntry(const uint8_t index, const uint8_t a, const uint8_t r, const uint8_t g, const uint8_t b);
+		void ScrollDown(const int lines);
+		void ScrollUp(const int lines);
+		void ScrollRight(const int pixels);
+		void ScrollLeft(const int pixels);
+	};
+
+	// Copies the non-zero bytes of a sprite row over count destination pixels. Returns true if
+	// any of them landed on a pixel holding the collision index.
+	bool BlitMegaRow(uint8_t* destination, const uint8_t* sprite, const int count, const uint8_t collision_index);
+
+	// Expands count palette indices into RGBA32 pixels, eight at a time with an AVX2 gather. The
+	// projects build with /arch:AVX2; elsewhere (SSE2 has no gather) it is a table lookup.
+	void ExpandMegaPalette(const uint8_t* indices, const int count, const uint32_t* palette, uint32_t* output);
+}
@@ -0,0 +1,212 @@
+#include "memory.h"
+#include <algorithm>
+#include <initializer_list>
+
+namespace chipotto
+{
+	static constexpr std::array<uint8_t, 80> Font =
+	{
+		0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+		0x20, 0x60, 0x20, 0x20, 0x70, // 1
+		0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+		0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+		0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+		0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+		0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+		0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+		0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+		0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+		0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+		0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+		0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+		0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+		0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+		0xF0, 0x80, 0xF0, 0x80, 0x80  // F
+	};
+
+	static constexpr std::array<uint8_t, 160> BigFont =
+	{
+		0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+		0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+		0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+		0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+		0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+		0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+		0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+		0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+		0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+		0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+		0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+		0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+		0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+	};
+
+	MemoryImage::MemoryImage(const uint32_t size) : Pages(size / MemoryPage::Size)
+	{
+		std::copy(Font.begin(), Font.end(), Pages[0].Bytes.begin() + FontAddress);
+		std::copy(BigFont.begin(), BigFont.end(), Pages[0].Bytes.begin() + BigFontAddress);
+	}
+
+	uint32_t MemoryImage::GetFittingSize(const size_t program_size)
+	{
+		for (const uint32_t size : { DefaultSize, ExtendedSize, MegaSize })
+		{
+			if (program_size <= size - ProgramAddress) return size;
+		}
+		return 0;
+	}
+
+	std::shared_ptr<const MemoryImage> MemoryImage::Create(std::span<const uint8_t> program, const uint32_t size)
+	{
+		auto image = std::make_shared<MemoryImage>(size);
+		image->Hash = HashRom(program);
+		const uint32_t length = std::min<uint32_t>(static_cast<uint32_t>(program.size()), size - ProgramAddress);
+		for (uint32_t i = 0; i < length; ++i)
+		{
+			const uint32_t address = ProgramAddress + i;
+			image->Pages[address >> MemoryPage::Shift].Bytes[address & (MemoryPage::Size - 1)] = program[i];
+		}
+		return image;
+	}
+
+	std::shared_ptr<const MemoryImage> MemoryImage::Resize(const MemoryImage& source, const uint32_t size)
+	{
+		auto image = std::make_shared<MemoryImage>(size);
+		image->Hash = source.Hash;
+		std::copy_n(source.Pages.begin(), std::min(source.GetPageCount(), image->GetPageCount()), image->Pages.begin());
+		return image;
+	}
+
+	const std::shared_ptr<const MemoryImage>& MemoryImage::Blank()
+	{
+		static const std::shared_ptr<const MemoryImage> blank = Create({});
+		return blank;
+	}
+
+	PagedMemory::PagedMemory()
+	{
+		Map(MemoryImage::Blank());
+	}
+
+	PagedMemory::~PagedMemory()
+	{
+		ReleasePrivatePages();
+	}
+
+	void PagedMemory::Map(std::shared_ptr<const MemoryImage> image)
+	{
+		ReleasePrivatePages();
+		if (!Image || Image->GetPageCount() != image->GetPageCount())
+		{
+			PageTable = std::make_unique<const uint8_t*[]>(image->GetPageCount());
+		}
+		Image = std::move(image);
+		AddressMask = Image->GetSize() - 1;
+		ContentHash = 0;
+		for (uint32_t page = 0; page < Image->GetPageCount(); ++page)
+		{
+			PageTable[page] = Image->GetPage(page);
+		}
+	}
+
+	void PagedMemory::ReadBlock(const uint32_t address, std::span<uint8_t> output) const
+	{
+		size_t copied = 0;
+		while (copied < output.size())
+		{
+			const uint32_t masked = (address + static_cast<uint32_t>(copied)) & AddressMask;
+			const uint32_t offset = masked & (MemoryPage::Size - 1);
+			const size_t length = std::min<size_t>(MemoryPage::Size - offset, output.size() - copied);
+			std::copy_n(PageTable[masked >> MemoryPage::Shift] + offset, length, output.begin() + copied);
+			copied += length;
+		}
+	}
+
+	uint32_t PagedMemory::GetPrivatePageCount() const
+	{
+		uint32_t count = 0;
+		for (uint32_t page = 0; page < Image->GetPageCount(); ++page)
+		{
+			if (!Image->Owns(PageTable[page])) count++;
+		}
+		return count;
+	}
+
+	uint64_t PagedMemory::ComputeContentHash() const
+	{
+		uint64_t hash = 0;
+		for (uint32_t page = 0; page < Image->GetPageCount(); ++page)
+		{
+			if (Image->Owns(PageTable[page])) continue;
+			const uint8_t* original = Image->GetPage(page);
+			for (uint32_t offset = 0; offset < MemoryPage::Size; ++offset)
+			{
+				const uint8_t value = PageTable[page][offset];
+				if (value == original[offset]) continue;
+				const uint32_t address = (page << MemoryPage::Shift) | offset;
+				hash ^= ZobristKey(address, value) ^ ZobristKey(address, original[offset]);
+			}
+		}
+		return hash;
+	}
+
+	void PagedMemory::SaveTo(MemorySnapshot& snapshot) const
+	{
+		snapshot.Image = Image;
+		snapshot.ContentHash = ContentHash;
+		snapshot.PageIndices.clear();
+		snapshot.Pages.clear();
+		for (uint32_t page = 0; page < Image->GetPageCount(); ++page)
+		{
+			if (Image->Owns(PageTable[page])) continue;
+			snapshot.PageIndices.push_back(page);
+			snapshot.Pages.push_back(*reinterpret_cast<const MemoryPage*>(PageTable[page]));
+		}
+	}
+
+	void PagedMemory::RestoreFrom(const MemorySnapshot& snapshot)
+	{
+		if (snapshot.Image != Image) Map(snapshot.Image);
+
+		size_t next = 0;
+		for (uint32_t page = 0; page < Image->GetPageCount(); ++page)
+		{
+			const bool saved = next < snapshot.PageIndices.size() && snapshot.PageIndices[next] == page;
+			if (saved)
+			{
+				uint8_t* bytes = Image->Owns(PageTable[page]) ? MakePrivate(page) : const_cast<uint8_t*>(PageTable[page]);
+				std::copy_n(snapshot.Pages[next].Bytes.begin(), MemoryPage::Size, bytes);
+				next++;
+			}
+			else if (!Image->Owns(PageTable[page]))
+			{
+				std::copy_n(Image->GetPage(page), MemoryPage::Size, const_cast<uint8_t*>(PageTable[page]));
+			}
+		}
+		ContentHash = snapshot.ContentHash;
+	}
+
+	uint8_t* PagedMemory::MakePrivate(const uint32_t page)
+	{
+		MemoryPage* copy = new MemoryPage;
+		std::copy_n(PageTable[page], MemoryPage::Size, copy->Bytes.begin());
+		PageTable[page] = copy->Bytes.data();
+		return copy->Bytes.data();
+	}
+
+	void PagedMemory::ReleasePrivatePages()
+	{
+		if (!Image) return;
+		for (uint32_t page = 0; page < Image->GetPageCount(); ++page)
+		{
+			if (!Image->Owns(PageTable[page]))
+			{
+				delete reinterpret_cast<const MemoryPage*>(PageTable[page]);
+				PageTable[page] = Image->GetPage(page);
+			}
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include "rom_hash.h"
+
+namespace chipotto
+{
+	struct alignas(64) MemoryPage
+	{
+		static constexpr uint32_t Size = 0x100;
+		static constexpr uint32_t Shift = 8;
+
+		std::array<uint8_t, Size> Bytes{};
+	};
+
+	// Immutable memory contents (font + ROM) shared by every instance running the same program.
+	class MemoryImage
+	{
+	public:
+		static constexpr uint16_t FontAddress = 0x0;
+		static constexpr uint16_t BigFontAddress = 0x50;
+		static constexpr uint16_t ProgramAddress = 0x200;
+		static constexpr uint32_t DefaultSize = 0x1000;
+		static constexpr uint32_t ExtendedSize = 0x10000;
+		static constexpr uint32_t MegaSize = 0x1000000;
+
+		explicit MemoryImage(const uint32_t size);
+
+		// Smallest of 4 KB, 64 KB (XO-CHIP) and 16 MB (MEGA-CHIP) that holds a program of
+		// program_size bytes at 0x200, or 0 if none does.
+		static uint32_t GetFittingSize(const size_t program_size);
+		static std::shared_ptr<const MemoryImage> Create(std::span<const uint8_t> program, const uint32_t size = DefaultSize);
+		static std::shared_ptr<const MemoryImage> Resize(const MemoryImage& source, const uint32_t size);
+		static const std::shared_ptr<const MemoryImage>& Blank();
+
+		uint64_t GetHash() const { return Hash; };
+		uint32_t GetSize() const { return static_cast<uint32_t>(Pages.size()) * MemoryPage::Size; };
+		uint32_t GetPageCount() const { return static_cast<uint32_t>(Pages.size()); };
+		const uint8_t* GetPage(const uint32_t page) const { return Pages[page].Bytes.data(); };
+		bool Owns(const uint8_t* page) const { return page >= Pages.front().Bytes.data() && page <= Pages.back().Bytes.data(); };
+
+	private:
+		std::vector<MemoryPage> Pages;
+		uint64_t Hash = 0;
+	};
+
+	// The private pages of a PagedMemory at one point in time. Buffers keep their capacity
+	// between captures, so saving and restoring the same program repeatedly doesn't allocate.
+	struct MemorySnapshot
+	{
+		std::shared_ptr<const MemoryImage> Image;
+		std::vector<uint32_t> PageIndices;
+		std::vector<MemoryPage> Pages;
+		uint64_t ContentHash = 0;
+	};
+
+	// Copy-on-write view over a MemoryImage. Reads go through a page table that initially points
+	// at the shared image; the first write to a page gives the instance its own private copy.
+	class PagedMemory
+	{
+	public:
+		PagedMemory();
+		~PagedMemory();
+		PagedMemory(const PagedMemory& other) = delete;
+		PagedMemory& operator=(const PagedMemory& other) = delete;
+
+		void Map(std::shared_ptr<const MemoryImage> image);
+
+		uint8_t Read(const uint32_t address) const
+		{
+			const uint32_t masked = address & AddressMask;
+			return PageTable[masked >> MemoryPage::Shift][masked & (MemoryPage::Size - 1)];
+		};
+		void Write(const uint32_t address, const uint8_t value)
+		{
+			const uint32_t masked = address & AddressMask;
+			const uint32_t page = masked >> MemoryPage::Shift;
+			uint8_t* bytes = const_cast<uint8_t*>(PageTable[page]);
+			if (Image->Owns(bytes)) [[unlikely]]
+			{
+				bytes = MakePrivate(page);
+			}
+			uint8_t& byte = bytes[masked & (MemoryPage::Size - 1)];
+			ContentHash ^= ZobristKey(masked, byte) ^ ZobristKey(masked, value);
+			byte = value;
+		};
+		uint8_t operator[](const uint32_t address) const { return Read(address); };
+		// Copies a run of bytes out a page at a time, wrapping at the end of the address space.
+		void ReadBlock(const uint32_t address, std::span<uint8_t> output) const;
+
+		uint32_t GetSize() const { return AddressMask + 1; };
+		uint32_t GetPrivatePageCount() const;
+		bool IsPrivatePage(const uint32_t page) const { return !Image->Owns(PageTable[page]); };
+		// Zobrist hash of how the contents differ from the image: the XOR, over every address, of
+		// the keys of its value and of the image's value there. Kept up to date by Write, so it
+		// costs nothing to read whatever the memory size, and is 0 while nothing differs.
+		uint64_t GetContentHash() const { return ContentHash; };
+		// The same, recomputed from the pages.
+		uint64_t ComputeContentHash() const;
+
+		void SaveTo(MemorySnapshot& snapshot) const;
+		// Pages private now but shared in the snapshot are reset to the image contents and stay
+		// private, so a restore never gives pages back or allocates new ones (unless the snapshot
+		// has a private page this view hasn't written yet, or comes from another image).
+		void RestoreFrom(const MemorySnapshot& snapshot);
+		const std::shared_ptr<const MemoryImage>& GetImage() const { return Image; };
+
+	private:
+		uint8_t* MakePrivate(const uint32_t page);
+		void ReleasePrivatePages();
+
+		std::unique_ptr<const uint8_t*[]> PageTable;
+		std::shared_ptr<const MemoryImage> Image;
+		uint64_t ContentHash = 0;
+		uint32_t AddressMask = 0;
+	};
+}
@@ -0,0 +1,200 @@
+#include "memory_search.h"
+#include <algorithm>
+#include <bit>
+#include <span>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHIPOTTO_SSE2
+#endif
+
+namespace chipotto
+{
+	static constexpr uint32_t MaxSearchSize = 0x10000;
+
+	static bool IsComparison(const SearchCondition condition)
+	{
+		return condition != SearchCondition::EqualTo && condition != SearchCondition::NotEqualTo;
+	}
+
+	static bool Matches(const SearchCondition condition, const uint8_t previous, const uint8_t current, const uint8_t operand)
+	{
+		switch (condition)
+		{
+		case SearchCondition::EqualTo: return current == operand;
+		case SearchCondition::NotEqualTo: return current != operand;
+		case SearchCondition::Unchanged: return current == previous;
+		case SearchCondition::Changed: return current != previous;
+		case SearchCondition::Increased: return current > previous;
+		case SearchCondition::Decreased: return current < previous;
+		case SearchCondition::IncreasedBy: return current == static_cast<uint8_t>(previous + operand);
+		case SearchCondition::DecreasedBy: return current == static_cast<uint8_t>(previous - operand);
+		}
+		return false;
+	}
+
+#if defined(__AVX2__)
+	// 0xFF in the bytes where condition holds. There are no unsigned byte compares: current >
+	// previous is tested as a non-zero saturating difference.
+	static __m256i Matches(const SearchCondition condition, const __m256i previous, const __m256i current, const __m256i operand)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i ones = _mm256_cmpeq_epi8(zero, zero);
+		switch (condition)
+		{
+		case SearchCondition::EqualTo: return _mm256_cmpeq_epi8(current, operand);
+		case SearchCondition::NotEqualTo: return _mm256_xor_si256(_mm256_cmpeq_epi8(current, operand), ones);
+		case SearchCondition::Unchanged: return _mm256_cmpeq_epi8(current, previous);
+		case SearchCondition::Changed: return _mm256_xor_si256(_mm256_cmpeq_epi8(current, previous), ones);
+		case SearchCondition::Increased: return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(current, previous), zero), ones);
+		case SearchCondition::Decreased: return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_subs_epu8(previous, current), zero), ones);
+		case SearchCondition::IncreasedBy: return _mm256_cmpeq_epi8(current, _mm256_add_epi8(previous, operand));
+		case SearchCondition::DecreasedBy: return _mm256_cmpeq_epi8(current, _mm256_sub_epi8(previous, operand));
+		}
+		return zero;
+	}
+#elif defined(CHIPOTTO_SSE2)
+	static __m128i Matches(const SearchCondition condition, const __m128i previous, const __m128i current, const __m128i operand)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i ones = _mm_cmpeq_epi8(zero, zero);
+		switch (condition)
+		{
+		case SearchCondition::EqualTo: return _mm_cmpeq_epi8(current, operand);
+		case SearchCondition::NotEqualTo: return _mm_xor_si128(_mm_cmpeq_epi8(current, operand), ones);
+		case SearchCondition::Unchanged: return _mm_cmpeq_epi8(current, previous);
+		case SearchCondition::Changed: return _mm_xor_si128(_mm_cmpeq_epi8(current, previous), ones);
+		case SearchCondition::Increased: return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(current, previous), zero), ones);
+		case SearchCondition::Decreased: return _mm_xor_si128(_mm_cmpeq_epi8(_mm_subs_epu8(previous, current), zero), ones);
+		case SearchCondition::IncreasedBy: return _mm_cmpeq_epi8(current, _mm_add_epi8(previous, operand));
+		case SearchCondition::DecreasedBy: return _mm_cmpeq_epi8(current, _mm_sub_epi8(previous, operand));
+		}
+		return zero;
+	}
+#endif
+
+	void MemorySearch::Reset(const Emulator& emulator)
+	{
+		Size = std::min(emulator.GetMemoryMapping().GetSize(), MaxSearchSize);
+		History.clear();
+		Candidates.assign(Size, 0xFF);
+		CandidateCount = Size;
+		Capture(emulator);
+	}
+
+	void MemorySearch::Capture(const Emulator& emulator)
+	{
+		const size_t offset = History.size();
+		History.resize(offset + Size);
+		emulator.GetMemoryMapping().ReadBlock(0, std::span<uint8_t>(History.data() + offset, Size));
+	}
+
+	void MemorySearch::ClearHistory()
+	{
+		if (History.size() <= Size) return;
+		History.erase(History.begin(), History.end() - Size);
+	}
+
+	size_t MemorySearch::Narrow(const SearchCondition condition, const uint8_t operand)
+	{
+		const size_t count = GetSnapshotCount();
+		if (count == 0) return CandidateCount;
+		return NarrowAcross(condition, operand, IsComparison(condition) && count > 1 ? count - 2 : count - 1);
+	}
+
+	size_t MemorySearch::NarrowAcross(const SearchCondition condition, const uint8_t operand, const size_t first)
+	{
+		const size_t count = GetSnapshotCount();
+		// Value conditions look at each snapshot, comparisons at each snapshot after the first.
+		const size_t start = IsComparison(condition) ? first + 1 : first;
+		if (start >= count) return CandidateCount;
+
+		const uint8_t* history = History.data();
+		uint8_t* candidates = Candidates.data();
+		size_t remaining = 0;
+		uint32_t address = 0;
+#if defined(__AVX2__)
+		const __m256i operand_vector = _mm256_set1_epi8(static_cast<char>(operand));
+		for (; address + 32 <= Size; address += 32)
+		{
+			__m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(candidates + address));
+			// Late in a search almost every chunk is already empty.
+			if (_mm256_testz_si256(mask, mask)) continue;
+			for (size_t snapshot = start; snapshot < count && !_mm256_testz_si256(mask, mask); ++snapshot)
+			{
+				const uint8_t* current = history + snapshot * Size + address;
+				const __m256i current_vector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current));
+				const __m256i previous_vector = snapshot > 0 ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(current - Size)) : current_vector;
+				mask = _mm256_and_si256(mask, Matches(condition, previous_vector, current_vector, operand_vector));
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(candidates + address), mask);
+			remaining += std::popcount(static_cast<uint32_t>(_mm256_movemask_epi8(mask)));
+		}
+#elif defined(CHIPOTTO_SSE2)
+		const __m128i operand_vector = _mm_set1_epi8(static_cast<char>(operand));
+		for (; address + 16 <= Size; address += 16)
+		{
+			__m128i mask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidates + address));
+			int bits = _mm_movemask_epi8(mask);
+			for (size_t snapshot = start; snapshot < count && bits; ++snapshot)
+			{
+				const uint8_t* current = history + snapshot * Size + address;
+				const __m128i current_vector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+				const __m128i previous_vector = snapshot > 0 ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(current - Size)) : current_vector;
+				mask = _mm_and_si128(mask, Matches(condition, previous_vector, current_vector, operand_vector));
+				bits = _mm_movemask_epi8(mask);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(candidates + address), mask);
+			remaining += std::popcount(static_cast<uint32_t>(bits));
+		}
+#endif
+		for (; address < Size; ++address)
+		{
+			for (size_t snapshot = start; snapshot < count && candidates[address]; ++snapshot)
+			{
+				const uint8_t* current = history + snapshot * Size + address;
+				if (!Matches(condition, snapshot > 0 ? *(current - Size) : *current, *current, operand)) candidates[address] = 0;
+			}
+			if (candidates[address]) remaining++;
+		}
+		CandidateCount = remaining;
+		return remaining;
+	}
+
+	std::vector<uint32_t> MemorySearch::GetCandidates() const
+	{
+		std::vector<uint32_t> addresses;
+		addresses.reserve(CandidateCount);
+		for (uint32_t address = 0; address < Size; ++address)
+		{
+			if (Candidates[address]) addresses.push_back(address);
+		}
+		return addresses;
+	}
+
+	void CheatTable::Freeze(const uint32_t address, const uint8_t value)
+	{
+		for (FrozenValue& frozen : Frozen)
+		{
+			if (frozen.Address != address) continue;
+			frozen.Value = value;
+			return;
+		}
+		Frozen.push_back({ address, value });
+	}
+
+	void CheatTable::Unfreeze(const uint32_t address)
+	{
+		std::erase_if(Frozen, [address](const FrozenValue& frozen) { return frozen.Address == address; });
+	}
+
+	void CheatTable::Apply(Emulator& emulator) const
+	{
+		for (const FrozenValue& frozen : Frozen)
+		{
+			emulator.WriteMemory(frozen.Address, frozen.Value);
+		}
+	}
+}
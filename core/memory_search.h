@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "chip-8.h"
+
+namespace chipotto
+{
+	enum class SearchCondition : uint8_t
+	{
+		// The value equals, or differs from, the operand.
+		EqualTo,
+		NotEqualTo,
+		// Comparisons with the previous snapshot. Values are unsigned bytes; IncreasedBy and
+		// DecreasedBy wrap around like the 7xnn and 8xy5 arithmetic that usually produces them.
+		Unchanged,
+		Changed,
+		Increased,
+		Decreased,
+		IncreasedBy,
+		DecreasedBy
+	};
+
+	// Finds the RAM bytes holding a game variable (lives, score, a position) by narrowing a
+	// candidate set over snapshots of memory: capture, play, capture, and keep the addresses
+	// whose values behaved as the variable did. Found addresses are plain addresses, ready for
+	// RewardSource::Address or EnvironmentConfig::DoneAddress.
+	//
+	// Snapshots cover the first 64 KB at most: all of CHIP-8 and XO-CHIP memory, and the part
+	// of MEGA-CHIP's where programs keep their variables. They are stored back to back and
+	// candidates are a byte mask, so a narrowing pass walks the mask once, 32 (AVX2) or 16
+	// (SSE2) addresses at a time, checking each chunk against every snapshot it covers before
+	// moving on.
+	class MemorySearch
+	{
+	public:
+		// Starts over with every address a candidate and one snapshot of emulator.
+		void Reset(const Emulator& emulator);
+		void Capture(const Emulator& emulator);
+		// Drops all snapshots but the newest, keeping the candidates.
+		void ClearHistory();
+
+		// Keeps the candidates for which condition holds in the newest snapshot (EqualTo,
+		// NotEqualTo) or between it and the one before. Returns how many are left.
+		size_t Narrow(const SearchCondition condition, const uint8_t operand = 0);
+		// The same, over every snapshot from first to the newest: value conditions must hold in
+		// each of them and comparisons between each consecutive pair.
+		size_t NarrowAcross(const SearchCondition condition, const uint8_t operand, const size_t first);
+
+		uint32_t GetSize() const { return Size; };
+		size_t GetSnapshotCount() const { return Size ? History.size() / Size : 0; };
+		uint8_t GetValue(const size_t snapshot, const uint32_t address) const { return History[snapshot * Size + address]; };
+		size_t GetCandidateCount() const { return CandidateCount; };
+		bool IsCandidate(const uint32_t address) const { return address < Size && Candidates[address]; };
+		std::vector<uint32_t> GetCandidates() const;
+
+	private:
+		uint32_t Size = 0;
+		std::vector<uint8_t> History;
+		// 0xFF for candidates, 0 for rejected addresses.
+		std::vector<uint8_t> Candidates;
+		size_t CandidateCount = 0;
+	};
+
+	// Values held in place: Apply writes them back every frame, before the frame runs.
+	class CheatTable
+	{
+	public:
+		struct FrozenValue
+		{
+			uint32_t Address = 0;
+			uint8_t Value = 0;
+		};
+
+		// Freezing an address again replaces its value.
+		void Freeze(const uint32_t address, const uint8_t value);
+		void Unfreeze(const uint32_t address);
+		void Clear() { Frozen.clear(); };
+		const std::vector<FrozenValue>& GetFrozen() const { return Frozen; };
+
+		void Apply(Emulator& emulator) const;
+
+	private:
+		std::vector<FrozenValue> Frozen;
+	};
+}
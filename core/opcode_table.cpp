@@ -0,0 +1,115 @@
+#include "opcode_table.h"
+#include <array>
+#include "mega_chip.h"
+
+namespace chipotto
+{
+	static_assert(static_cast<int>(MegaScreen::BlendMode::Multiply) == 4, "080n has one form per blend mode");
+
+	static constexpr OpcodeForm Forms[] =
+	{
+		{ 0xFFFF, 0x0010, "MEGAOFF" },
+		{ 0xFFFF, 0x0011, "MEGAON" },
+		{ 0xFFF0, 0x00B0, "SCU %n" },
+		{ 0xFFF0, 0x00C0, "SCD %n" },
+		{ 0xFFF0, 0x00D0, "SCU %n" },
+		{ 0xFFFF, 0x00E0, "CLS" },
+		{ 0xFFFF, 0x00EE, "RET", ControlFlow::Dynamic },
+		{ 0xFFFF, 0x00FB, "SCR" },
+		{ 0xFFFF, 0x00FC, "SCL" },
+		{ 0xFFFF, 0x00FD, "EXIT", ControlFlow::Dynamic },
+		{ 0xFFFF, 0x00FE, "LOW" },
+		{ 0xFFFF, 0x00FF, "HIGH" },
+		{ 0xFF00, 0x0100, "LDHI I, %h", ControlFlow::Next, 4, true },
+		{ 0xFF00, 0x0200, "LDPAL %b", ControlFlow::Next, 2, true },
+		{ 0xFF00, 0x0300, "SPRW %b", ControlFlow::Next, 2, true },
+		{ 0xFF00, 0x0400, "SPRH %b", ControlFlow::Next, 2, true },
+		{ 0xFF00, 0x0500, "ALPHA %b", ControlFlow::Next, 2, true },
+		{ 0xFF00, 0x0600, "DIGISND", ControlFlow::Next, 2, true },
+		{ 0xFF00, 0x0700, "STOPSND", ControlFlow::Next, 2, true },
+		{ 0xFF0F, 0x0800, "BMODE %n", ControlFlow::Next, 2, true },
+		{ 0xFF0F, 0x0801, "BMODE %n", ControlFlow::Next, 2, true },
+		{ 0xFF0F, 0x0802, "BMODE %n", ControlFlow::Next, 2, true },
+		{ 0xFF0F, 0x0803, "BMODE %n", ControlFlow::Next, 2, true },
+		{ 0xFF0F, 0x0804, "BMODE %n", ControlFlow::Next, 2, true },
+		{ 0xFF00, 0x0900, "CCOL %b", ControlFlow::Next, 2, true },
+		{ 0xF000, 0x1000, "JP %a", ControlFlow::Jump },
+		{ 0xF000, 0x2000, "CALL %a", ControlFlow::Call },
+		{ 0xF000, 0x3000, "SE %x, %b", ControlFlow::Skip },
+		{ 0xF000, 0x4000, "SNE %x, %b", ControlFlow::Skip },
+		{ 0xF00F, 0x5000, "SE %x, %y", ControlFlow::Skip },
+		{ 0xF00F, 0x5002, "SAVE %x - %y" },
+		{ 0xF00F, 0x5003, "LOAD %x - %y" },
+		{ 0xF000, 0x6000, "LD %x, %b" },
+		{ 0xF000, 0x7000, "ADD %x, %b" },
+		{ 0xF00F, 0x8000, "LD %x, %y" },
+		{ 0xF00F, 0x8001, "OR %x, %y" },
+		{ 0xF00F, 0x8002, "AND %x, %y" },
+		{ 0xF00F, 0x8003, "XOR %x, %y" },
+		{ 0xF00F, 0x8004, "ADD %x, %y" },
+		{ 0xF00F, 0x8005, "SUB %x, %y" },
+		// VY is only read under the ShiftUsesVY quirk.
+		{ 0xF00F, 0x8006, "SHR %x{, %y}" },
+		{ 0xF00F, 0x8007, "SUBN %x, %y" },
+		{ 0xF00F, 0x800E, "SHL %x{, %y}" },
+		// The low nibble is ignored.
+		{ 0xF000, 0x9000, "SNE %x, %y", ControlFlow::Skip },
+		{ 0xF000, 0xA000, "LD I, %a" },
+		// Under the JumpUsesVX quirk the register added is VX rather than V0.
+		{ 0xF000, 0xB000, "JP V0, %a", ControlFlow::Dynamic },
+		{ 0xF000, 0xC000, "RND %x, %b" },
+		{ 0xF000, 0xD000, "DRW %x, %y, %n" },
+		{ 0xF0FF, 0xE09E, "SKP %x", ControlFlow::Skip },
+		{ 0xF0FF, 0xE0A1, "SKNP %x", ControlFlow::Skip },
+		{ 0xFFFF, 0xF000, "LD I, long %l", ControlFlow::Next, 4 },
+		{ 0xFFFF, 0xF002, "AUDIO" },
+		{ 0xF0FF, 0xF001, "PLANE %X" },
+		{ 0xF0FF, 0xF007, "LD %x, DT" },
+		{ 0xF0FF, 0xF00A, "LD %x, K", ControlFlow::Wait },
+		{ 0xF0FF, 0xF015, "LD DT, %x" },
+		{ 0xF0FF, 0xF018, "LD ST, %x" },
+		{ 0xF0FF, 0xF01E, "ADD I, %x" },
+		{ 0xF0FF, 0xF029, "LD F, %x" },
+		{ 0xF0FF, 0xF030, "LD HF, %x" },
+		{ 0xF0FF, 0xF033, "LD B, %x" },
+		{ 0xF0FF, 0xF03A, "PITCH %x" },
+		{ 0xF0FF, 0xF055, "LD [I], %x" },
+		{ 0xF0FF, 0xF065, "LD %x, [I]" },
+		{ 0xF0FF, 0xF075, "LD R, %x" },
+		{ 0xF0FF, 0xF085, "LD %x, R" },
+	};
+
+	// Where each top nibble's forms start in Forms, so a lookup only scans its own group.
+	static constexpr std::array<uint8_t, 0x11> GroupStarts = []()
+		{
+			std::array<uint8_t, 0x11> starts{};
+			size_t form = 0;
+			for (size_t group = 0; group <= 0x10; ++group)
+			{
+				while (form < std::size(Forms) && (Forms[form].Match >> 12) < group) ++form;
+				starts[group] = static_cast<uint8_t>(form);
+			}
+			return starts;
+		}();
+
+	std::span<const OpcodeForm> GetOpcodeForms()
+	{
+		return Forms;
+	}
+
+	const OpcodeForm* FindOpcodeForm(const uint16_t opcode)
+	{
+		const size_t group = opcode >> 12;
+		for (size_t form = GroupStarts[group]; form < GroupStarts[group + 1]; ++form)
+		{
+			if ((opcode & Forms[form].Mask) == Forms[form].Match) return &Forms[form];
+		}
+		return nullptr;
+	}
+
+	bool IsValidOpcode(const uint16_t opcode, const QuirkProfile quirks)
+	{
+		const OpcodeForm* form = FindOpcodeForm(opcode);
+		return form && (!form->MegaOnly || quirks == QuirkProfile::MegaChip);
+	}
+}
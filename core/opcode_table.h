@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include "quirks.h"
+
+namespace chipotto
+{
+	enum class ControlFlow : uint8_t
+	{
+		// Runs on to the next instruction.
+		Next,
+		// Static jump (1nnn).
+		Jump,
+		// Subroutine call (2nnn); execution comes back after it.
+		Call,
+		// Conditional skip over the following instruction.
+		Skip,
+		// Waits for a key press (Fx0A), then resumes after it.
+		Wait,
+		// Successor only known at run time: 00EE, 00FD, Bnnn and invalid opcodes.
+		Dynamic
+	};
+
+	// One instruction form: the opcodes with opcode & Mask == Match.
+	struct OpcodeForm
+	{
+		uint16_t Mask = 0;
+		uint16_t Match = 0;
+		// Mnemonic with operand fields: %x and %y for VX and VY, %X for the X nibble, %n for the
+		// low nibble, %b for the low byte, %a for the address, %l for the second word and %h for
+		// the 24-bit address of 01nn nnnn.
+		const char* Format = nullptr;
+		ControlFlow Flow = ControlFlow::Next;
+		// 4 for XO-CHIP's F000 nnnn and MEGA-CHIP's 01nn nnnn.
+		uint8_t Length = 2;
+		// Only implemented while MEGA-CHIP mode is on (0011).
+		bool MegaOnly = false;
+	};
+
+	// Every form some interpreter handler implements, in the order the handlers test them.
+	// The disassembler and the ROM analyser decode through it; test/opcode_table_test.cpp runs
+	// every opcode through the interpreter to keep the two in step.
+	std::span<const OpcodeForm> GetOpcodeForms();
+	// The form opcode belongs to, or nullptr if no handler implements it.
+	const OpcodeForm* FindOpcodeForm(const uint16_t opcode);
+	// Whether opcode runs under quirks. MEGA-CHIP forms are taken to need the MEGA-CHIP profile.
+	bool IsValidOpcode(const uint16_t opcode, const QuirkProfile quirks);
+}
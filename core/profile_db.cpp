@@ -0,0 +1,64 @@
+#include "profile_db.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace chipotto
+{
+	bool ProfileDatabase::LoadFromFile(const std::filesystem::path& Path)
+	{
+		std::ifstream file(Path);
+		if (!file.is_open()) return false;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			if (line.empty() || line[0] == '#') continue;
+
+			std::istringstream fields(line);
+			uint64_t hash;
+			std::string quirks;
+			int idle_skip;
+			int recompiler;
+			ExecutionProfile profile;
+			if (!(fields >> std::hex >> hash >> std::dec >> profile.InstructionsPerFrame >> quirks >> idle_skip >> recompiler))
+				return false;
+			if (!ParseQuirkProfile(quirks, profile.Quirks))
+				return false;
+			profile.IdleSkipSafe = idle_skip != 0;
+			profile.RecompilerEligible = recompiler != 0;
+			if (!(fields >> profile.RunAheadFrames))
+				profile.RunAheadFrames = 0;
+			Profiles[hash] = profile;
+		}
+		return true;
+	}
+
+	bool ProfileDatabase::SaveToFile(const std::filesystem::path& Path) const
+	{
+		std::ofstream file(Path, std::ios::trunc);
+		if (!file.is_open()) return false;
+
+		file << "# hash instructions_per_frame quirks idle_skip recompiler run_ahead\n";
+		for (const auto& pair : Profiles)
+		{
+			const ExecutionProfile& profile = pair.second;
+			file << std::hex << pair.first << std::dec << ' ' << profile.InstructionsPerFrame << ' ' << GetQuirkProfileName(profile.Quirks)
+				<< ' ' << (profile.IdleSkipSafe ? 1 : 0) << ' ' << (profile.RecompilerEligible ? 1 : 0) << ' ' << profile.RunAheadFrames << '\n';
+		}
+		return file.good();
+	}
+
+	const ExecutionProfile* ProfileDatabase::Find(const uint64_t hash) const
+	{
+		auto it = Profiles.find(hash);
+		if (it == Profiles.end()) return nullptr;
+		return &it->second;
+	}
+
+	ExecutionProfile ProfileDatabase::Lookup(const uint64_t hash) const
+	{
+		const ExecutionProfile* profile = Find(hash);
+		return profile ? *profile : ExecutionProfile{};
+	}
+}
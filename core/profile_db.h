@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+#include "quirks.h"
+
+namespace chipotto
+{
+	struct ExecutionProfile
+	{
+		uint32_t InstructionsPerFrame = 10;
+		QuirkProfile Quirks = QuirkProfile::Chipotto;
+		bool IdleSkipSafe = false;
+		bool RecompilerEligible = false;
+		// Frames of built-in input lag to hide with run-ahead (see RunAhead).
+		uint32_t RunAheadFrames = 0;
+	};
+
+	// Maps ROM content hashes (see HashRom) to the fastest known-correct way of running them.
+	// The on-disk format is one ROM per line:
+	//   <hash in hex> <instructions per frame> <quirk profile> <idle skip 0|1> <recompiler 0|1> [run-ahead frames]
+	// Empty lines and lines starting with '#' are ignored.
+	class ProfileDatabase
+	{
+	public:
+		bool LoadFromFile(const std::filesystem::path& Path);
+		bool SaveToFile(const std::filesystem::path& Path) const;
+
+		void Set(const uint64_t hash, const ExecutionProfile& profile) { Profiles[hash] = profile; };
+		const ExecutionProfile* Find(const uint64_t hash) const;
+		ExecutionProfile Lookup(const uint64_t hash) const;
+		size_t GetCount() const { return Profiles.size(); };
+
+	private:
+		std::unordered_map<uint64_t, ExecutionProfile> Profiles;
+	};
+}
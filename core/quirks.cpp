@@ -0,0 +1,30 @@
+#include "quirks.h"
+
+namespace chipotto
+{
+	const char* GetQuirkProfileName(const QuirkProfile profile)
+	{
+		switch (profile)
+		{
+		case QuirkProfile::Chipotto: return "chipotto";
+		case QuirkProfile::CosmacVip: return "cosmac-vip";
+		case QuirkProfile::SuperChip: return "super-chip";
+		case QuirkProfile::XoChip: return "xo-chip";
+		case QuirkProfile::MegaChip: return "mega-chip";
+		}
+		return "unknown";
+	}
+
+	bool ParseQuirkProfile(std::string_view name, QuirkProfile& profile)
+	{
+		for (const QuirkProfile candidate : { QuirkProfile::Chipotto, QuirkProfile::CosmacVip, QuirkProfile::SuperChip, QuirkProfile::XoChip, QuirkProfile::MegaChip })
+		{
+			if (name == GetQuirkProfileName(candidate))
+			{
+				profile = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+}
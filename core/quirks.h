@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace chipotto
+{
+	// Behaviour differences between CHIP-8 interpreters that ROMs from different origins rely on.
+	enum class QuirkProfile : uint8_t
+	{
+		Chipotto,
+		CosmacVip,
+		SuperChip,
+		XoChip,
+		MegaChip
+	};
+
+	// Compile-time quirk sets. Each one instantiates its own copy of the handlers that differ,
+	// so the interpreter never tests a quirk flag while running.
+	//   ShiftUsesVY           8xy6/8xyE shift VY into VX instead of shifting VX in place
+	//   LoadStoreIncrementsI  Fx55/Fx65 leave I pointing past the last register
+	//   JumpUsesVX            Bxnn jumps to xnn + VX instead of nnn + V0
+	//   WrapSprites           Dxyn wraps pixels around the screen edges instead of clipping
+	//   LogicResetsVF         8xy1/8xy2/8xy3 clear VF
+	struct ChipottoQuirks
+	{
+		static constexpr QuirkProfile Profile = QuirkProfile::Chipotto;
+		static constexpr bool ShiftUsesVY = false;
+		static constexpr bool LoadStoreIncrementsI = false;
+		static constexpr bool JumpUsesVX = false;
+		static constexpr bool WrapSprites = false;
+		static constexpr bool LogicResetsVF = false;
+	};
+
+	struct CosmacVipQuirks
+	{
+		static constexpr QuirkProfile Profile = QuirkProfile::CosmacVip;
+		static constexpr bool ShiftUsesVY = true;
+		static constexpr bool LoadStoreIncrementsI = true;
+		static constexpr bool JumpUsesVX = false;
+		static constexpr bool WrapSprites = false;
+		static constexpr bool LogicResetsVF = true;
+	};
+
+	struct SuperChipQuirks
+	{
+		static constexpr QuirkProfile Profile = QuirkProfile::SuperChip;
+		static constexpr bool ShiftUsesVY = false;
+		static constexpr bool LoadStoreIncrementsI = false;
+		static constexpr bool JumpUsesVX = true;
+		static constexpr bool WrapSprites = false;
+		static constexpr bool LogicResetsVF = false;
+	};
+
+	struct XoChipQuirks
+	{
+		static constexpr QuirkProfile Profile = QuirkProfile::XoChip;
+		static constexpr bool ShiftUsesVY = true;
+		static constexpr bool LoadStoreIncrementsI = true;
+		static constexpr bool JumpUsesVX = false;
+		static constexpr bool WrapSprites = true;
+		static constexpr bool LogicResetsVF = false;
+	};
+
+	// MEGA-CHIP extends SUPER-CHIP and keeps its behaviour.
+	struct MegaChipQuirks
+	{
+		static constexpr QuirkProfile Profile = QuirkProfile::MegaChip;
+		static constexpr bool ShiftUsesVY = false;
+		static constexpr bool LoadStoreIncrementsI = false;
+		static constexpr bool JumpUsesVX = true;
+		static constexpr bool WrapSprites = false;
+		static constexpr bool LogicResetsVF = false;
+	};
+
+	const char* GetQuirkProfileName(const QuirkProfile profile);
+	bool ParseQuirkProfile(std::string_view name, QuirkProfile& profile);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace chipotto
+{
+	// xoshiro128** generator for Cxnn. Each Emulator owns one, so instances never share or
+	// lock random state, and a run is reproducible from its seed on every platform. The state
+	// is plain data and travels with save states.
+	class Random
+	{
+	public:
+		static constexpr uint64_t DefaultSeed = 0x43484950384F5454ULL;
+
+		Random() { Seed(DefaultSeed); };
+		explicit Random(const uint64_t seed) { Seed(seed); };
+
+		// Expands the seed with SplitMix64, as recommended by the xoshiro authors.
+		void Seed(uint64_t seed)
+		{
+			for (size_t i = 0; i < State.size(); i += 2)
+			{
+				uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+				z ^= z >> 31;
+				State[i] = static_cast<uint32_t>(z);
+				State[i + 1] = static_cast<uint32_t>(z >> 32);
+			}
+		}
+
+		uint32_t Next()
+		{
+			const uint32_t result = Rotate(State[1] * 5, 7) * 9;
+			const uint32_t t = State[1] << 9;
+			State[2] ^= State[0];
+			State[3] ^= State[1];
+			State[1] ^= State[2];
+			State[0] ^= State[3];
+			State[2] ^= t;
+			State[3] = Rotate(State[3], 11);
+			return result;
+		}
+
+		// The top bits are the strongest ones.
+		uint8_t NextByte() { return static_cast<uint8_t>(Next() >> 24); };
+
+		const std::array<uint32_t, 4>& GetState() const { return State; };
+		bool operator==(const Random& other) const { return State == other.State; };
+	private:
+		static uint32_t Rotate(const uint32_t value, const int bits) { return (value << bits) | (value >> (32 - bits)); };
+
+		std::array<uint32_t, 4> State;
+	};
+}
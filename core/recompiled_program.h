@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "chip-8.h"
+
+namespace chipotto
+{
+	// Entry point of a ROM translated to C++ by the static recompiler (see recompiler.h).
+	// RunFrame behaves like Emulator::RunFrame without idle skipping. It hands the frame to
+	// the interpreter when the emulator isn't running the ROM and quirk profile it was
+	// generated from.
+	struct RecompiledProgram
+	{
+		uint64_t ProgramHash = 0;
+		QuirkProfile Quirks = QuirkProfile::Chipotto;
+		bool (*RunFrame)(Emulator& emulator, const uint32_t instructions) = nullptr;
+
+		bool Matches(const Emulator& emulator) const { return emulator.GetProgramHash() == ProgramHash && emulator.GetQuirks() == Quirks; };
+	};
+
+	// Table of translated ROMs, defined in the recompiled_library.cpp the recompiler tool writes
+	// next to them. Only programs that link that file may use it.
+	extern const RecompiledProgram* const RecompiledLibrary[];
+	extern const size_t RecompiledLibrarySize;
+
+	inline const RecompiledProgram* FindRecompiledProgram(const RecompiledProgram* const* library, const size_t size, const Emulator& emulator)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			if (library[i]->Matches(emulator)) return library[i];
+		}
+		return nullptr;
+	}
+
+	// Applies a handler's status the way Emulator::Tick does. Used by generated code.
+	inline bool CompleteRecompiledInstruction(CpuState& cpu, const OpcodeStatus status)
+	{
+		if (status == OpcodeStatus::IncrementPC)
+		{
+			cpu.PC += 2;
+			return true;
+		}
+		return status != OpcodeStatus::NotImplemented && status != OpcodeStatus::StackOverflow && status != OpcodeStatus::Error && status != OpcodeStatus::Exit;
+	}
+
+	// True when a translated range no longer holds the ROM's bytes. Only pages the program has
+	// written to can differ, so code in untouched pages costs one page table lookup.
+	inline bool IsRecompiledCodeModified(const PagedMemory& memory, const uint32_t address, const uint32_t length)
+	{
+		const MemoryImage& image = *memory.GetImage();
+		for (uint32_t offset = 0; offset < length; ++offset)
+		{
+			const uint32_t byte_address = address + offset;
+			const uint32_t page = byte_address >> MemoryPage::Shift;
+			if (!memory.IsPrivatePage(page))
+			{
+				// Jump to the start of the next page.
+				offset += MemoryPage::Size - 1 - (byte_address & (MemoryPage::Size - 1));
+				continue;
+			}
+			if (memory[byte_address] != image.GetPage(page)[byte_address & (MemoryPage::Size - 1)]) return true;
+		}
+		return false;
+	}
+}
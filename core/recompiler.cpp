@@ -0,0 +1,327 @@
+#include "recompiler.h"
+#include <cctype>
+#include <cstdio>
+#include <vector>
+#include "disassembler.h"
+#include "rom_analysis.h"
+
+namespace chipotto
+{
+	static std::string Hex(const uint32_t value, const int digits)
+	{
+		char text[16];
+		std::snprintf(text, sizeof(text), "0x%0*X", digits, value);
+		return text;
+	}
+
+	static std::string Hex64(const uint64_t value)
+	{
+		char text[24];
+		std::snprintf(text, sizeof(text), "0x%016llX", static_cast<unsigned long long>(value));
+		return text;
+	}
+
+	static std::string Register(const uint32_t index)
+	{
+		char text[16];
+		std::snprintf(text, sizeof(text), "v[0x%X]", index & 0xF);
+		return text;
+	}
+
+	static const char* GetQuirksTypeName(const QuirkProfile quirks)
+	{
+		switch (quirks)
+		{
+		case QuirkProfile::CosmacVip: return "chipotto::CosmacVipQuirks";
+		case QuirkProfile::SuperChip: return "chipotto::SuperChipQuirks";
+		case QuirkProfile::XoChip: return "chipotto::XoChipQuirks";
+		case QuirkProfile::MegaChip: return "chipotto::MegaChipQuirks";
+		default: return "chipotto::ChipottoQuirks";
+		}
+	}
+
+	static const char* GetQuirksEnumName(const QuirkProfile quirks)
+	{
+		switch (quirks)
+		{
+		case QuirkProfile::CosmacVip: return "chipotto::QuirkProfile::CosmacVip";
+		case QuirkProfile::SuperChip: return "chipotto::QuirkProfile::SuperChip";
+		case QuirkProfile::XoChip: return "chipotto::QuirkProfile::XoChip";
+		case QuirkProfile::MegaChip: return "chipotto::QuirkProfile::MegaChip";
+		default: return "chipotto::QuirkProfile::Chipotto";
+		}
+	}
+
+	static std::string HandlerCall(const uint16_t opcode)
+	{
+		static const char* const Handlers[0x10] =
+		{
+			"Opcode0", "Opcode1", "Opcode2", "Opcode3", "Opcode4", "Opcode5", "Opcode6", "Opcode7",
+			"Opcode8<Quirks>", "Opcode9", "OpcodeA", "OpcodeB<Quirks>", "OpcodeC", "OpcodeD<Quirks>", "OpcodeE", "OpcodeF<Quirks>"
+		};
+		return std::string("emu.") + Handlers[opcode >> 12] + "(" + Hex(opcode, 4) + ")";
+	}
+
+	// Plain C++ for instructions that only touch registers, I and the timers, or an empty
+	// string when the handler has to run. Must match the OpcodeN handlers exactly.
+	template<typename Quirks>
+	static std::string InlineInstruction(const uint16_t opcode)
+	{
+		const std::string vx = Register(opcode >> 8);
+		const std::string vy = Register(opcode >> 4);
+		const std::string value = Hex(opcode & 0xFF, 2);
+		switch (opcode >> 12)
+		{
+		case 0x6:
+			return vx + " = " + value + ";";
+		case 0x7:
+			return vx + " += " + value + ";";
+		case 0xA:
+			return "cpu.I = " + Hex(opcode & 0xFFF, 3) + ";";
+		case 0x8:
+		{
+			const std::string reset_vf = Quirks::LogicResetsVF ? " v[0xF] = 0;" : "";
+			const std::string& source = Quirks::ShiftUsesVY ? vy : vx;
+			switch (opcode & 0xF)
+			{
+			case 0x0: return vx + " = " + vy + ";";
+			case 0x1: return vx + " |= " + vy + ";" + reset_vf;
+			case 0x2: return vx + " &= " + vy + ";" + reset_vf;
+			case 0x3: return vx + " ^= " + vy + ";" + reset_vf;
+			case 0x4: return "v[0xF] = " + vx + " + " + vy + " > 255 ? 1 : 0; " + vx + " += " + vy + ";";
+			case 0x5: return "v[0xF] = " + vx + " > " + vy + " ? 1 : 0; " + vx + " -= " + vy + ";";
+			case 0x6: return "{ const uint8_t source = " + source + "; " + vx + " = static_cast<uint8_t>(source >> 1); v[0xF] = source & 0x1; }";
+			case 0x7: return "{ const uint8_t flag = " + vy + " > " + vx + " ? 1 : 0; " + vx + " = static_cast<uint8_t>(" + vy + " - " + vx + "); v[0xF] = flag; }";
+			case 0xE: return "{ const uint8_t source = " + source + "; " + vx + " = static_cast<uint8_t>(source << 1); v[0xF] = source >> 7; }";
+			}
+			return "";
+		}
+		case 0xF:
+			switch (opcode & 0xFF)
+			{
+			case 0x07: return vx + " = cpu.DelayTimer;";
+			case 0x15: return "cpu.DelayTimer = " + vx + ";";
+			case 0x18: return "cpu.SoundTimer = " + vx + ";";
+			case 0x1E: return "cpu.I += " + vx + ";";
+			case 0x29: return "cpu.I = 5 * " + vx + ";";
+			}
+			return "";
+		}
+		return "";
+	}
+
+	static std::string InlineInstruction(const uint16_t opcode, const QuirkProfile quirks)
+	{
+		switch (quirks)
+		{
+		case QuirkProfile::CosmacVip: return InlineInstruction<CosmacVipQuirks>(opcode);
+		case QuirkProfile::SuperChip: return InlineInstruction<SuperChipQuirks>(opcode);
+		case QuirkProfile::XoChip: return InlineInstruction<XoChipQuirks>(opcode);
+		case QuirkProfile::MegaChip: return InlineInstruction<MegaChipQuirks>(opcode);
+		default: return InlineInstruction<ChipottoQuirks>(opcode);
+		}
+	}
+
+	static std::string SkipCondition(const uint16_t opcode)
+	{
+		const std::string vx = Register(opcode >> 8);
+		const std::string vy = Register(opcode >> 4);
+		switch (opcode >> 12)
+		{
+		case 0x3: return vx + " == " + Hex(opcode & 0xFF, 2);
+		case 0x4: return vx + " != " + Hex(opcode & 0xFF, 2);
+		case 0x5: return vx + " == " + vy;
+		case 0x9: return vx + " != " + vy;
+		}
+		const char* pressed = (opcode & 0xFF) == 0x9E ? "1" : "0";
+		return "((cpu.Keys >> (" + vx + " & 0xF)) & 0x1) == " + pressed;
+	}
+
+	static std::string BlockName(const uint32_t address)
+	{
+		char text[16];
+		std::snprintf(text, sizeof(text), "Block_%04X", address);
+		return text;
+	}
+
+	static void EmitBlock(std::string& out, const MemoryImage& image, const BasicBlock& block, const QuirkProfile quirks, RecompilerStats& stats)
+	{
+		out += "\tbool " + BlockName(block.Start) + "(Emulator& emu, CpuState& cpu)\n\t{\n";
+		out += "\t\t[[maybe_unused]] auto& v = cpu.Registers;\n";
+
+		// What cpu.PC holds at this point of the block, so handler calls only store it when needed.
+		uint32_t pc = block.Start;
+		uint32_t address = block.Start;
+		bool ends_in_fall_through = false;
+		while (address < block.End)
+		{
+			const DecodedInstruction instruction = DecodeInstruction(image, address, quirks);
+			const uint32_t next = address + instruction.Length;
+			const std::string set_pc = pc != address ? "cpu.PC = " + Hex(address, 4) + ";\n\t\t" : "";
+			const std::string handler = "chipotto::CompleteRecompiledInstruction(cpu, " + HandlerCall(instruction.Opcode) + ")";
+			char mnemonic[MaxDisassemblyLength];
+			Disassemble(instruction.Opcode, instruction.Operand, quirks, mnemonic);
+			out += "\t\t// " + Hex(address, 4) + ": " + Hex(instruction.Opcode, 4) + "  " + mnemonic + "\n\t\t";
+			stats.Instructions++;
+			ends_in_fall_through = instruction.Flow == ControlFlow::Next;
+
+			switch (instruction.Flow)
+			{
+			case ControlFlow::Next:
+			{
+				const std::string inlined = InlineInstruction(instruction.Opcode, quirks);
+				if (!inlined.empty())
+				{
+					out += inlined + "\n";
+					stats.Inlined++;
+				}
+				else
+				{
+					out += set_pc + "if (!" + handler + ") return false;\n";
+					pc = next;
+				}
+				break;
+			}
+			case ControlFlow::Jump:
+				out += "cpu.PC = " + Hex(instruction.Target, 4) + ";\n\t\treturn true;\n";
+				stats.Inlined++;
+				break;
+			case ControlFlow::Skip:
+			{
+				const uint32_t target = block.Successors[1];
+				if (target != BasicBlock::NoSuccessor)
+				{
+					out += "cpu.PC = " + SkipCondition(instruction.Opcode) + " ? " + Hex(target & 0xFFFF, 4) + " : " + Hex(next & 0xFFFF, 4) + ";\n\t\treturn true;\n";
+					stats.Inlined++;
+				}
+				else
+				{
+					out += set_pc + "return " + handler + ";\n";
+				}
+				break;
+			}
+			default:
+				out += set_pc + "return " + handler + ";\n";
+				break;
+			}
+			address = next;
+		}
+
+		if (ends_in_fall_through)
+		{
+			// The next instruction starts another block or lies outside the ROM.
+			out += "\t\tcpu.PC = " + Hex(block.End & 0xFFFF, 4) + ";\n\t\treturn true;\n";
+		}
+		out += "\t}\n\n";
+	}
+
+	// 5xy2, Fx33 and Fx55, the instructions that store to memory.
+	static bool IsStore(const uint16_t opcode)
+	{
+		switch (opcode >> 12)
+		{
+		case 0x5: return (opcode & 0xF) == 0x2;
+		case 0xF: return (opcode & 0xFF) == 0x33 || (opcode & 0xFF) == 0x55;
+		default: return false;
+		}
+	}
+
+	// Blocks that may store into code are cut after each store, so what follows only runs
+	// once the dispatcher has checked it still holds the ROM's bytes.
+	static std::vector<BasicBlock> SplitAfterStores(const MemoryImage& image, const RomAnalysis& analysis)
+	{
+		std::vector<BasicBlock> blocks;
+		for (const BasicBlock& block : analysis.Blocks)
+		{
+			if (!block.WritesCode && !block.UnresolvedWrite)
+			{
+				blocks.push_back(block);
+				continue;
+			}
+			BasicBlock piece = block;
+			piece.Instructions = 0;
+			for (uint32_t address = block.Start; address < block.End; )
+			{
+				const DecodedInstruction instruction = DecodeInstruction(image, address, analysis.Quirks);
+				address += instruction.Length;
+				piece.Instructions++;
+				if (address >= block.End || !IsStore(instruction.Opcode)) continue;
+
+				BasicBlock head = piece;
+				head.End = address;
+				head.Exit = ControlFlow::Next;
+				head.Successors = { address, BasicBlock::NoSuccessor };
+				head.ComputedJump = false;
+				blocks.push_back(head);
+				piece.Start = address;
+				piece.Instructions = 0;
+			}
+			blocks.push_back(piece);
+		}
+		return blocks;
+	}
+
+	static std::string MakeIdentifier(std::string_view name)
+	{
+		std::string identifier;
+		for (const char c : name)
+		{
+			identifier += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+		}
+		if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier.front()))) identifier.insert(0, "Rom_");
+		return identifier;
+	}
+
+	std::string RecompileRom(const MemoryImage& image, const QuirkProfile quirks, std::string_view name, RecompilerStats* stats)
+	{
+		const RomAnalysis analysis = AnalyseRom(image, quirks);
+		const std::vector<BasicBlock> blocks = SplitAfterStores(image, analysis);
+		RecompilerStats totals;
+		totals.Blocks = static_cast<uint32_t>(blocks.size());
+
+		std::string out;
+		out += "// Generated by the chipotto static recompiler. Do not edit.\n";
+		out += "// ROM " + Hex64(image.GetHash()) + ", " + GetQuirkProfileName(quirks) + " quirks, " + std::to_string(blocks.size()) + " blocks.\n";
+		out += "#include \"recompiled_program.h\"\n\nnamespace\n{\n";
+		out += "\tusing chipotto::CpuState;\n\tusing chipotto::Emulator;\n";
+		out += "\tusing Quirks = " + std::string(GetQuirksTypeName(quirks)) + ";\n\n";
+		out += "\tconstexpr uint64_t ProgramHash = " + Hex64(image.GetHash()) + "ULL;\n";
+		out += "\tconstexpr chipotto::QuirkProfile Profile = " + std::string(GetQuirksEnumName(quirks)) + ";\n\n";
+
+		for (const BasicBlock& block : blocks)
+		{
+			EmitBlock(out, image, block, quirks, totals);
+		}
+
+		out += "\tbool RunFrame(Emulator& emu, const uint32_t instructions)\n\t{\n";
+		out += "\t\tif (emu.GetProgramHash() != ProgramHash || emu.GetQuirks() != Profile) return emu.RunFrame(instructions);\n\n";
+		out += "\t\tCpuState& cpu = emu.GetCpuState();\n";
+		out += "\t\tconst chipotto::PagedMemory& memory = emu.GetMemoryMapping();\n";
+		out += "\t\tuint32_t budget = instructions;\n";
+		out += "\t\twhile (budget > 0 && !cpu.Suspended)\n\t\t{\n";
+		out += "\t\t\tswitch (cpu.PC)\n\t\t\t{\n";
+		for (const BasicBlock& block : blocks)
+		{
+			const std::string count = std::to_string(block.Instructions);
+			// A skip also depends on the length of the instruction it skips.
+			const uint32_t checked_length = block.End - block.Start + (block.Exit == ControlFlow::Skip ? 2 : 0);
+			out += "\t\t\tcase " + Hex(block.Start, 4) + ":\n";
+			out += "\t\t\t\tif (budget < " + count + " || chipotto::IsRecompiledCodeModified(memory, " + Hex(block.Start, 4) + ", " + std::to_string(checked_length) + ")) break;\n";
+			out += "\t\t\t\tbudget -= " + count + ";\n";
+			out += "\t\t\t\tif (!" + BlockName(block.Start) + "(emu, cpu)) return false;\n";
+			out += "\t\t\t\tcontinue;\n";
+		}
+		out += "\t\t\t}\n";
+		out += "\t\t\t// Undiscovered or overwritten code, or a block longer than what is left of the frame.\n";
+		out += "\t\t\tif (!emu.Tick()) return false;\n";
+		out += "\t\t\tbudget--;\n";
+		out += "\t\t}\n";
+		out += "\t\temu.TickTimers();\n";
+		out += "\t\treturn true;\n";
+		out += "\t}\n}\n\n";
+		out += "extern const chipotto::RecompiledProgram " + MakeIdentifier(name) + " = { ProgramHash, Profile, RunFrame };\n";
+
+		if (stats) *stats = totals;
+		return out;
+	}
+}
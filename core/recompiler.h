@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "memory.h"
+#include "quirks.h"
+
+namespace chipotto
+{
+	struct RecompilerStats
+	{
+		uint32_t Blocks = 0;
+		uint32_t Instructions = 0;
+		// Instructions translated to plain C++ instead of calls into the OpcodeN handlers.
+		uint32_t Inlined = 0;
+	};
+
+	// Ahead-of-time translation of a ROM to C++. Code reachable from 0x200 through jumps, calls,
+	// skips and fall-through is split into basic blocks, each emitted as one function; a switch
+	// on PC dispatches between them, which also covers 00EE returns and Bnnn computed jumps.
+	// Register, timer and I arithmetic is inlined with the quirk profile folded in; everything
+	// touching the display, memory or the stack calls the interpreter's handlers.
+	//
+	// The interpreter takes over for addresses that weren't discovered statically, for blocks
+	// whose bytes the program has overwritten (checked when the block is entered), and for the
+	// last instructions of a frame when a whole block doesn't fit in it. Blocks the analysis
+	// finds may store into code end after each store, so a block never runs past a write to
+	// its own bytes.
+	//
+	// Returns the source of a translation unit defining
+	//   extern const chipotto::RecompiledProgram <name>;
+	// (see recompiled_program.h). The name is made a valid identifier if it isn't one.
+	std::string RecompileRom(const MemoryImage& image, const QuirkProfile quirks, std::string_view name, RecompilerStats* stats = nullptr);
+}
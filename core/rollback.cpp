@@ -0,0 +1,160 @@
+#include "rollback.h"
+#include <algorithm>
+
+namespace chipotto
+{
+	// Packet layout, little-endian:
+	//   u32 magic, u32 first input frame, u8 input count, u16 inputs[count],
+	//   u32 acknowledged remote frames, u32 checksum frame, u64 checksum
+	static constexpr uint32_t PacketMagic = 0x42523843; // "C8RB"
+	static constexpr size_t PacketHeaderSize = 4 + 4 + 1;
+	static constexpr size_t PacketTrailerSize = 4 + 4 + 8;
+
+	static void PutInteger(uint8_t*& cursor, const uint64_t value, const size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; ++i) *cursor++ = static_cast<uint8_t>(value >> (8 * i));
+	}
+
+	static uint64_t GetInteger(const uint8_t*& cursor, const size_t bytes)
+	{
+		uint64_t value = 0;
+		for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(*cursor++) << (8 * i);
+		return value;
+	}
+
+	RollbackSession::RollbackSession(Emulator& emulator, UdpSocket& socket, const uint32_t instructions, const bool skip_idle) :
+		Target(emulator), Socket(socket), Instructions(instructions), SkipIdle(skip_idle)
+	{
+	}
+
+	RollbackStatus RollbackSession::AdvanceFrame(const uint16_t local_keys)
+	{
+		if (Desynced) return RollbackStatus::Desynced;
+
+		Receive();
+		if (Desynced) return RollbackStatus::Desynced;
+
+		if (Frame >= RemoteConfirmed + MaxRollback)
+		{
+			// Keep the peer fed so it can catch up, but don't run further ahead.
+			Send();
+			return RollbackStatus::Waiting;
+		}
+
+		if (RollbackFrom != UINT32_MAX)
+		{
+			RollbackCount++;
+			Target.LoadState(States[RollbackFrom % StateRing].Before);
+			for (uint32_t frame = RollbackFrom; frame < Frame; ++frame)
+			{
+				ResimulatedFrames++;
+				if (!Simulate(frame)) return RollbackStatus::Stopped;
+			}
+			RollbackFrom = UINT32_MAX;
+		}
+
+		LocalInputs[Frame % InputRing] = local_keys;
+		if (!Simulate(Frame)) return RollbackStatus::Stopped;
+		Frame++;
+
+		CheckRemoteChecksum();
+		Send();
+		return Desynced ? RollbackStatus::Desynced : RollbackStatus::Advanced;
+	}
+
+	bool RollbackSession::Simulate(const uint32_t frame)
+	{
+		FrameState& state = States[frame % StateRing];
+		Target.SaveState(state.Before);
+
+		const bool confirmed = frame < RemoteConfirmed;
+		state.PredictedRemote = confirmed ? RemoteInputs[frame % InputRing] : (RemoteConfirmed ? RemoteInputs[(RemoteConfirmed - 1) % InputRing] : 0);
+
+		Target.SetKeys(LocalInputs[frame % InputRing] | state.PredictedRemote);
+
+		if (!Target.RunFrame(Instructions, SkipIdle)) return false;
+		Checksums[frame % InputRing] = { frame, Target.GetStateChecksum() };
+		return true;
+	}
+
+	void RollbackSession::Receive()
+	{
+		std::array<uint8_t, PacketHeaderSize + MaxPacketInputs * 2 + PacketTrailerSize> packet;
+		int size;
+		while ((size = Socket.Receive(packet)) >= 0)
+		{
+			if (size < static_cast<int>(PacketHeaderSize + PacketTrailerSize)) continue;
+			const uint8_t* cursor = packet.data();
+			if (GetInteger(cursor, 4) != PacketMagic) continue;
+			const uint32_t first = static_cast<uint32_t>(GetInteger(cursor, 4));
+			const uint32_t count = static_cast<uint32_t>(GetInteger(cursor, 1));
+			if (count > MaxPacketInputs || size != static_cast<int>(PacketHeaderSize + count * 2 + PacketTrailerSize)) continue;
+
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint16_t keys = static_cast<uint16_t>(GetInteger(cursor, 2));
+				const uint32_t frame = first + i;
+				// Only extend the confirmed run; later frames arrive again in the next packet.
+				if (frame != RemoteConfirmed) continue;
+				RemoteInputs[frame % InputRing] = keys;
+				if (frame < Frame && States[frame % StateRing].PredictedRemote != keys)
+				{
+					RollbackFrom = std::min(RollbackFrom, frame);
+				}
+				RemoteConfirmed++;
+			}
+
+			LocalAcknowledged = std::max(LocalAcknowledged, static_cast<uint32_t>(GetInteger(cursor, 4)));
+			const uint32_t checksum_frame = static_cast<uint32_t>(GetInteger(cursor, 4));
+			const uint64_t checksum = GetInteger(cursor, 8);
+			if (checksum_frame != UINT32_MAX && (RemoteChecksum.Frame == UINT32_MAX || checksum_frame > RemoteChecksum.Frame))
+			{
+				RemoteChecksum = { checksum_frame, checksum };
+			}
+		}
+	}
+
+	void RollbackSession::Send()
+	{
+		std::array<uint8_t, PacketHeaderSize + MaxPacketInputs * 2 + PacketTrailerSize> packet;
+		uint8_t* cursor = packet.data();
+		const uint32_t count = std::min(Frame - LocalAcknowledged, MaxPacketInputs);
+		PutInteger(cursor, PacketMagic, 4);
+		PutInteger(cursor, LocalAcknowledged, 4);
+		PutInteger(cursor, count, 1);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			PutInteger(cursor, LocalInputs[(LocalAcknowledged + i) % InputRing], 2);
+		}
+		PutInteger(cursor, RemoteConfirmed, 4);
+
+		// Our newest frame simulated with confirmed input on both sides.
+		const uint32_t confirmed = std::min(RemoteConfirmed, Frame);
+		const ChecksumEntry& entry = confirmed ? Checksums[(confirmed - 1) % InputRing] : ChecksumEntry{};
+		const bool valid = confirmed && entry.Frame == confirmed - 1 && RollbackFrom == UINT32_MAX;
+		PutInteger(cursor, valid ? entry.Frame : UINT32_MAX, 4);
+		PutInteger(cursor, valid ? entry.Value : 0, 8);
+		Socket.Send(std::span<const uint8_t>(packet.data(), cursor - packet.data()));
+	}
+
+	void RollbackSession::CheckRemoteChecksum()
+	{
+		if (RemoteChecksum.Frame == UINT32_MAX) return;
+		// Only compare once our own copy of that frame ran with the real remote input.
+		if (RemoteChecksum.Frame >= std::min(RemoteConfirmed, Frame) || RollbackFrom <= RemoteChecksum.Frame) return;
+		const ChecksumEntry& entry = Checksums[RemoteChecksum.Frame % InputRing];
+		if (entry.Frame == RemoteChecksum.Frame)
+		{
+			if (entry.Value != RemoteChecksum.Value)
+			{
+				Desynced = true;
+				DesyncFrame = entry.Frame;
+			}
+			else
+			{
+				VerifiedFrames++;
+			}
+		}
+		RemoteChecksum = {};
+	}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "chip-8.h"
+#include "udp_socket.h"
+
+namespace chipotto
+{
+	enum class RollbackStatus
+	{
+		Advanced,
+		// Too far ahead of the last confirmed remote input; try again next host frame.
+		Waiting,
+		Stopped,
+		Desynced
+	};
+
+	// Two-player rollback session over UDP. Both peers run the same ROM and the emulated keypad
+	// is the OR of both players' 16-bit key states, as CHIP-8 two-player games split the keypad.
+	//
+	// Every frame runs immediately with a prediction of the remote keys (their last confirmed
+	// state). When the real input arrives and differs, the emulator is rolled back to the
+	// snapshot taken before the first mispredicted frame and re-simulated up to the present,
+	// at most MaxRollback frames in one call. Each packet carries the sender's inputs since
+	// the peer's last acknowledgement and the checksum of its newest confirmed frame, which the
+	// receiver compares with its own to detect desyncs. Cxnn stays in sync as long as both
+	// emulators start from the same seed, since the generator state is part of every snapshot.
+	class RollbackSession
+	{
+	public:
+		static constexpr uint32_t MaxRollback = 8;
+
+		RollbackSession(Emulator& emulator, UdpSocket& socket, const uint32_t instructions, const bool skip_idle = false);
+
+		RollbackStatus AdvanceFrame(const uint16_t local_keys);
+
+		uint32_t GetFrame() const { return Frame; };
+		uint32_t GetConfirmedFrame() const { return RemoteConfirmed; };
+		uint64_t GetRollbackCount() const { return RollbackCount; };
+		uint64_t GetResimulatedFrames() const { return ResimulatedFrames; };
+		uint64_t GetVerifiedFrames() const { return VerifiedFrames; };
+		bool HasDesynced() const { return Desynced; };
+		// First frame whose checksums disagreed, valid once HasDesynced.
+		uint32_t GetDesyncFrame() const { return DesyncFrame; };
+
+	private:
+		static constexpr uint32_t StateRing = 16;
+		static constexpr uint32_t InputRing = 64;
+		static constexpr uint32_t MaxPacketInputs = 32;
+
+		struct FrameState
+		{
+			Snapshot Before;
+			uint16_t PredictedRemote = 0;
+		};
+
+		struct ChecksumEntry
+		{
+			uint32_t Frame = UINT32_MAX;
+			uint64_t Value = 0;
+		};
+
+		void Receive();
+		void Send();
+		bool Simulate(const uint32_t frame);
+		void CheckRemoteChecksum();
+
+		Emulator& Target;
+		UdpSocket& Socket;
+		uint32_t Instructions;
+		bool SkipIdle;
+
+		// Next frame to simulate, and how many leading frames of remote input have arrived.
+		uint32_t Frame = 0;
+		uint32_t RemoteConfirmed = 0;
+		// How many leading frames of our input the peer has acknowledged.
+		uint32_t LocalAcknowledged = 0;
+		// Earliest frame simulated with a wrong prediction, or UINT32_MAX.
+		uint32_t RollbackFrom = UINT32_MAX;
+
+		std::array<uint16_t, InputRing> LocalInputs{};
+		std::array<uint16_t, InputRing> RemoteInputs{};
+		std::array<FrameState, StateRing> States;
+		std::array<ChecksumEntry, InputRing> Checksums{};
+		ChecksumEntry RemoteChecksum;
+
+		bool Desynced = false;
+		uint32_t DesyncFrame = 0;
+		uint64_t RollbackCount = 0;
+		uint64_t ResimulatedFrames = 0;
+		uint64_t VerifiedFrames = 0;
+	};
+}
@@ -0,0 +1,364 @@
+#include "rom_analysis.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace chipotto
+{
+	// PC is 16 bits wide, so only the first 64 KB can hold code.
+	static constexpr uint32_t CodeLimit = 0x10000;
+
+	static uint32_t GetCodeLimit(const MemoryImage& image)
+	{
+		return std::min(image.GetSize(), CodeLimit);
+	}
+
+	static bool IsCode(const MemoryImage& image, const uint32_t address)
+	{
+		return address >= MemoryImage::ProgramAddress && address + 1 < GetCodeLimit(image);
+	}
+
+	static uint8_t ReadByte(const MemoryImage& image, const uint32_t address)
+	{
+		return image.GetPage(address >> MemoryPage::Shift)[address & (MemoryPage::Size - 1)];
+	}
+
+	static uint16_t ReadWord(const MemoryImage& image, const uint32_t address)
+	{
+		return static_cast<uint16_t>((ReadByte(image, address) << 8) | ReadByte(image, address + 1));
+	}
+
+	static bool LoadStoreIncrementsI(const QuirkProfile quirks)
+	{
+		switch (quirks)
+		{
+		case QuirkProfile::CosmacVip: return CosmacVipQuirks::LoadStoreIncrementsI;
+		case QuirkProfile::SuperChip: return SuperChipQuirks::LoadStoreIncrementsI;
+		case QuirkProfile::XoChip: return XoChipQuirks::LoadStoreIncrementsI;
+		case QuirkProfile::MegaChip: return MegaChipQuirks::LoadStoreIncrementsI;
+		default: return ChipottoQuirks::LoadStoreIncrementsI;
+		}
+	}
+
+	DecodedInstruction DecodeInstruction(const MemoryImage& image, const uint32_t address, const QuirkProfile quirks)
+	{
+		DecodedInstruction instruction;
+		const uint16_t opcode = ReadWord(image, address);
+		instruction.Opcode = opcode;
+		if (!IsValidOpcode(opcode, quirks))
+		{
+			instruction.Flow = ControlFlow::Dynamic;
+			return instruction;
+		}
+
+		const OpcodeForm& form = *FindOpcodeForm(opcode);
+		instruction.Flow = form.Flow;
+		instruction.Length = form.Length;
+		if (form.Flow == ControlFlow::Jump || form.Flow == ControlFlow::Call) instruction.Target = opcode & 0xFFF;
+		if (instruction.Length == 4)
+		{
+			// The second word of a long instruction past the code limit is read at run time.
+			if (address + 3 >= GetCodeLimit(image)) instruction.Flow = ControlFlow::Dynamic;
+			else instruction.Operand = ReadWord(image, address + 2);
+		}
+		return instruction;
+	}
+
+	uint16_t GetOpcodeKey(const uint16_t opcode)
+	{
+		const OpcodeForm* form = FindOpcodeForm(opcode);
+		return form ? form->Match : opcode;
+	}
+
+	// Where a taken skip lands, or NoSuccessor when the skipped instruction's length depends on
+	// whether MEGA-CHIP mode is on at run time.
+	static uint32_t GetSkipTarget(const MemoryImage& image, const uint32_t address)
+	{
+		const uint32_t next = address + 2;
+		if (!IsCode(image, next)) return BasicBlock::NoSuccessor;
+		const OpcodeForm* form = FindOpcodeForm(ReadWord(image, next));
+		if (form && form->MegaOnly && form->Length == 4) return BasicBlock::NoSuccessor;
+		const uint32_t target = next + (form ? form->Length : 2);
+		return IsCode(image, target) ? target : BasicBlock::NoSuccessor;
+	}
+
+	// Walks every instruction reachable from 0x200 once, marking code bytes, counting opcodes
+	// and collecting the addresses blocks start at.
+	static std::vector<uint8_t> FindLeaders(const MemoryImage& image, RomAnalysis& analysis)
+	{
+		const uint32_t limit = GetCodeLimit(image);
+		std::vector<uint8_t> leaders(limit, 0);
+		std::vector<uint8_t> walked(limit, 0);
+		std::vector<uint32_t> pending;
+		auto add_leader = [&](const uint32_t address)
+			{
+				if (!IsCode(image, address) || leaders[address]) return;
+				leaders[address] = 1;
+				pending.push_back(address);
+			};
+		add_leader(MemoryImage::ProgramAddress);
+
+		while (!pending.empty())
+		{
+			uint32_t address = pending.back();
+			pending.pop_back();
+			while (IsCode(image, address) && !walked[address])
+			{
+				walked[address] = 1;
+				const DecodedInstruction instruction = DecodeInstruction(image, address, analysis.Quirks);
+				for (uint32_t offset = 0; offset < instruction.Length && address + offset < limit; ++offset)
+				{
+					analysis.Bytes[address + offset] = ByteClass::Code;
+				}
+				analysis.OpcodeHistogram[GetOpcodeKey(instruction.Opcode)]++;
+
+				const uint32_t next = address + instruction.Length;
+				switch (instruction.Flow)
+				{
+				case ControlFlow::Next:
+					address = next;
+					continue;
+				case ControlFlow::Jump:
+					add_leader(instruction.Target);
+					break;
+				case ControlFlow::Call:
+					add_leader(instruction.Target);
+					add_leader(next);
+					break;
+				case ControlFlow::Skip:
+					add_leader(next);
+					add_leader(GetSkipTarget(image, address));
+					break;
+				case ControlFlow::Wait:
+					add_leader(next);
+					break;
+				case ControlFlow::Dynamic:
+					break;
+				}
+				break;
+			}
+		}
+		return leaders;
+	}
+
+	static void FindBlocks(const MemoryImage& image, const std::vector<uint8_t>& leaders, RomAnalysis& analysis)
+	{
+		for (uint32_t start = 0; start < leaders.size(); ++start)
+		{
+			if (!leaders[start]) continue;
+			BasicBlock block;
+			block.Start = start;
+			uint32_t address = start;
+			DecodedInstruction instruction;
+			do
+			{
+				instruction = DecodeInstruction(image, address, analysis.Quirks);
+				address += instruction.Length;
+				block.Instructions++;
+			} while (instruction.Flow == ControlFlow::Next && IsCode(image, address) && !leaders[address]);
+			block.End = address;
+			block.Exit = instruction.Flow;
+
+			auto code_or_none = [&image](const uint32_t target) { return IsCode(image, target) ? target : BasicBlock::NoSuccessor; };
+			switch (instruction.Flow)
+			{
+			case ControlFlow::Next:
+			case ControlFlow::Wait:
+				block.Successors[0] = code_or_none(block.End);
+				break;
+			case ControlFlow::Jump:
+				block.Successors[0] = code_or_none(instruction.Target);
+				break;
+			case ControlFlow::Call:
+				block.Successors = { code_or_none(instruction.Target), code_or_none(block.End) };
+				break;
+			case ControlFlow::Skip:
+				block.Successors = { code_or_none(block.End), GetSkipTarget(image, block.End - 2) };
+				break;
+			case ControlFlow::Dynamic:
+				block.ComputedJump = (instruction.Opcode >> 12) == 0xB;
+				break;
+			}
+			analysis.Blocks.push_back(block);
+		}
+	}
+
+	// Follows I through each block from its Annn, F000 or 01nn to classify the bytes loads,
+	// stores and sprites touch, and to flag stores into code.
+	static void ClassifyMemoryAccesses(const MemoryImage& image, RomAnalysis& analysis)
+	{
+		const bool increments_i = LoadStoreIncrementsI(analysis.Quirks);
+		for (BasicBlock& block : analysis.Blocks)
+		{
+			bool known = false;
+			uint32_t i = 0;
+			for (uint32_t address = block.Start; address < block.End; )
+			{
+				const DecodedInstruction instruction = DecodeInstruction(image, address, analysis.Quirks);
+				const uint16_t opcode = instruction.Opcode;
+				const uint8_t x = (opcode >> 8) & 0xF;
+				const uint8_t y = (opcode >> 4) & 0xF;
+				uint32_t read = 0;
+				uint32_t written = 0;
+				bool advances_i = false;
+				switch (opcode >> 12)
+				{
+				case 0x0:
+					if ((opcode >> 8) == 0x01 && instruction.Length == 4)
+					{
+						i = (static_cast<uint32_t>(opcode & 0xFF) << 16) | instruction.Operand;
+						known = true;
+					}
+					else if ((opcode >> 8) == 0x02) read = (opcode & 0xFF) * 4;
+					break;
+				case 0x5:
+					if ((opcode & 0xF) == 0x2) written = (x > y ? x - y : y - x) + 1;
+					else if ((opcode & 0xF) == 0x3) read = (x > y ? x - y : y - x) + 1;
+					break;
+				case 0xA:
+					i = opcode & 0xFFF;
+					known = true;
+					break;
+				case 0xD:
+					// MEGA-CHIP sprite sizes are only known at run time.
+					if (analysis.Quirks != QuirkProfile::MegaChip) read = (opcode & 0xF) ? (opcode & 0xF) : 32;
+					break;
+				case 0xF:
+					if (opcode == 0xF000 && instruction.Length == 4)
+					{
+						i = instruction.Operand;
+						known = true;
+					}
+					else if (opcode == 0xF002) read = 16;
+					else
+					{
+						switch (opcode & 0xFF)
+						{
+						case 0x33: written = 3; break;
+						case 0x55: written = x + 1u; advances_i = increments_i; break;
+						case 0x65: read = x + 1u; advances_i = increments_i; break;
+						case 0x1E: case 0x29: case 0x30: known = false; break;
+						}
+					}
+					break;
+				}
+
+				if (read || written)
+				{
+					if (!known)
+					{
+						if (written) block.UnresolvedWrite = true;
+					}
+					else
+					{
+						for (uint32_t offset = 0; offset < read + written && i + offset < analysis.Bytes.size(); ++offset)
+						{
+							ByteClass& byte = analysis.Bytes[i + offset];
+							if (byte == ByteClass::Code)
+							{
+								if (written) block.WritesCode = true;
+							}
+							else byte = ByteClass::Data;
+						}
+						if (advances_i) i += read + written;
+					}
+				}
+				address += instruction.Length;
+			}
+		}
+	}
+
+	// Groups blocks into subroutines: everything reachable from an entry without entering a
+	// callee, whose calls become the edges of the call graph.
+	static void BuildCallGraph(RomAnalysis& analysis)
+	{
+		analysis.Subroutines.push_back(MemoryImage::ProgramAddress);
+		for (const BasicBlock& block : analysis.Blocks)
+		{
+			if (block.Exit == ControlFlow::Call && block.Successors[0] != BasicBlock::NoSuccessor)
+				analysis.Subroutines.push_back(block.Successors[0]);
+		}
+		std::sort(analysis.Subroutines.begin(), analysis.Subroutines.end());
+		analysis.Subroutines.erase(std::unique(analysis.Subroutines.begin(), analysis.Subroutines.end()), analysis.Subroutines.end());
+
+		std::vector<uint8_t> visited(analysis.Blocks.size());
+		std::vector<uint32_t> pending;
+		for (const uint32_t entry : analysis.Subroutines)
+		{
+			std::fill(visited.begin(), visited.end(), 0);
+			pending.assign(1, entry);
+			while (!pending.empty())
+			{
+				const BasicBlock* block = analysis.FindBlock(pending.back());
+				pending.pop_back();
+				if (!block) continue;
+				uint8_t& seen = visited[block - analysis.Blocks.data()];
+				if (seen) continue;
+				seen = 1;
+
+				if (block->Exit == ControlFlow::Call)
+				{
+					if (block->Successors[0] != BasicBlock::NoSuccessor)
+						analysis.Calls.push_back({ entry, block->End - 2, block->Successors[0] });
+					pending.push_back(block->Successors[1]);
+					continue;
+				}
+				for (const uint32_t successor : block->Successors)
+				{
+					if (successor != BasicBlock::NoSuccessor) pending.push_back(successor);
+				}
+			}
+		}
+	}
+
+	const BasicBlock* RomAnalysis::FindBlock(const uint32_t start) const
+	{
+		const auto found = std::lower_bound(Blocks.begin(), Blocks.end(), start, [](const BasicBlock& block, const uint32_t address) { return block.Start < address; });
+		return found != Blocks.end() && found->Start == start ? &*found : nullptr;
+	}
+
+	bool RomAnalysis::HasDynamicCode() const
+	{
+		return std::any_of(Blocks.begin(), Blocks.end(), [](const BasicBlock& block) { return block.ComputedJump || block.WritesCode || block.UnresolvedWrite; });
+	}
+
+	RomAnalysis AnalyseRom(const MemoryImage& image, const QuirkProfile quirks)
+	{
+		RomAnalysis analysis;
+		analysis.Quirks = quirks;
+		analysis.Bytes.assign(GetCodeLimit(image), ByteClass::Unknown);
+		const std::vector<uint8_t> leaders = FindLeaders(image, analysis);
+		FindBlocks(image, leaders, analysis);
+		ClassifyMemoryAccesses(image, analysis);
+		BuildCallGraph(analysis);
+		return analysis;
+	}
+
+	std::vector<RomAnalysis> AnalyseRoms(std::span<const std::shared_ptr<const MemoryImage>> images, std::span<const QuirkProfile> quirks, unsigned thread_count)
+	{
+		std::vector<RomAnalysis> results(images.size());
+		if (thread_count == 0) thread_count = std::max(1u, std::thread::hardware_concurrency());
+		thread_count = static_cast<unsigned>(std::min<size_t>(thread_count, images.size()));
+
+		// ROMs vary a lot in size, so threads take the next one as they finish.
+		std::atomic<size_t> next{ 0 };
+		auto worker = [&]()
+			{
+				for (size_t index = next++; index < images.size(); index = next++)
+				{
+					results[index] = AnalyseRom(*images[index], quirks[index]);
+				}
+			};
+		std::vector<std::thread> threads;
+		for (unsigned thread = 1; thread < thread_count; ++thread)
+		{
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+		return results;
+	}
+}
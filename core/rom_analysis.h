@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <span>
+#include <vector>
+#include "memory.h"
+#include "opcode_table.h"
+#include "quirks.h"
+
+namespace chipotto
+{
+	struct DecodedInstruction
+	{
+		uint16_t Opcode = 0;
+		// 4 for XO-CHIP's F000 nnnn and MEGA-CHIP's 01nn nnnn.
+		uint8_t Length = 2;
+		ControlFlow Flow = ControlFlow::Next;
+		// Jump and call destination.
+		uint32_t Target = 0;
+		// Second word of a four-byte instruction.
+		uint16_t Operand = 0;
+	};
+
+	// Decodes the instruction at address of the unmodified image.
+	DecodedInstruction DecodeInstruction(const MemoryImage& image, const uint32_t address, const QuirkProfile quirks);
+	// Opcode with its operand fields cleared (0x8004 for 8xy4, 0xF055 for Fx55), or the opcode
+	// itself when no handler implements it: the key of the opcode histogram.
+	uint16_t GetOpcodeKey(const uint16_t opcode);
+
+	enum class ByteClass : uint8_t
+	{
+		Unknown,
+		// Part of a discovered instruction.
+		Code,
+		// Read or written through an I the analysis could follow (sprites, tables, variables).
+		Data
+	};
+
+	struct BasicBlock
+	{
+		static constexpr uint32_t NoSuccessor = 0;
+
+		uint32_t Start = 0;
+		uint32_t End = 0;
+		uint32_t Instructions = 0;
+		// How the last instruction leaves the block. Next means it runs into another block.
+		ControlFlow Exit = ControlFlow::Next;
+		// Next/Jump/Wait: the following block. Call: the callee, then the return site.
+		// Skip: not taken, then taken (NoSuccessor when the skipped instruction's length is only
+		// known at run time).
+		std::array<uint32_t, 2> Successors{ NoSuccessor, NoSuccessor };
+		// Ends in Bnnn, whose target depends on a register.
+		bool ComputedJump = false;
+		// Stores into discovered code.
+		bool WritesCode = false;
+		// Stores through an I the analysis couldn't follow, which may hit code too.
+		bool UnresolvedWrite = false;
+	};
+
+	struct CallEdge
+	{
+		// Entry of the subroutine making the call, and the address of the 2nnn.
+		uint32_t Caller = 0;
+		uint32_t Site = 0;
+		uint32_t Callee = 0;
+	};
+
+	struct RomAnalysis
+	{
+		QuirkProfile Quirks = QuirkProfile::Chipotto;
+		// Sorted by start address. Blocks never contain another block's start, but can overlap
+		// when code jumps into the middle of an instruction.
+		std::vector<BasicBlock> Blocks;
+		// 0x200 and every call target, sorted.
+		std::vector<uint32_t> Subroutines;
+		std::vector<CallEdge> Calls;
+		// One entry per address the program counter can reach (the first 64 KB of the image).
+		std::vector<ByteClass> Bytes;
+		// Discovered instructions counted once each, by GetOpcodeKey.
+		std::map<uint16_t, uint32_t> OpcodeHistogram;
+
+		const BasicBlock* FindBlock(const uint32_t start) const;
+		// True if any block ends in Bnnn or may write code, so static translation alone can't
+		// be trusted to cover the program.
+		bool HasDynamicCode() const;
+	};
+
+	// Explores a ROM from 0x200, following jumps, calls and their return sites, both outcomes of
+	// skips and resumption after Fx0A. 00EE and Bnnn end exploration: their targets are only
+	// known at run time. Only addresses from 0x200 up are explored.
+	//
+	// The analysis is pure and reads nothing but the image, so many can run at once.
+	RomAnalysis AnalyseRom(const MemoryImage& image, const QuirkProfile quirks);
+	// Analyses images[i] with quirks[i] across thread_count threads (0 for one per core).
+	std::vector<RomAnalysis> AnalyseRoms(std::span<const std::shared_ptr<const MemoryImage>> images, std::span<const QuirkProfile> quirks, unsigned thread_count = 0);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace chipotto
+{
+	// XXH64 of a ROM's contents. Used to key the profile database and ROM caches.
+	uint64_t HashRom(std::span<const uint8_t> rom, const uint64_t seed = 0);
+
+	// Zobrist key of a value at a position. A hash kept as the XOR of the keys of an array's
+	// values is updated on a write by XORing out the old value's key and in the new one's.
+	inline uint64_t ZobristKey(const uint64_t position, const uint64_t value)
+	{
+		// splitmix64's finaliser over the value salted with a Weyl multiple of the position,
+		// which keeps apart the byte and word values written at different positions.
+		uint64_t key = value ^ (position * 0x9E3779B97F4A7C15ULL);
+		key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+		return key ^ (key >> 31);
+	}
+}
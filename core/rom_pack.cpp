@@ -0,0 +1,168 @@
+#include "rom_pack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace chipotto
+{
+	uint64_t HashRomName(std::string_view name)
+	{
+		uint64_t hash = 0xCBF29CE484222325ULL;
+		for (const char c : name)
+		{
+			hash ^= static_cast<uint8_t>(c);
+			hash *= 0x100000001B3ULL;
+		}
+		return hash;
+	}
+
+	RomPack::~RomPack()
+	{
+		Close();
+	}
+
+	bool RomPack::Open(const std::filesystem::path& Path)
+	{
+		Close();
+#ifdef _WIN32
+		HANDLE file = CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(RomPackHeader)))
+		{
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			CloseHandle(file);
+			return false;
+		}
+		const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!view)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+		FileHandle = file;
+		MappingHandle = mapping;
+		Data = static_cast<const uint8_t*>(view);
+		Size = static_cast<size_t>(file_size.QuadPart);
+#else
+		int file = open(Path.c_str(), O_RDONLY);
+		if (file < 0) return false;
+		struct stat file_stat;
+		if (fstat(file, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(sizeof(RomPackHeader)))
+		{
+			close(file);
+			return false;
+		}
+		void* view = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, file, 0);
+		close(file);
+		if (view == MAP_FAILED) return false;
+		Data = static_cast<const uint8_t*>(view);
+		Size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+		Header = reinterpret_cast<const RomPackHeader*>(Data);
+		const size_t entries_end = sizeof(RomPackHeader) + static_cast<size_t>(Header->Count) * sizeof(RomPackEntry);
+		if (Header->Signature != RomPackHeader::Magic || Header->Version != RomPackHeader::CurrentVersion || entries_end > Size)
+		{
+			Close();
+			return false;
+		}
+		Entries = reinterpret_cast<const RomPackEntry*>(Data + sizeof(RomPackHeader));
+		for (uint32_t i = 0; i < Header->Count; ++i)
+		{
+			if (static_cast<size_t>(Entries[i].Offset) + Entries[i].Size > Size)
+			{
+				Close();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void RomPack::Close()
+	{
+		if (!Data) return;
+#ifdef _WIN32
+		UnmapViewOfFile(Data);
+		CloseHandle(MappingHandle);
+		CloseHandle(FileHandle);
+		MappingHandle = nullptr;
+		FileHandle = nullptr;
+#else
+		munmap(const_cast<uint8_t*>(Data), Size);
+#endif
+		Data = nullptr;
+		Size = 0;
+		Header = nullptr;
+		Entries = nullptr;
+	}
+
+	std::span<const uint8_t> RomPack::Find(const uint64_t name_hash) const
+	{
+		if (!Data) return {};
+		const RomPackEntry* end = Entries + Header->Count;
+		const RomPackEntry* entry = std::lower_bound(Entries, end, name_hash,
+			[](const RomPackEntry& lhs, const uint64_t rhs) { return lhs.NameHash < rhs; });
+		if (entry == end || entry->NameHash != name_hash) return {};
+		return { Data + entry->Offset, entry->Size };
+	}
+
+	std::shared_ptr<const MemoryImage> RomPack::CreateImage(std::string_view name) const
+	{
+		std::span<const uint8_t> rom = Find(name);
+		const uint32_t size = MemoryImage::GetFittingSize(rom.size());
+		if (rom.empty() || size == 0) return nullptr;
+		return MemoryImage::Create(rom, size);
+	}
+
+	void RomPackBuilder::Add(std::string_view name, std::span<const uint8_t> rom)
+	{
+		Roms.push_back({ HashRomName(name), std::vector<uint8_t>(rom.begin(), rom.end()) });
+	}
+
+	bool RomPackBuilder::Write(const std::filesystem::path& Path) const
+	{
+		std::vector<const PendingRom*> sorted;
+		for (const PendingRom& rom : Roms) sorted.push_back(&rom);
+		std::sort(sorted.begin(), sorted.end(), [](const PendingRom* lhs, const PendingRom* rhs) { return lhs->NameHash < rhs->NameHash; });
+
+		RomPackHeader header;
+		header.Count = static_cast<uint32_t>(sorted.size());
+
+		std::vector<RomPackEntry> entries;
+		uint32_t offset = static_cast<uint32_t>(sizeof(RomPackHeader) + sorted.size() * sizeof(RomPackEntry));
+		for (const PendingRom* rom : sorted)
+		{
+			if (!entries.empty() && entries.back().NameHash == rom->NameHash) return false;
+			entries.push_back({ rom->NameHash, offset, static_cast<uint32_t>(rom->Bytes.size()) });
+			offset += static_cast<uint32_t>(rom->Bytes.size());
+		}
+
+		std::ofstream file(Path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return false;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(RomPackEntry));
+		for (const PendingRom* rom : sorted)
+		{
+			file.write(reinterpret_cast<const char*>(rom->Bytes.data()), rom->Bytes.size());
+		}
+		return file.good();
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "memory.h"
+
+namespace chipotto
+{
+	// ROM pack file layout (little endian):
+	//   header   "C8PK", uint32 version, uint32 entry count, uint32 reserved
+	//   entries  { uint64 name hash, uint32 offset, uint32 size } sorted by name hash
+	//   data     ROM bytes, referenced by offset from the start of the file
+	// The pack is mapped once and ROMs are handed out as spans into the mapping.
+	struct RomPackHeader
+	{
+		static constexpr uint32_t Magic = 0x4B503843; // "C8PK"
+		static constexpr uint32_t CurrentVersion = 1;
+
+		uint32_t Signature = Magic;
+		uint32_t Version = CurrentVersion;
+		uint32_t Count = 0;
+		uint32_t Reserved = 0;
+	};
+	static_assert(sizeof(RomPackHeader) == 16);
+
+	struct RomPackEntry
+	{
+		uint64_t NameHash = 0;
+		uint32_t Offset = 0;
+		uint32_t Size = 0;
+	};
+	static_assert(sizeof(RomPackEntry) == 16);
+
+	uint64_t HashRomName(std::string_view name);
+
+	class RomPack
+	{
+	public:
+		RomPack() = default;
+		~RomPack();
+		RomPack(const RomPack& other) = delete;
+		RomPack& operator=(const RomPack& other) = delete;
+
+		bool Open(const std::filesystem::path& Path);
+		void Close();
+
+		bool IsValid() const { return Data != nullptr; };
+		uint32_t GetCount() const { return Header ? Header->Count : 0; };
+
+		std::span<const uint8_t> Find(const uint64_t name_hash) const;
+		std::span<const uint8_t> Find(std::string_view name) const { return Find(HashRomName(name)); };
+		// Sized as Emulator::LoadFromMemory sizes a program; nullptr if name isn't in the pack.
+		std::shared_ptr<const MemoryImage> CreateImage(std::string_view name) const;
+
+	private:
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+		const RomPackHeader* Header = nullptr;
+		const RomPackEntry* Entries = nullptr;
+#ifdef _WIN32
+		void* FileHandle = nullptr;
+		void* MappingHandle = nullptr;
+#endif
+	};
+
+	class RomPackBuilder
+	{
+	public:
+		void Add(std::string_view name, std::span<const uint8_t> rom);
+		bool Write(const std::filesystem::path& Path) const;
+
+	private:
+		struct PendingRom
+		{
+			uint64_t NameHash;
+			std::vector<uint8_t> Bytes;
+		};
+		std::vector<PendingRom> Roms;
+	};
+}
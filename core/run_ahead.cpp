@@ -0,0 +1,32 @@
+#include "run_ahead.h"
+#include <algorithm>
+
+namespace chipotto
+{
+	bool RunAhead::RunFrame(Emulator& primary, const uint32_t instructions, const bool skip_idle)
+	{
+		if (!primary.RunFrame(instructions, skip_idle)) return false;
+		if (!Frames) return true;
+
+		const auto start = std::chrono::steady_clock::now();
+		primary.SaveState(State);
+		Secondary.LoadState(State);
+		Ahead = true;
+		for (uint32_t frame = 0; frame < Frames; ++frame)
+		{
+			// A speculative frame that stops the program just leaves the last good one on screen.
+			if (!Secondary.RunFrame(instructions, skip_idle)) break;
+		}
+		LastOverhead = std::chrono::steady_clock::now() - start;
+
+		FrameCount++;
+		TotalOverhead += LastOverhead;
+		MaxOverhead = std::max(MaxOverhead, LastOverhead);
+		return true;
+	}
+
+	const Framebuffer& RunAhead::GetFramebuffer(const Emulator& primary) const
+	{
+		return Ahead ? Secondary.GetFramebuffer() : primary.GetFramebuffer();
+	}
+}
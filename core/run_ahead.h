@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include "chip-8.h"
+
+namespace chipotto
+{
+	// Hides a ROM's built-in input lag. After the primary Emulator runs its real frame, its
+	// state is copied into a secondary headless Emulator. The secondary then runs Frames more
+	// frames with the same input, and its framebuffer is presented instead. The primary never
+	// runs speculatively, so nothing has to be restored on it.
+	class RunAhead
+	{
+	public:
+		explicit RunAhead(const uint32_t frames) : Frames(frames) {};
+
+		uint32_t GetFrames() const { return Frames; };
+
+		// Runs one real frame on the primary and the speculative ones on the secondary.
+		// Returns false if the primary stopped.
+		bool RunFrame(Emulator& primary, const uint32_t instructions, const bool skip_idle);
+		// The frame to present: the secondary's once it has run ahead, else the primary's.
+		const Framebuffer& GetFramebuffer(const Emulator& primary) const;
+
+		// Time spent on the snapshot copy and the speculative frames in the last call and overall.
+		std::chrono::nanoseconds GetLastOverhead() const { return LastOverhead; };
+		std::chrono::nanoseconds GetMeanOverhead() const { return FrameCount ? TotalOverhead / static_cast<int64_t>(FrameCount) : std::chrono::nanoseconds(0); };
+		std::chrono::nanoseconds GetMaxOverhead() const { return MaxOverhead; };
+
+	private:
+		uint32_t Frames;
+		Emulator Secondary;
+		Snapshot State;
+		bool Ahead = false;
+
+		uint64_t FrameCount = 0;
+		std::chrono::nanoseconds LastOverhead{ 0 };
+		std::chrono::nanoseconds TotalOverhead{ 0 };
+		std::chrono::nanoseconds MaxOverhead{ 0 };
+	};
+}
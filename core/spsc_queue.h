@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace chipotto
+{
+	// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+	// Head and tail only ever grow; Capacity must be a power of two so they can be masked.
+	template<typename T, size_t Capacity>
+	class SpscQueue
+	{
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	public:
+		// Returns false, dropping the value, when the queue is full.
+		bool Push(const T& value)
+		{
+			const size_t head = Head.load(std::memory_order_relaxed);
+			if (head - Tail.load(std::memory_order_acquire) == Capacity) return false;
+			Items[head & (Capacity - 1)] = value;
+			Head.store(head + 1, std::memory_order_release);
+			return true;
+		};
+
+		bool Pop(T& value)
+		{
+			const size_t tail = Tail.load(std::memory_order_relaxed);
+			if (tail == Head.load(std::memory_order_acquire)) return false;
+			value = Items[tail & (Capacity - 1)];
+			Tail.store(tail + 1, std::memory_order_release);
+			return true;
+		};
+
+	private:
+		alignas(64) std::atomic<size_t> Head{ 0 };
+		alignas(64) std::atomic<size_t> Tail{ 0 };
+		std::array<T, Capacity> Items{};
+	};
+}
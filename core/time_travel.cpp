@@ -0,0 +1,204 @@
+#include "time_travel.h"
+#include <algorithm>
+
+namespace chipotto
+{
+	TimeTravelSession::TimeTravelSession(Emulator& emulator, Debugger& debugger, const uint32_t keyframe_interval) :
+		Target(emulator), Debug(debugger), KeyframeInterval(std::max(1u, keyframe_interval))
+	{
+		Keyframes.emplace_back();
+		Target.SaveState(Keyframes.back().State);
+	}
+
+	DebugStop TimeTravelSession::Run(const uint32_t instructions)
+	{
+		DebugStop result;
+		bool first = true;
+		while (result.Executed < instructions)
+		{
+			ApplyEvents();
+			// Debugger::Run passes over a breakpoint at the PC it starts from, which is only
+			// right for the first chunk.
+			if (!first && Debug.HasBreakpoint(Target.GetPC()))
+			{
+				result.Reason = StopReason::Breakpoint;
+				break;
+			}
+			first = false;
+
+			// Run up to the next keyframe, or the next logged event if replaying first.
+			uint32_t chunk = instructions - result.Executed;
+			chunk = static_cast<uint32_t>(std::min<uint64_t>(chunk, Keyframes.back().Position + KeyframeInterval - Position));
+			const bool has_event = NextEvent < Events.size();
+			if (has_event) chunk = static_cast<uint32_t>(std::min<uint64_t>(chunk, Events[NextEvent].Position - Position));
+			const DebugStop stop = Debug.Run(Target, chunk);
+			Position += stop.Executed;
+			End = std::max(End, Position);
+			if (Position >= Keyframes.back().Position + KeyframeInterval)
+			{
+				Keyframes.emplace_back();
+				Keyframes.back().Position = Position;
+				Keyframes.back().EventIndex = NextEvent;
+				Target.SaveState(Keyframes.back().State);
+			}
+
+			const uint32_t executed = result.Executed + stop.Executed;
+			result = stop;
+			result.Executed = executed;
+			if (stop.Reason != StopReason::None) break;
+			// Waiting for a key: carry on only if the log has one for this position.
+			if (stop.Executed < chunk && !(NextEvent < Events.size() && Events[NextEvent].Position == Position)) break;
+		}
+		ApplyEvents();
+		return result;
+	}
+
+	void TimeTravelSession::TickTimers()
+	{
+		Record(EventKind::TickTimers, 0);
+	}
+
+	void TimeTravelSession::SetKeys(const uint16_t keys)
+	{
+		Record(EventKind::SetKeys, keys);
+	}
+
+	void TimeTravelSession::KeyDown(const uint8_t key)
+	{
+		Record(EventKind::KeyDown, key);
+	}
+
+	void TimeTravelSession::KeyUp(const uint8_t key)
+	{
+		Record(EventKind::KeyUp, key);
+	}
+
+	bool TimeTravelSession::StepBack()
+	{
+		if (Position == 0) return false;
+		return Seek(Position - 1);
+	}
+
+	bool TimeTravelSession::ReverseContinue()
+	{
+		return SearchBackwards(nullptr);
+	}
+
+	bool TimeTravelSession::ReverseToWrite(const uint32_t address)
+	{
+		MemoryWatchpoints watch;
+		watch.Ranges.push_back({ address, address + 1, MemoryAccess::Write });
+		return SearchBackwards(&watch);
+	}
+
+	bool TimeTravelSession::Seek(const uint64_t position)
+	{
+		if (position > End) return false;
+		const auto keyframe = std::upper_bound(Keyframes.begin(), Keyframes.end(), position, [](const uint64_t value, const Keyframe& keyframe) { return value < keyframe.Position; }) - 1;
+		Restore(*keyframe);
+		Replay(position);
+		return true;
+	}
+
+	void TimeTravelSession::Record(const EventKind kind, const uint16_t value)
+	{
+		if (IsReplaying())
+		{
+			// New input in the past starts a new future.
+			Events.resize(NextEvent);
+			while (Keyframes.back().Position > Position || Keyframes.back().EventIndex > NextEvent)
+			{
+				Keyframes.pop_back();
+			}
+			End = Position;
+		}
+		Events.push_back({ Position, kind, value });
+		NextEvent = Events.size();
+		Apply(Events.back());
+	}
+
+	void TimeTravelSession::Apply(const Event& event)
+	{
+		switch (event.Kind)
+		{
+		case EventKind::TickTimers: Target.TickTimers(); break;
+		case EventKind::SetKeys: Target.SetKeys(event.Value); break;
+		case EventKind::KeyDown: Target.KeyDown(static_cast<uint8_t>(event.Value)); break;
+		case EventKind::KeyUp: Target.KeyUp(static_cast<uint8_t>(event.Value)); break;
+		}
+	}
+
+	void TimeTravelSession::ApplyEvents()
+	{
+		while (NextEvent < Events.size() && Events[NextEvent].Position == Position)
+		{
+			Apply(Events[NextEvent++]);
+		}
+	}
+
+	void TimeTravelSession::Restore(const Keyframe& keyframe)
+	{
+		Target.LoadState(keyframe.State);
+		Position = keyframe.Position;
+		NextEvent = keyframe.EventIndex;
+	}
+
+	void TimeTravelSession::Replay(const uint64_t target)
+	{
+		for (;;)
+		{
+			ApplyEvents();
+			if (Position >= target) return;
+			const uint64_t stop = NextEvent < Events.size() ? std::min(target, Events[NextEvent].Position) : target;
+			for (; Position < stop; ++Position)
+			{
+				Target.Tick();
+			}
+		}
+	}
+
+	uint64_t TimeTravelSession::FindLast(const Keyframe& keyframe, const uint64_t limit, MemoryWatchpoints* watch)
+	{
+		Restore(keyframe);
+		uint64_t last = NoMatch;
+		Target.SetWatchpoints(watch);
+		for (;;)
+		{
+			ApplyEvents();
+			if (Position >= limit) break;
+			if (watch)
+			{
+				watch->Hit = false;
+				Target.Tick();
+				if (watch->Hit) last = Position;
+			}
+			else
+			{
+				if (Debug.HasBreakpoint(Target.GetPC())) last = Position;
+				Target.Tick();
+			}
+			Position++;
+		}
+		Target.SetWatchpoints(nullptr);
+		return last;
+	}
+
+	bool TimeTravelSession::SearchBackwards(MemoryWatchpoints* watch)
+	{
+		const uint64_t origin = Position;
+		if (origin == 0) return false;
+
+		// Newest interval first: the one holding the position before origin, searched up to
+		// origin, then each earlier one in full.
+		size_t index = std::upper_bound(Keyframes.begin(), Keyframes.end(), origin - 1, [](const uint64_t value, const Keyframe& keyframe) { return value < keyframe.Position; }) - Keyframes.begin();
+		uint64_t limit = origin;
+		while (index-- > 0)
+		{
+			const uint64_t found = FindLast(Keyframes[index], limit, watch);
+			if (found != NoMatch) return Seek(found);
+			limit = Keyframes[index].Position;
+		}
+		Seek(0);
+		return false;
+	}
+}
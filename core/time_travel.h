@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "chip-8.h"
+#include "debugger.h"
+
+namespace chipotto
+{
+	// Reverse execution for a Debugger session. Everything that can change an Emulator from the
+	// outside (key input and timer ticks) goes through the session, which logs it against the
+	// number of instructions run so far, its position. Execution is deterministic given that
+	// log: timers only move when TickTimers is called and Cxnn draws from the snapshotted Rng.
+	//
+	// A keyframe (a full Snapshot) is taken every KeyframeInterval instructions. Going back
+	// restores the newest keyframe before the target and re-executes forward, replaying the
+	// log, so a reverse step costs at most one interval of interpretation: about half a
+	// millisecond at the default interval, independent of the session's length. Searches
+	// (reverse-continue) replay one interval at a time, newest first, and stop at the first
+	// interval holding a match.
+	//
+	// The state at position P is the state after P instructions and every input logged at P,
+	// i.e. just before instruction P + 1 runs. Running forward from a past position follows
+	// the log; logging new input there discards the rest of the recorded future.
+	class TimeTravelSession
+	{
+	public:
+		static constexpr uint32_t DefaultKeyframeInterval = 0x8000;
+
+		// Starts recording from the emulator's current state.
+		TimeTravelSession(Emulator& emulator, Debugger& debugger, const uint32_t keyframe_interval = DefaultKeyframeInterval);
+
+		// Debugger::Run, logging the instructions run.
+		DebugStop Run(const uint32_t instructions);
+		void TickTimers();
+		void SetKeys(const uint16_t keys);
+		void KeyDown(const uint8_t key);
+		void KeyUp(const uint8_t key);
+
+		// Goes back one instruction. False at the start of the recording.
+		bool StepBack();
+		// Goes back to the last position before this one where the next instruction has a
+		// breakpoint. False, at the start of the recording, if there is none.
+		bool ReverseContinue();
+		// Goes back to just before the last instruction that wrote to address, so the next
+		// step forward repeats the write. False, at the start of the recording, if none did.
+		bool ReverseToWrite(const uint32_t address);
+		// Restores any position from the start of the recording to its end.
+		bool Seek(const uint64_t position);
+
+		uint64_t GetPosition() const { return Position; };
+		// Furthest position recorded.
+		uint64_t GetEnd() const { return End; };
+		bool IsReplaying() const { return Position < End || NextEvent < Events.size(); };
+		size_t GetKeyframeCount() const { return Keyframes.size(); };
+
+	private:
+		enum class EventKind : uint8_t
+		{
+			TickTimers,
+			SetKeys,
+			KeyDown,
+			KeyUp
+		};
+
+		struct Event
+		{
+			uint64_t Position = 0;
+			EventKind Kind = EventKind::TickTimers;
+			uint16_t Value = 0;
+		};
+
+		struct Keyframe
+		{
+			uint64_t Position = 0;
+			// Events already applied to State.
+			size_t EventIndex = 0;
+			Snapshot State;
+		};
+
+		static constexpr uint64_t NoMatch = UINT64_MAX;
+
+		void Record(const EventKind kind, const uint16_t value);
+		void Apply(const Event& event);
+		// Applies the logged events at the current position that haven't been yet.
+		void ApplyEvents();
+		void Restore(const Keyframe& keyframe);
+		// Replays the log from the current position to target.
+		void Replay(const uint64_t target);
+		// Last position in [keyframe, limit) where the next instruction has a breakpoint (watch
+		// null) or writes to watch's range. Leaves the emulator at limit.
+		uint64_t FindLast(const Keyframe& keyframe, const uint64_t limit, MemoryWatchpoints* watch);
+		bool SearchBackwards(MemoryWatchpoints* watch);
+
+		Emulator& Target;
+		Debugger& Debug;
+		uint32_t KeyframeInterval;
+		uint64_t Position = 0;
+		uint64_t End = 0;
+		std::vector<Event> Events;
+		size_t NextEvent = 0;
+		// A deque so taking a keyframe never moves the others.
+		std::deque<Keyframe> Keyframes;
+	};
+}
@@ -0,0 +1,524 @@
+#include "trace.h"
+#include <algorithm>
+#include <cstring>
+#include "rom_hash.h"
+
+namespace chipotto
+{
+	// Record flags. A record's PC is only stored when it isn't the previous PC + 2.
+	static constexpr uint8_t RecordHasPC = 0x1;
+	static constexpr uint8_t RecordHasRegisters = 0x2;
+	static constexpr uint8_t RecordHasI = 0x4;
+	static constexpr uint8_t RecordHasWrite = 0x8;
+	// Flags, PC, opcode, register mask and values, I, write address, length and bytes.
+	static constexpr size_t MaxEncodedRecord = 1 + 2 + 2 + 2 + 16 + 4 + 4 + 1 + 16;
+
+	static void PutValue(std::vector<uint8_t>& out, const uint32_t value, const size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+
+	static bool GetValue(std::span<const uint8_t> in, size_t& offset, const size_t bytes, uint32_t& value)
+	{
+		if (in.size() - offset < bytes) return false;
+		value = 0;
+		for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint32_t>(in[offset++]) << (8 * i);
+		return true;
+	}
+
+	static void EncodeRecord(const TraceRecord& record, const bool explicit_pc, std::vector<uint8_t>& out)
+	{
+		uint8_t flags = 0;
+		if (explicit_pc) flags |= RecordHasPC;
+		if (record.ChangedRegisters) flags |= RecordHasRegisters;
+		if (record.IChanged) flags |= RecordHasI;
+		if (record.WriteLength) flags |= RecordHasWrite;
+		out.push_back(flags);
+		if (explicit_pc) PutValue(out, record.PC, 2);
+		PutValue(out, record.Opcode, 2);
+		if (record.ChangedRegisters)
+		{
+			PutValue(out, record.ChangedRegisters, 2);
+			for (uint32_t index = 0; index < 0x10; ++index)
+			{
+				if (record.ChangedRegisters & (1 << index)) out.push_back(record.Registers[index]);
+			}
+		}
+		if (record.IChanged) PutValue(out, record.I, 4);
+		if (record.WriteLength)
+		{
+			PutValue(out, record.WriteAddress, 4);
+			out.push_back(record.WriteLength);
+			out.insert(out.end(), record.Written.begin(), record.Written.begin() + record.WriteLength);
+		}
+	}
+
+	static bool DecodeRecord(std::span<const uint8_t> in, size_t& offset, const uint16_t previous_pc, TraceRecord& record)
+	{
+		record = TraceRecord{};
+		uint32_t value = 0;
+		if (!GetValue(in, offset, 1, value)) return false;
+		const uint8_t flags = static_cast<uint8_t>(value);
+		if (flags & RecordHasPC)
+		{
+			if (!GetValue(in, offset, 2, value)) return false;
+			record.PC = static_cast<uint16_t>(value);
+		}
+		else record.PC = static_cast<uint16_t>(previous_pc + 2);
+		if (!GetValue(in, offset, 2, value)) return false;
+		record.Opcode = static_cast<uint16_t>(value);
+		if (flags & RecordHasRegisters)
+		{
+			if (!GetValue(in, offset, 2, value)) return false;
+			record.ChangedRegisters = static_cast<uint16_t>(value);
+			for (uint32_t index = 0; index < 0x10; ++index)
+			{
+				if (!(record.ChangedRegisters & (1 << index))) continue;
+				if (!GetValue(in, offset, 1, value)) return false;
+				record.Registers[index] = static_cast<uint8_t>(value);
+			}
+		}
+		if (flags & RecordHasI)
+		{
+			record.IChanged = true;
+			if (!GetValue(in, offset, 4, record.I)) return false;
+		}
+		if (flags & RecordHasWrite)
+		{
+			if (!GetValue(in, offset, 4, record.WriteAddress) || !GetValue(in, offset, 1, value)) return false;
+			if (value == 0 || value > record.Written.size() || in.size() - offset < value) return false;
+			record.WriteLength = static_cast<uint8_t>(value);
+			std::copy_n(in.begin() + offset, value, record.Written.begin());
+			offset += value;
+		}
+		return true;
+	}
+
+	// Byte-oriented LZ77 in the style of LZ4: each sequence is a token (literal count in the
+	// high nibble, match length - 4 in the low one, 15 meaning more length bytes follow), the
+	// literals, then a 16-bit match offset. The last sequence has literals only.
+	static constexpr size_t MinMatch = 4;
+	static constexpr uint32_t HashBits = 12;
+
+	static void PutLength(std::vector<uint8_t>& out, size_t length)
+	{
+		for (; length >= 255; length -= 255) out.push_back(255);
+		out.push_back(static_cast<uint8_t>(length));
+	}
+
+	static void PutSequence(std::vector<uint8_t>& out, std::span<const uint8_t> literals, const size_t match_offset, const size_t match_length)
+	{
+		const size_t extra = match_length ? match_length - MinMatch : 0;
+		out.push_back(static_cast<uint8_t>((std::min<size_t>(literals.size(), 15) << 4) | std::min<size_t>(extra, 15)));
+		if (literals.size() >= 15) PutLength(out, literals.size() - 15);
+		out.insert(out.end(), literals.begin(), literals.end());
+		if (!match_length) return;
+		PutValue(out, static_cast<uint32_t>(match_offset), 2);
+		if (extra >= 15) PutLength(out, extra - 15);
+	}
+
+	static void Compress(std::span<const uint8_t> in, std::vector<uint8_t>& out)
+	{
+		out.clear();
+		// Positions + 1 of the last 4-byte sequence seen with each hash, 0 when none.
+		std::vector<uint32_t> table(size_t(1) << HashBits, 0);
+		auto read = [&in](const size_t position)
+			{
+				uint32_t value;
+				std::memcpy(&value, in.data() + position, sizeof(value));
+				return value;
+			};
+
+		size_t anchor = 0;
+		size_t position = 0;
+		while (position + MinMatch <= in.size())
+		{
+			const uint32_t sequence = read(position);
+			const uint32_t hash = (sequence * 2654435761u) >> (32 - HashBits);
+			const size_t candidate = table[hash];
+			table[hash] = static_cast<uint32_t>(position + 1);
+			if (candidate == 0 || position - (candidate - 1) > 0xFFFF || read(candidate - 1) != sequence)
+			{
+				position++;
+				continue;
+			}
+
+			const size_t match = candidate - 1;
+			size_t length = MinMatch;
+			while (position + length < in.size() && in[match + length] == in[position + length]) length++;
+			PutSequence(out, in.subspan(anchor, position - anchor), position - match, length);
+			position += length;
+			anchor = position;
+		}
+		PutSequence(out, in.subspan(anchor), 0, 0);
+	}
+
+	static bool GetLength(std::span<const uint8_t> in, size_t& offset, size_t& length)
+	{
+		uint8_t byte = 255;
+		while (byte == 255)
+		{
+			if (offset >= in.size()) return false;
+			byte = in[offset++];
+			length += byte;
+		}
+		return true;
+	}
+
+	static bool Decompress(std::span<const uint8_t> in, const size_t raw_size, std::vector<uint8_t>& out)
+	{
+		out.clear();
+		out.reserve(raw_size);
+		size_t offset = 0;
+		while (offset < in.size())
+		{
+			const uint8_t token = in[offset++];
+			size_t literals = token >> 4;
+			if (literals == 15 && !GetLength(in, offset, literals)) return false;
+			if (in.size() - offset < literals || raw_size - out.size() < literals) return false;
+			out.insert(out.end(), in.begin() + offset, in.begin() + offset + literals);
+			offset += literals;
+			if (out.size() == raw_size) return offset == in.size();
+
+			uint32_t distance = 0;
+			if (!GetValue(in, offset, 2, distance) || distance == 0 || distance > out.size()) return false;
+			size_t length = token & 0xF;
+			if (length == 15 && !GetLength(in, offset, length)) return false;
+			length += MinMatch;
+			if (raw_size - out.size() < length) return false;
+			// Byte by byte: the match may overlap the bytes it produces.
+			for (size_t i = 0; i < length; ++i) out.push_back(out[out.size() - distance]);
+		}
+		return out.size() == raw_size;
+	}
+
+	TraceWriter::~TraceWriter()
+	{
+		if (IsOpen()) Close();
+	}
+
+	bool TraceWriter::Open(const std::filesystem::path& Path, const Emulator& emulator)
+	{
+		if (IsOpen()) return false;
+		File.open(Path, std::ios::binary | std::ios::trunc);
+		if (!File.is_open()) return false;
+
+		TraceHeader header;
+		header.ProgramHash = emulator.GetProgramHash();
+		header.Quirks = static_cast<uint32_t>(emulator.GetQuirks());
+		header.BlockRecords = BlockRecords;
+		if (!File.write(reinterpret_cast<const char*>(&header), sizeof(header)))
+		{
+			File.close();
+			return false;
+		}
+
+		Instructions = 0;
+		HasLast = false;
+		Current = PendingBlock{};
+		Current.Bytes.reserve(BlockRecords * 8);
+		Index.clear();
+		Offset = sizeof(header);
+		Closing = false;
+		Failed = false;
+		Worker = std::thread(&TraceWriter::Run, this);
+		return true;
+	}
+
+	bool TraceWriter::Close()
+	{
+		if (!IsOpen()) return false;
+		Submit();
+		{
+			std::lock_guard<std::mutex> guard(Lock);
+			Closing = true;
+		}
+		Queued.notify_one();
+		Worker.join();
+
+		TraceFooter footer;
+		footer.IndexOffset = Offset;
+		footer.BlockCount = static_cast<uint32_t>(Index.size());
+		File.write(reinterpret_cast<const char*>(Index.data()), Index.size() * sizeof(TraceIndexEntry));
+		File.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+		const bool written = !Failed && File.good();
+		File.close();
+		return written;
+	}
+
+	bool TraceWriter::Tick(Emulator& emulator)
+	{
+		const CpuState& cpu = emulator.GetCpuState();
+		// Tick doesn't run anything while waiting for a key.
+		if (cpu.Suspended) return true;
+		if (!HasLast)
+		{
+			Last = cpu;
+			HasLast = true;
+		}
+
+		const PagedMemory& memory = emulator.GetMemoryMapping();
+		TraceRecord record;
+		record.PC = cpu.PC;
+		record.Opcode = static_cast<uint16_t>((memory[cpu.PC] << 8) | memory[cpu.PC + 1]);
+		const uint32_t i = cpu.I;
+		const bool running = emulator.Tick();
+
+		for (uint32_t index = 0; index < 0x10; ++index)
+		{
+			if (cpu.Registers[index] == Last.Registers[index]) continue;
+			record.ChangedRegisters |= 1 << index;
+			record.Registers[index] = cpu.Registers[index];
+		}
+		if (cpu.I != Last.I)
+		{
+			record.IChanged = true;
+			record.I = cpu.I;
+		}
+
+		// Only these handlers store to memory, always from the I they started with.
+		const uint8_t x = (record.Opcode >> 8) & 0xF;
+		const uint8_t y = (record.Opcode >> 4) & 0xF;
+		if ((record.Opcode & 0xF00F) == 0x5002) record.WriteLength = (x > y ? x - y : y - x) + 1;
+		else if ((record.Opcode & 0xF0FF) == 0xF055) record.WriteLength = x + 1;
+		else if ((record.Opcode & 0xF0FF) == 0xF033) record.WriteLength = 3;
+		if (record.WriteLength)
+		{
+			record.WriteAddress = i;
+			for (uint32_t offset = 0; offset < record.WriteLength; ++offset) record.Written[offset] = memory[i + offset];
+		}
+
+		Last = cpu;
+		Append(record);
+		return running;
+	}
+
+	bool TraceWriter::RunFrame(Emulator& emulator, const uint32_t instructions)
+	{
+		for (uint32_t i = 0; i < instructions; ++i)
+		{
+			if (!Tick(emulator)) return false;
+			if (emulator.GetSuspended()) break;
+		}
+		emulator.TickTimers();
+		return true;
+	}
+
+	void TraceWriter::Append(const TraceRecord& record)
+	{
+		if (Current.Records == 0) Current.FirstInstruction = Instructions;
+		EncodeRecord(record, Current.Records == 0 || record.PC != static_cast<uint16_t>(PreviousPC + 2), Current.Bytes);
+		PreviousPC = record.PC;
+		Instructions++;
+		if (++Current.Records == BlockRecords) Submit();
+	}
+
+	void TraceWriter::Submit()
+	{
+		if (Current.Records == 0) return;
+		std::unique_lock<std::mutex> lock(Lock);
+		Drained.wait(lock, [this] { return Pending.size() < MaxPendingBlocks; });
+		Pending.push_back(std::move(Current));
+		Current = PendingBlock{};
+		if (!SpareBuffers.empty())
+		{
+			Current.Bytes = std::move(SpareBuffers.back());
+			SpareBuffers.pop_back();
+			Current.Bytes.clear();
+		}
+		lock.unlock();
+		Queued.notify_one();
+	}
+
+	void TraceWriter::Run()
+	{
+		std::vector<uint8_t> compressed;
+		std::unique_lock<std::mutex> lock(Lock);
+		while (true)
+		{
+			Queued.wait(lock, [this] { return !Pending.empty() || Closing; });
+			if (Pending.empty()) return;
+			PendingBlock block = std::move(Pending.front());
+			Pending.pop_front();
+			lock.unlock();
+			Drained.notify_one();
+
+			Compress(block.Bytes, compressed);
+			TraceBlockHeader header;
+			header.FirstInstruction = block.FirstInstruction;
+			header.RawHash = HashRom(block.Bytes);
+			header.Records = block.Records;
+			header.RawSize = static_cast<uint32_t>(block.Bytes.size());
+			header.CompressedSize = static_cast<uint32_t>(compressed.size());
+			File.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			File.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+
+			TraceIndexEntry entry;
+			entry.FirstInstruction = header.FirstInstruction;
+			entry.Offset = Offset;
+			entry.RawHash = header.RawHash;
+			entry.Records = header.Records;
+
+			lock.lock();
+			Index.push_back(entry);
+			Offset += sizeof(header) + compressed.size();
+			if (!File) Failed = true;
+			SpareBuffers.push_back(std::move(block.Bytes));
+		}
+	}
+
+	bool TraceReader::Open(const std::filesystem::path& Path)
+	{
+		File.close();
+		Index.clear();
+		File.open(Path, std::ios::binary);
+		if (!File.is_open()) return false;
+		if (!File.read(reinterpret_cast<char*>(&Header), sizeof(Header))) return false;
+		if (Header.Signature != TraceHeader::Magic || Header.Version != TraceHeader::CurrentVersion) return false;
+
+		File.seekg(0, std::ios::end);
+		const uint64_t size = static_cast<uint64_t>(File.tellg());
+		TraceFooter footer;
+		if (size >= sizeof(Header) + sizeof(footer))
+		{
+			File.seekg(size - sizeof(footer));
+			File.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+		}
+		if (File && footer.Signature == TraceFooter::Magic && footer.IndexOffset + uint64_t(footer.BlockCount) * sizeof(TraceIndexEntry) + sizeof(footer) == size)
+		{
+			Index.resize(footer.BlockCount);
+			File.seekg(footer.IndexOffset);
+			return static_cast<bool>(File.read(reinterpret_cast<char*>(Index.data()), Index.size() * sizeof(TraceIndexEntry)));
+		}
+
+		// No index: the writer didn't get to close the trace. Keep every complete block.
+		File.clear();
+		uint64_t offset = sizeof(Header);
+		TraceBlockHeader block;
+		while (offset + sizeof(block) <= size)
+		{
+			File.seekg(offset);
+			if (!File.read(reinterpret_cast<char*>(&block), sizeof(block))) break;
+			if (offset + sizeof(block) + block.CompressedSize > size) break;
+			TraceIndexEntry entry;
+			entry.FirstInstruction = block.FirstInstruction;
+			entry.Offset = offset;
+			entry.RawHash = block.RawHash;
+			entry.Records = block.Records;
+			Index.push_back(entry);
+			offset += sizeof(block) + block.CompressedSize;
+		}
+		File.clear();
+		return true;
+	}
+
+	uint64_t TraceReader::GetInstructionCount() const
+	{
+		return Index.empty() ? 0 : Index.back().FirstInstruction + Index.back().Records;
+	}
+
+	size_t TraceReader::FindBlock(const uint64_t instruction) const
+	{
+		const auto found = std::upper_bound(Index.begin(), Index.end(), instruction, [](const uint64_t value, const TraceIndexEntry& entry) { return value < entry.FirstInstruction; });
+		if (found == Index.begin()) return Index.size();
+		const TraceIndexEntry& entry = *(found - 1);
+		return instruction < entry.FirstInstruction + entry.Records ? static_cast<size_t>(found - 1 - Index.begin()) : Index.size();
+	}
+
+	bool TraceReader::ReadBlock(const size_t block, std::vector<TraceRecord>& records)
+	{
+		records.clear();
+		if (block >= Index.size()) return false;
+		const TraceIndexEntry& entry = Index[block];
+		TraceBlockHeader header;
+		File.clear();
+		File.seekg(entry.Offset);
+		if (!File.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+		if (header.Records != entry.Records || header.RawSize > uint64_t(header.Records) * MaxEncodedRecord) return false;
+
+		Compressed.resize(header.CompressedSize);
+		if (!File.read(reinterpret_cast<char*>(Compressed.data()), Compressed.size())) return false;
+		if (!Decompress(Compressed, header.RawSize, Raw) || HashRom(Raw) != header.RawHash) return false;
+
+		records.resize(header.Records);
+		size_t offset = 0;
+		uint16_t pc = 0;
+		for (TraceRecord& record : records)
+		{
+			if (!DecodeRecord(Raw, offset, pc, record)) return false;
+			pc = record.PC;
+		}
+		return offset == Raw.size();
+	}
+
+	bool FindFirstTraceMismatch(TraceReader& expected, TraceReader& actual, TraceMismatch& mismatch)
+	{
+		std::vector<TraceRecord> expected_records;
+		std::vector<TraceRecord> actual_records;
+		size_t expected_loaded = SIZE_MAX;
+		size_t actual_loaded = SIZE_MAX;
+		auto load = [](TraceReader& reader, const size_t block, size_t& loaded, std::vector<TraceRecord>& records)
+			{
+				if (loaded == block) return true;
+				loaded = reader.ReadBlock(block, records) ? block : SIZE_MAX;
+				return loaded == block;
+			};
+
+		const uint64_t expected_count = expected.GetInstructionCount();
+		const uint64_t actual_count = actual.GetInstructionCount();
+		const uint64_t common = std::min(expected_count, actual_count);
+		uint64_t instruction = 0;
+		while (instruction < common)
+		{
+			const size_t expected_block = expected.FindBlock(instruction);
+			const size_t actual_block = actual.FindBlock(instruction);
+			const TraceIndexEntry& expected_entry = expected.GetIndex()[expected_block];
+			const TraceIndexEntry& actual_entry = actual.GetIndex()[actual_block];
+			if (expected_entry.FirstInstruction == actual_entry.FirstInstruction && expected_entry.Records == actual_entry.Records && expected_entry.RawHash == actual_entry.RawHash)
+			{
+				instruction = expected_entry.FirstInstruction + expected_entry.Records;
+				continue;
+			}
+
+			const bool has_expected = load(expected, expected_block, expected_loaded, expected_records);
+			const bool has_actual = load(actual, actual_block, actual_loaded, actual_records);
+			if (!has_expected || !has_actual)
+			{
+				// An unreadable block counts as the end of that trace.
+				mismatch = TraceMismatch{};
+				mismatch.Instruction = instruction;
+				mismatch.HasExpected = has_expected;
+				mismatch.HasActual = has_actual;
+				if (has_expected) mismatch.Expected = expected_records[instruction - expected_entry.FirstInstruction];
+				if (has_actual) mismatch.Actual = actual_records[instruction - actual_entry.FirstInstruction];
+				return true;
+			}
+
+			const uint64_t end = std::min(expected_entry.FirstInstruction + expected_entry.Records, actual_entry.FirstInstruction + actual_entry.Records);
+			for (; instruction < end; ++instruction)
+			{
+				const TraceRecord& expected_record = expected_records[instruction - expected_entry.FirstInstruction];
+				const TraceRecord& actual_record = actual_records[instruction - actual_entry.FirstInstruction];
+				if (expected_record == actual_record) continue;
+				mismatch = TraceMismatch{};
+				mismatch.Instruction = instruction;
+				mismatch.HasExpected = mismatch.HasActual = true;
+				mismatch.Expected = expected_record;
+				mismatch.Actual = actual_record;
+				return true;
+			}
+		}
+		if (expected_count == actual_count) return false;
+
+		// One trace is a prefix of the other.
+		mismatch = TraceMismatch{};
+		mismatch.Instruction = common;
+		TraceReader& longer = expected_count > actual_count ? expected : actual;
+		std::vector<TraceRecord>& records = expected_count > actual_count ? expected_records : actual_records;
+		const size_t block = longer.FindBlock(common);
+		if (!longer.ReadBlock(block, records)) return true;
+		(expected_count > actual_count ? mismatch.HasExpected : mismatch.HasActual) = true;
+		(expected_count > actual_count ? mismatch.Expected : mismatch.Actual) = records[common - longer.GetIndex()[block].FirstInstruction];
+		return true;
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "chip-8.h"
+
+namespace chipotto
+{
+	// What one executed instruction did: where it ran and what it changed since the previous
+	// record. Fields a record doesn't use stay zero, so records compare with ==.
+	struct TraceRecord
+	{
+		uint16_t PC = 0;
+		uint16_t Opcode = 0;
+		// Bit n set when Vn changed; Registers holds the new values of those registers only.
+		uint16_t ChangedRegisters = 0;
+		std::array<uint8_t, 0x10> Registers{};
+		bool IChanged = false;
+		uint32_t I = 0;
+		// Bytes stored by Fx55, Fx33 and 5xy2, from WriteAddress up.
+		uint8_t WriteLength = 0;
+		uint32_t WriteAddress = 0;
+		std::array<uint8_t, 0x10> Written{};
+
+		bool operator==(const TraceRecord& other) const = default;
+	};
+
+	// Trace file layout (little endian):
+	//   header   TraceHeader
+	//   blocks   { TraceBlockHeader, compressed records }, one per BlockRecords instructions
+	//   index    TraceIndexEntry per block
+	//   footer   TraceFooter
+	// Records are delta-encoded within a block and each block is LZ-compressed on its own, so
+	// any block can be decoded from its index entry. A trace whose writer never closed it has
+	// no index; readers rebuild it by walking the block headers.
+	struct TraceHeader
+	{
+		static constexpr uint32_t Magic = 0x52543843; // "C8TR"
+		static constexpr uint32_t CurrentVersion = 1;
+
+		uint32_t Signature = Magic;
+		uint32_t Version = CurrentVersion;
+		uint64_t ProgramHash = 0;
+		uint32_t Quirks = 0;
+		uint32_t BlockRecords = 0;
+	};
+	static_assert(sizeof(TraceHeader) == 24);
+
+	struct TraceBlockHeader
+	{
+		uint64_t FirstInstruction = 0;
+		// HashRom of the uncompressed records: equal hashes let a diff skip a block unread.
+		uint64_t RawHash = 0;
+		uint32_t Records = 0;
+		uint32_t RawSize = 0;
+		uint32_t CompressedSize = 0;
+		uint32_t Reserved = 0;
+	};
+	static_assert(sizeof(TraceBlockHeader) == 32);
+
+	struct TraceIndexEntry
+	{
+		uint64_t FirstInstruction = 0;
+		uint64_t Offset = 0;
+		uint64_t RawHash = 0;
+		uint32_t Records = 0;
+		uint32_t Reserved = 0;
+	};
+	static_assert(sizeof(TraceIndexEntry) == 32);
+
+	struct TraceFooter
+	{
+		static constexpr uint32_t Magic = 0x49543843; // "C8TI"
+
+		uint64_t IndexOffset = 0;
+		uint32_t BlockCount = 0;
+		uint32_t Signature = Magic;
+	};
+	static_assert(sizeof(TraceFooter) == 16);
+
+	// Records every instruction an Emulator runs through it. Encoding happens on the calling
+	// thread; compression and file writes happen on a background thread, which the caller
+	// only waits for when MaxPendingBlocks blocks are queued.
+	class TraceWriter
+	{
+	public:
+		static constexpr uint32_t BlockRecords = 0x4000;
+		static constexpr size_t MaxPendingBlocks = 8;
+
+		TraceWriter() = default;
+		~TraceWriter();
+		TraceWriter(const TraceWriter& other) = delete;
+		TraceWriter& operator=(const TraceWriter& other) = delete;
+
+		bool Open(const std::filesystem::path& Path, const Emulator& emulator);
+		// Flushes the last block and writes the index. Returns false if any write failed.
+		bool Close();
+		bool IsOpen() const { return File.is_open(); };
+
+		// Emulator::Tick and Emulator::RunFrame (without idle skipping), recording each
+		// instruction executed.
+		bool Tick(Emulator& emulator);
+		bool RunFrame(Emulator& emulator, const uint32_t instructions);
+		void Append(const TraceRecord& record);
+
+		uint64_t GetInstructionCount() const { return Instructions; };
+
+	private:
+		struct PendingBlock
+		{
+			uint64_t FirstInstruction = 0;
+			uint32_t Records = 0;
+			std::vector<uint8_t> Bytes;
+		};
+
+		void Submit();
+		void Run();
+
+		std::ofstream File;
+		uint64_t Instructions = 0;
+		// State after the last recorded instruction, which the next record is a delta against.
+		CpuState Last;
+		bool HasLast = false;
+		PendingBlock Current;
+		uint16_t PreviousPC = 0;
+
+		std::thread Worker;
+		std::mutex Lock;
+		std::condition_variable Queued;
+		std::condition_variable Drained;
+		std::deque<PendingBlock> Pending;
+		std::vector<std::vector<uint8_t>> SpareBuffers;
+		std::vector<TraceIndexEntry> Index;
+		uint64_t Offset = 0;
+		bool Closing = false;
+		bool Failed = false;
+	};
+
+	class TraceReader
+	{
+	public:
+		bool Open(const std::filesystem::path& Path);
+
+		uint64_t GetProgramHash() const { return Header.ProgramHash; };
+		QuirkProfile GetQuirks() const { return static_cast<QuirkProfile>(Header.Quirks); };
+		uint64_t GetInstructionCount() const;
+		const std::vector<TraceIndexEntry>& GetIndex() const { return Index; };
+		// Block holding the given instruction, or the block count when it is past the end.
+		size_t FindBlock(const uint64_t instruction) const;
+		// Decodes one block's records into records, replacing its contents.
+		bool ReadBlock(const size_t block, std::vector<TraceRecord>& records);
+
+	private:
+		std::ifstream File;
+		TraceHeader Header;
+		std::vector<TraceIndexEntry> Index;
+		std::vector<uint8_t> Compressed;
+		std::vector<uint8_t> Raw;
+	};
+
+	struct TraceMismatch
+	{
+		uint64_t Instruction = 0;
+		// False when that trace ended before Instruction.
+		bool HasExpected = false;
+		bool HasActual = false;
+		TraceRecord Expected;
+		TraceRecord Actual;
+	};
+
+	// Finds the first instruction at which two traces differ. Blocks covering the same
+	// instructions with equal hashes are skipped without decompressing them. Returns false
+	// when the traces are identical.
+	bool FindFirstTraceMismatch(TraceReader& expected, TraceReader& actual, TraceMismatch& mismatch);
+}
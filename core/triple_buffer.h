@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace chipotto
+{
+	// Lock-free single producer / single consumer handoff of the latest value. The producer
+	// always owns one slot, the consumer another, and the third is swapped between them
+	// through one atomic. Neither side ever waits: the producer overwrites a frame the
+	// consumer hasn't picked up yet, and the consumer keeps its current frame until a newer
+	// one is published.
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		T& GetWriteBuffer() { return Slots[WriteIndex]; };
+		const T& GetReadBuffer() const { return Slots[ReadIndex]; };
+
+		// Producer side: hands the write slot over and takes the spare one.
+		void Publish()
+		{
+			const uint8_t previous = Spare.exchange(WriteIndex | FreshBit, std::memory_order_acq_rel);
+			WriteIndex = previous & IndexMask;
+		};
+
+		// Consumer side: returns true and makes the newest published value readable if
+		// anything was published since the last call.
+		bool Consume()
+		{
+			if (!(Spare.load(std::memory_order_relaxed) & FreshBit)) return false;
+			const uint8_t previous = Spare.exchange(ReadIndex, std::memory_order_acq_rel);
+			ReadIndex = previous & IndexMask;
+			return true;
+		};
+
+	private:
+		static constexpr uint8_t FreshBit = 0x4;
+		static constexpr uint8_t IndexMask = 0x3;
+
+		std::array<T, 3> Slots{};
+		alignas(64) std::atomic<uint8_t> Spare{ 1 };
+		alignas(64) uint8_t WriteIndex = 0;
+		alignas(64) uint8_t ReadIndex = 2;
+	};
+}
@@ -0,0 +1,117 @@
+#include "udp_socket.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+using socklen_t = int;
+using NativeSocket = SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using NativeSocket = int;
+#endif
+
+namespace chipotto
+{
+	UdpSocket::~UdpSocket()
+	{
+		Close();
+	}
+
+	bool UdpSocket::Open(const uint16_t port)
+	{
+		Close();
+#ifdef _WIN32
+		static const bool started = []()
+			{
+				WSADATA data;
+				return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+			}();
+		if (!started) return false;
+		NativeSocket handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (handle == INVALID_SOCKET) return false;
+		u_long non_blocking = 1;
+		if (ioctlsocket(handle, FIONBIO, &non_blocking) != 0)
+		{
+			closesocket(handle);
+			return false;
+		}
+#else
+		NativeSocket handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (handle < 0) return false;
+		if (fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) != 0)
+		{
+			close(handle);
+			return false;
+		}
+#endif
+		Handle = static_cast<intptr_t>(handle);
+
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		address.sin_port = htons(port);
+		socklen_t length = sizeof(address);
+		if (bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+			getsockname(handle, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+		{
+			Close();
+			return false;
+		}
+		Port = ntohs(address.sin_port);
+		return true;
+	}
+
+	void UdpSocket::Close()
+	{
+		if (Handle == InvalidHandle) return;
+#ifdef _WIN32
+		closesocket(static_cast<NativeSocket>(Handle));
+#else
+		close(static_cast<int>(Handle));
+#endif
+		Handle = InvalidHandle;
+		Port = 0;
+	}
+
+	bool UdpSocket::SetPeer(const char* host, const uint16_t port)
+	{
+		in_addr address;
+		if (inet_pton(AF_INET, host, &address) != 1) return false;
+		PeerAddress = address.s_addr;
+		PeerPort = htons(port);
+		return true;
+	}
+
+	bool UdpSocket::Send(std::span<const uint8_t> data)
+	{
+		if (Handle == InvalidHandle || !PeerPort) return false;
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = PeerAddress;
+		address.sin_port = PeerPort;
+		const auto sent = sendto(static_cast<NativeSocket>(Handle), reinterpret_cast<const char*>(data.data()), static_cast<int>(data.size()), 0,
+			reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+		return sent >= 0 && static_cast<size_t>(sent) == data.size();
+	}
+
+	int UdpSocket::Receive(std::span<uint8_t> buffer)
+	{
+		if (Handle == InvalidHandle) return -1;
+		while (true)
+		{
+			sockaddr_in address = {};
+			socklen_t length = sizeof(address);
+			const auto received = recvfrom(static_cast<NativeSocket>(Handle), reinterpret_cast<char*>(buffer.data()), static_cast<int>(buffer.size()), 0,
+				reinterpret_cast<sockaddr*>(&address), &length);
+			if (received < 0) return -1;
+			if (address.sin_addr.s_addr == PeerAddress && address.sin_port == PeerPort) return static_cast<int>(received);
+		}
+	}
+}
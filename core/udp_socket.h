@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace chipotto
+{
+	// Non-blocking IPv4 UDP socket talking to a single peer. Enough for netplay between two
+	// instances; there is no connection state beyond the peer address.
+	class UdpSocket
+	{
+	public:
+		UdpSocket() = default;
+		~UdpSocket();
+		UdpSocket(const UdpSocket& other) = delete;
+		UdpSocket& operator=(const UdpSocket& other) = delete;
+
+		// Binds to the given port on all interfaces; port 0 picks a free one (see GetPort).
+		bool Open(const uint16_t port);
+		void Close();
+		bool IsOpen() const { return Handle != InvalidHandle; };
+		uint16_t GetPort() const { return Port; };
+
+		// host is a dotted IPv4 address, e.g. "127.0.0.1".
+		bool SetPeer(const char* host, const uint16_t port);
+		bool Send(std::span<const uint8_t> data);
+		// Returns the size of the next datagram from the peer, or -1 when none is waiting.
+		// Datagrams from other addresses are dropped.
+		int Receive(std::span<uint8_t> buffer);
+
+	private:
+		static constexpr intptr_t InvalidHandle = -1;
+
+		intptr_t Handle = InvalidHandle;
+		uint16_t Port = 0;
+		uint32_t PeerAddress = 0;
+		uint16_t PeerPort = 0;
+	};
+}
@@ -0,0 +1,205 @@
+#include "chip8.h"
+
+#include <cstddef>
+#include "chip-8.h"
+
+using chipotto::CpuState;
+using chipotto::Emulator;
+using chipotto::QuirkProfile;
+
+// The C handles wrap the core types directly. No exception may cross the C boundary, so
+// everything that can allocate is guarded.
+struct chip8
+{
+	Emulator Core;
+};
+
+struct chip8_state
+{
+	chipotto::Snapshot Core;
+};
+
+static_assert(sizeof(chip8_cpu_t) == sizeof(CpuState), "chip8_cpu_t must mirror CpuState");
+static_assert(offsetof(chip8_cpu_t, stack) == offsetof(CpuState, Stack));
+static_assert(offsetof(chip8_cpu_t, i) == offsetof(CpuState, I));
+static_assert(offsetof(chip8_cpu_t, pc) == offsetof(CpuState, PC));
+static_assert(offsetof(chip8_cpu_t, keys) == offsetof(CpuState, Keys));
+static_assert(offsetof(chip8_cpu_t, sp) == offsetof(CpuState, SP));
+static_assert(offsetof(chip8_cpu_t, delay_timer) == offsetof(CpuState, DelayTimer));
+static_assert(offsetof(chip8_cpu_t, sound_timer) == offsetof(CpuState, SoundTimer));
+static_assert(offsetof(chip8_cpu_t, wait_register) == offsetof(CpuState, WaitForKeyboardRegister_Index));
+static_assert(offsetof(chip8_cpu_t, suspended) == offsetof(CpuState, Suspended));
+static_assert(sizeof(bool) == 1, "CpuState::Suspended is exposed as a byte");
+static_assert(static_cast<int>(CHIP8_QUIRKS_MEGA_CHIP) == static_cast<int>(QuirkProfile::MegaChip));
+
+uint32_t chip8_get_abi_version(void)
+{
+	return CHIP8_ABI_VERSION;
+}
+
+chip8_t* chip8_create(void)
+{
+	// nothrow only covers the handle itself; the Emulator constructor allocates too.
+	try
+	{
+		return new chip8();
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void chip8_destroy(chip8_t* emulator)
+{
+	delete emulator;
+}
+
+int chip8_load_rom(chip8_t* emulator, const uint8_t* data, size_t size, uint32_t memory_size)
+{
+	if (!data && size) return 0;
+	try
+	{
+		return emulator->Core.LoadFromMemory(std::span<const uint8_t>(data, size), memory_size);
+	}
+	catch (...)
+	{
+		return 0;
+	}
+}
+
+int chip8_set_quirks(chip8_t* emulator, chip8_quirks quirks)
+{
+	if (quirks < CHIP8_QUIRKS_CHIPOTTO || quirks > CHIP8_QUIRKS_MEGA_CHIP) return 0;
+	emulator->Core.SetQuirks(static_cast<QuirkProfile>(quirks));
+	return 1;
+}
+
+chip8_quirks chip8_get_quirks(const chip8_t* emulator)
+{
+	return static_cast<chip8_quirks>(emulator->Core.GetQuirks());
+}
+
+void chip8_set_seed(chip8_t* emulator, uint64_t seed)
+{
+	emulator->Core.SetSeed(seed);
+}
+
+int chip8_run_cycles(chip8_t* emulator, uint32_t cycles)
+{
+	try
+	{
+		for (uint32_t i = 0; i < cycles; ++i)
+		{
+			if (!emulator->Core.Tick()) return 0;
+		}
+		return 1;
+	}
+	catch (...)
+	{
+		return 0;
+	}
+}
+
+int chip8_run_frame(chip8_t* emulator, uint32_t instructions)
+{
+	try
+	{
+		return emulator->Core.RunFrame(instructions);
+	}
+	catch (...)
+	{
+		return 0;
+	}
+}
+
+void chip8_set_keys(chip8_t* emulator, uint16_t keys)
+{
+	emulator->Core.SetKeys(keys);
+}
+
+const chip8_cpu_t* chip8_get_cpu(const chip8_t* emulator)
+{
+	return reinterpret_cast<const chip8_cpu_t*>(&emulator->Core.GetCpuState());
+}
+
+void chip8_read_memory(const chip8_t* emulator, uint32_t address, uint8_t* output, size_t size)
+{
+	emulator->Core.GetMemoryMapping().ReadBlock(address, std::span<uint8_t>(output, size));
+}
+
+void chip8_get_screen_size(const chip8_t* emulator, int* width, int* height)
+{
+	if (width) *width = emulator->Core.GetWidth();
+	if (height) *height = emulator->Core.GetHeight();
+}
+
+const uint64_t* chip8_get_plane(const chip8_t* emulator, int plane)
+{
+	const chipotto::Framebuffer& display = emulator->Core.GetFramebuffer();
+	if (plane < 0 || plane >= chipotto::Framebuffer::MaxPlanes) return nullptr;
+	if (plane > 0 && !display.HasExtraPlanes()) return nullptr;
+	return display.GetPlane(plane)[0].data();
+}
+
+const uint8_t* chip8_get_mega_pixels(const chip8_t* emulator)
+{
+	const chipotto::Framebuffer& display = emulator->Core.GetFramebuffer();
+	return display.Mega ? display.Mega->Pixels.data() : nullptr;
+}
+
+const uint32_t* chip8_get_mega_palette(const chip8_t* emulator)
+{
+	const chipotto::Framebuffer& display = emulator->Core.GetFramebuffer();
+	return display.Mega ? display.Mega->Palette.data() : nullptr;
+}
+
+chip8_state_t* chip8_state_create(void)
+{
+	try
+	{
+		return new chip8_state();
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void chip8_state_destroy(chip8_state_t* state)
+{
+	delete state;
+}
+
+int chip8_save_state(const chip8_t* emulator, chip8_state_t* state)
+{
+	try
+	{
+		emulator->Core.SaveState(state->Core);
+		return 1;
+	}
+	catch (...)
+	{
+		return 0;
+	}
+}
+
+int chip8_load_state(chip8_t* emulator, const chip8_state_t* state)
+{
+	// A default-constructed state has no memory image to restore.
+	if (!state->Core.Memory.Image) return 0;
+	try
+	{
+		emulator->Core.LoadState(state->Core);
+		return 1;
+	}
+	catch (...)
+	{
+		return 0;
+	}
+}
+
+uint64_t chip8_get_checksum(const chip8_t* emulator)
+{
+	return emulator->Core.GetStateChecksum();
+}
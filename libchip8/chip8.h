@@ -0,0 +1,108 @@
+#pragma once
+
+/* Plain C interface to the chipotto core, for embedding it in other languages through FFI.
+ * Nothing here depends on SDL: frontends own the window, audio and keyboard mapping.
+ *
+ * Pointers returned by the getters alias the emulator's own state, so reading the screen or
+ * registers never copies. They stay valid until chip8_destroy, except the framebuffer ones,
+ * which are also invalidated by any call that changes the display mode (running code or
+ * loading a state). Functions returning int return 1 on success and 0 on failure. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(CHIP8_STATIC)
+#define CHIP8_API
+#elif defined(_WIN32)
+#if defined(CHIP8_BUILD_DLL)
+#define CHIP8_API __declspec(dllexport)
+#else
+#define CHIP8_API __declspec(dllimport)
+#endif
+#else
+#define CHIP8_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped whenever a signature or struct layout below changes. */
+#define CHIP8_ABI_VERSION 1
+
+typedef struct chip8 chip8_t;
+typedef struct chip8_state chip8_state_t;
+
+typedef enum chip8_quirks
+{
+	CHIP8_QUIRKS_CHIPOTTO = 0,
+	CHIP8_QUIRKS_COSMAC_VIP = 1,
+	CHIP8_QUIRKS_SUPER_CHIP = 2,
+	CHIP8_QUIRKS_XO_CHIP = 3,
+	CHIP8_QUIRKS_MEGA_CHIP = 4
+} chip8_quirks;
+
+/* Same layout as the core's CpuState: one 64-byte block. */
+typedef struct chip8_cpu
+{
+	uint8_t registers[16];
+	uint16_t stack[16];
+	uint32_t i;
+	uint16_t pc;
+	uint16_t keys;
+	uint8_t sp;
+	uint8_t delay_timer;
+	uint8_t sound_timer;
+	uint8_t wait_register;
+	uint8_t suspended;
+	uint8_t reserved[3];
+} chip8_cpu_t;
+
+CHIP8_API uint32_t chip8_get_abi_version(void);
+
+/* Returns NULL if out of memory. */
+CHIP8_API chip8_t* chip8_create(void);
+CHIP8_API void chip8_destroy(chip8_t* emulator);
+
+/* Loads a program at 0x200. A memory_size of 0 picks the smallest of 4 KB, 64 KB and 16 MB
+ * that fits it. */
+CHIP8_API int chip8_load_rom(chip8_t* emulator, const uint8_t* data, size_t size, uint32_t memory_size);
+CHIP8_API int chip8_set_quirks(chip8_t* emulator, chip8_quirks quirks);
+CHIP8_API chip8_quirks chip8_get_quirks(const chip8_t* emulator);
+/* Seeds the generator behind Cxnn; the same seed and inputs always replay the same run. */
+CHIP8_API void chip8_set_seed(chip8_t* emulator, uint64_t seed);
+
+/* Both return 0 once the program exits or hits an invalid instruction. */
+CHIP8_API int chip8_run_cycles(chip8_t* emulator, uint32_t cycles);
+/* Runs up to instructions cycles, then ticks the 60 Hz timers once. */
+CHIP8_API int chip8_run_frame(chip8_t* emulator, uint32_t instructions);
+
+/* Bit n set means key n is held. A key newly pressed ends an Fx0A wait. */
+CHIP8_API void chip8_set_keys(chip8_t* emulator, uint16_t keys);
+
+CHIP8_API const chip8_cpu_t* chip8_get_cpu(const chip8_t* emulator);
+/* Copies size bytes of address space starting at address; reads past the end wrap. */
+CHIP8_API void chip8_read_memory(const chip8_t* emulator, uint32_t address, uint8_t* output, size_t size);
+
+/* Current screen size in pixels: 64x32, 128x64, or 256x192 in MEGA-CHIP mode. */
+CHIP8_API void chip8_get_screen_size(const chip8_t* emulator, int* width, int* height);
+/* Bitplane as 64 rows of two uint64_t words, leftmost pixel in the most significant bit of the
+ * first word. Low resolution uses the first word of the first 32 rows. Returns NULL for
+ * XO-CHIP planes 1-3 until the program selects them. */
+CHIP8_API const uint64_t* chip8_get_plane(const chip8_t* emulator, int plane);
+/* MEGA-CHIP screen as 256x192 palette indices and its 256 colours as R, G, B, A bytes; NULL outside that mode. */
+CHIP8_API const uint8_t* chip8_get_mega_pixels(const chip8_t* emulator);
+CHIP8_API const uint32_t* chip8_get_mega_palette(const chip8_t* emulator);
+
+/* Save states are opaque. Reuse one for repeated saves: after the first they don't allocate.
+ * Returns NULL if out of memory. */
+CHIP8_API chip8_state_t* chip8_state_create(void);
+CHIP8_API void chip8_state_destroy(chip8_state_t* state);
+CHIP8_API int chip8_save_state(const chip8_t* emulator, chip8_state_t* state);
+CHIP8_API int chip8_load_state(chip8_t* emulator, const chip8_state_t* state);
+/* Hash of everything the program can observe, for comparing runs. */
+CHIP8_API uint64_t chip8_get_checksum(const chip8_t* emulator);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "chip-8.h"
+#include "profile_db.h"
+#include "recompiler.h"
+
+// Translates the recompiler-eligible ROMs of a library to C++. Each ROM becomes
+// rom_<hash>.cpp defining Rom_<hash>, and recompiled_library.cpp lists them all for
+// FindRecompiledProgram. Build the output with the host compiler at -O2 alongside the core.
+int main(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		std::fprintf(stderr, "Usage: %s <profile database> <output directory> <rom>...\n", argv[0]);
+		return -1;
+	}
+
+	chipotto::ProfileDatabase profiles;
+	if (!profiles.LoadFromFile(argv[1]))
+	{
+		std::fprintf(stderr, "Unable to read profile database %s\n", argv[1]);
+		return -1;
+	}
+	const std::filesystem::path output = argv[2];
+
+	std::vector<std::string> names;
+	for (int i = 3; i < argc; ++i)
+	{
+		chipotto::Emulator emulator;
+		if (!emulator.LoadFromFile(argv[i]))
+		{
+			std::fprintf(stderr, "%s: unable to load\n", argv[i]);
+			continue;
+		}
+		const uint64_t hash = emulator.GetProgramHash();
+		const chipotto::ExecutionProfile* profile = profiles.Find(hash);
+		if (!profile || !profile->RecompilerEligible)
+		{
+			std::fprintf(stderr, "%s: not marked recompiler-eligible, skipped\n", argv[i]);
+			continue;
+		}
+
+		char hash_text[17];
+		std::snprintf(hash_text, sizeof(hash_text), "%016llx", static_cast<unsigned long long>(hash));
+		const std::string name = std::string("Rom_") + hash_text;
+		chipotto::RecompilerStats stats;
+		const std::string source = chipotto::RecompileRom(*emulator.GetMemoryMapping().GetImage(), profile->Quirks, name, &stats);
+
+		std::ofstream file(output / ("rom_" + std::string(hash_text) + ".cpp"), std::ios::trunc);
+		if (!(file << source))
+		{
+			std::fprintf(stderr, "%s: unable to write output\n", argv[i]);
+			return -1;
+		}
+		names.push_back(name);
+		std::printf("%s: %s, %u blocks, %u of %u instructions inlined\n", argv[i], name.c_str(), stats.Blocks, stats.Inlined, stats.Instructions);
+	}
+
+	std::ofstream library(output / "recompiled_library.cpp", std::ios::trunc);
+	library << "// Generated by the chipotto static recompiler. Do not edit.\n#include \"recompiled_program.h\"\n\n";
+	for (const std::string& name : names)
+	{
+		library << "extern const chipotto::RecompiledProgram " << name << ";\n";
+	}
+	library << "\nnamespace chipotto\n{\n\tconst RecompiledProgram* const RecompiledLibrary[] =\n\t{\n";
+	for (const std::string& name : names)
+	{
+		library << "\t\t&::" << name << ",\n";
+	}
+	library << "\t\tnullptr\n\t};\n\tconst size_t RecompiledLibrarySize = " << names.size() << ";\n}\n";
+	return library ? 0 : -1;
+}
@@ -2,19 +2,20 @@
 #include "clove-unit.h"
 #include "chip-8.h"
 #include <array>
+#include <cstring>
 
 CLOVE_TEST(Opcode0_CLS)
 {
     chipotto::Emulator emulator;
     chipotto::OpcodeStatus status;
 
-    int* ExpectedTexture = reinterpret_cast<int*>(SDL_calloc(emulator.GetHeight() * emulator.GetWidth(), sizeof(int)));
-    int* Texture = nullptr;
-    int Pitch;
-    SDL_LockTexture(emulator.GetTexture(), nullptr, reinterpret_cast<void**>(&Texture), &Pitch);
-    CLOVE_INT_EQ(0, SDL_memcmp(ExpectedTexture, Texture, emulator.GetHeight() * emulator.GetWidth() * sizeof(int)));
-    SDL_UnlockTexture(emulator.GetTexture());
+    emulator.Opcode6(0x6000);
+    emulator.OpcodeA(0xA000);
+    emulator.OpcodeD(0xD005);
+    CLOVE_INT_EQ(1, emulator.GetFramebuffer().GetPixel(0, 0));
     status = emulator.Opcode0(0xE0);
+    const chipotto::Framebuffer ExpectedFramebuffer{};
+    CLOVE_IS_TRUE(ExpectedFramebuffer.Rows == emulator.GetFramebuffer().Rows);
     CLOVE_INT_EQ(static_cast<int>(chipotto::OpcodeStatus::IncrementPC), static_cast<int>(status));
 }
 
@@ -100,7 +101,7 @@ CLOVE_TEST(Opcode5_SE_Vx_byte)
     uint16_t opcode = 0x5000;
     emulator.Opcode5(opcode);
     CLOVE_INT_EQ(emulator.GetPC(), PC + 2);
-    opcode = 0x5101;
+    opcode = 0x5100;
     emulator.Opcode6(0x6001);
     status = emulator.Opcode5(opcode);
     CLOVE_INT_EQ(emulator.GetPC(), PC + 2);
@@ -280,8 +281,14 @@ CLOVE_TEST(Opcode8_SUBN_Vx_Vy)
     status = emulator.Opcode8(opcode);
 
     CLOVE_INT_EQ(emulator.GetRegisters()[0xF], 1);
-    CLOVE_INT_EQ(emulator.GetRegisters()[registerY_index], result);
+    CLOVE_INT_EQ(emulator.GetRegisters()[registerX_index], result);
+    CLOVE_INT_EQ(emulator.GetRegisters()[registerY_index], y);
     CLOVE_INT_EQ(static_cast<int>(chipotto::OpcodeStatus::IncrementPC), static_cast<int>(status));
+
+    // With VF as VX the flag wins over the difference.
+    emulator.Opcode6(0x6F01);
+    emulator.Opcode8(0x8F27);
+    CLOVE_INT_EQ(emulator.GetRegisters()[0xF], 1);
 }
 
 CLOVE_TEST(Opcode8_SHL_Vx_Vy)
@@ -314,7 +321,7 @@ CLOVE_TEST(Opcode9_SNE_Vx_Vy)
     CLOVE_INT_EQ(static_cast<int>(chipotto::OpcodeStatus::IncrementPC), static_cast<int>(status));
 }
 
-CLOVE_TEST(OpcodeA_LD_I, addr)
+CLOVE_TEST(OpcodeA_LD_I_addr)
 {
     chipotto::Emulator emulator;
     chipotto::OpcodeStatus status;
@@ -345,11 +352,37 @@ CLOVE_TEST(OpcodeC_RND_Vx_byte)
     const uint16_t opcode = 0xC000;
     uint8_t register_index = (opcode >> 8) & 0xF;
     uint8_t random_mask = opcode & 0xFF;
+    chipotto::Random expected;
     status = emulator.OpcodeC(0xC000);
-    CLOVE_INT_EQ(emulator.GetRegisters()[register_index], (std::rand() % 256) & random_mask);
+    CLOVE_INT_EQ(emulator.GetRegisters()[register_index], expected.NextByte() & random_mask);
     CLOVE_INT_EQ(static_cast<int>(chipotto::OpcodeStatus::IncrementPC), static_cast<int>(status));
 }
 
+CLOVE_TEST(OpcodeC_RND_ReproducibleFromSeed)
+{
+    chipotto::Emulator first;
+    chipotto::Emulator second;
+    first.SetSeed(1234);
+    second.SetSeed(1234);
+    for (int i = 0; i < 16; ++i)
+    {
+        first.OpcodeC(0xC1FF);
+        second.OpcodeC(0xC1FF);
+        CLOVE_INT_EQ(first.GetRegisters()[1], second.GetRegisters()[1]);
+    }
+
+    // A different seed gives a different sequence.
+    second.SetSeed(1235);
+    int differences = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        first.OpcodeC(0xC1FF);
+        second.OpcodeC(0xC1FF);
+        if (first.GetRegisters()[1] != second.GetRegisters()[1]) differences++;
+    }
+    CLOVE_IS_TRUE(differences > 8);
+}
+
 CLOVE_TEST(OpcodeD_DRW_Vx_Vy_nibble)
 {
     chipotto::Emulator emulator;
@@ -359,6 +392,19 @@ CLOVE_TEST(OpcodeD_DRW_Vx_Vy_nibble)
     CLOVE_INT_EQ(static_cast<int>(chipotto::OpcodeStatus::IncrementPC), static_cast<int>(status));
 }
 
+CLOVE_TEST(OpcodeD_DRW_Collision)
+{
+    chipotto::Emulator emulator;
+
+    emulator.OpcodeA(0xA000);
+    emulator.OpcodeD(0xD001);
+    CLOVE_INT_EQ(emulator.GetRegisters()[0xF], 0);
+    CLOVE_ULLONG_EQ(0xF000000000000000ULL, emulator.GetFramebuffer().Rows[0][0]);
+    emulator.OpcodeD(0xD001);
+    CLOVE_INT_EQ(emulator.GetRegisters()[0xF], 1);
+    CLOVE_ULLONG_EQ(0ULL, emulator.GetFramebuffer().Rows[0][0]);
+}
+
 CLOVE_TEST(OpcodeE_SKP_Vx)
 {
     chipotto::Emulator emulator;
@@ -408,7 +454,6 @@ CLOVE_TEST(OpcodeF_LD_DT_Vx)
     uint8_t register_index = (0x15 >> 8) & 0xF;
     status = emulator.OpcodeF(0x15);
     CLOVE_INT_EQ(emulator.GetDelayTimer(), emulator.GetRegisters()[register_index]);
-    CLOVE_INT_EQ(emulator.GetDeltaTimerTicks(), 17 + SDL_GetTicks64());
     CLOVE_INT_EQ(static_cast<int>(chipotto::OpcodeStatus::IncrementPC), static_cast<int>(status));
 }
 
@@ -490,4 +535,36 @@ CLOVE_TEST(OpcodeF_LD_Vx_I)
         CLOVE_INT_EQ(emulator.GetRegisters()[i], emulator.GetMemoryMapping()[emulator.GetI() + i]);
     }
     CLOVE_INT_EQ(static_cast<int>(chipotto::OpcodeStatus::IncrementPC), static_cast<int>(status));
+}
+
+CLOVE_TEST(TickTimers)
+{
+    chipotto::Emulator emulator;
+
+    emulator.Opcode6(0x6002);
+    emulator.OpcodeF(0x0015);
+    emulator.OpcodeF(0x0018);
+    emulator.TickTimers();
+    CLOVE_INT_EQ(emulator.GetDelayTimer(), 1);
+    CLOVE_INT_EQ(emulator.GetSoundTimer(), 1);
+    emulator.TickTimers();
+    emulator.TickTimers();
+    CLOVE_INT_EQ(emulator.GetDelayTimer(), 0);
+    CLOVE_INT_EQ(emulator.GetSoundTimer(), 0);
+}
+
+CLOVE_TEST(KeyDown_ResumesWaitForKeyboard)
+{
+    chipotto::Emulator emulator;
+
+    const uint16_t PC = emulator.GetPC();
+    emulator.OpcodeF(0x030A);
+    CLOVE_IS_TRUE(emulator.GetSuspended());
+    emulator.KeyDown(0xB);
+    CLOVE_IS_FALSE(emulator.GetSuspended());
+    CLOVE_INT_EQ(emulator.GetRegisters()[3], 0xB);
+    CLOVE_INT_EQ(emulator.GetPC(), PC + 2);
+    CLOVE_INT_EQ(emulator.GetKeys(), 1 << 0xB);
+    emulator.KeyUp(0xB);
+    CLOVE_INT_EQ(emulator.GetKeys(), 0);
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#define CLOVE_SUITE_NAME DebuggerTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "debugger.h"
+#include "differential.h"
+#include <array>
+#include <vector>
+
+CLOVE_TEST(Debugger_StopsAtBreakpointsInsideBlocks)
+{
+    // LD V0, 1 / LD V1, 2 / LD V2, 3 / ADD V0, 1 / JP 0x206
+    const std::array<uint8_t, 10> program = { 0x60, 0x01, 0x61, 0x02, 0x62, 0x03, 0x70, 0x01, 0x12, 0x06 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    chipotto::Debugger debugger;
+    debugger.SetBreakpoint(0x204);
+    debugger.SetBreakpoint(0x206);
+    CLOVE_IS_TRUE(debugger.HasBreakpoint(0x206));
+
+    chipotto::DebugStop stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::Breakpoint);
+    CLOVE_INT_EQ(2, static_cast<int>(stop.Executed));
+    CLOVE_INT_EQ(0x204, emulator.GetPC());
+
+    // Running again passes over the breakpoint it stopped at.
+    stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::Breakpoint);
+    CLOVE_INT_EQ(1, static_cast<int>(stop.Executed));
+    CLOVE_INT_EQ(0x206, emulator.GetPC());
+    stop = debugger.Run(emulator, 100);
+    CLOVE_INT_EQ(2, static_cast<int>(stop.Executed));
+    CLOVE_INT_EQ(0x206, emulator.GetPC());
+    CLOVE_INT_EQ(2, emulator.GetRegisters()[0]);
+
+    debugger.ClearBreakpoint(0x206);
+    stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::None);
+    CLOVE_INT_EQ(100, static_cast<int>(stop.Executed));
+}
+
+CLOVE_TEST(Debugger_WatchpointsStopAfterAccess)
+{
+    // LD I, 0x300 / LD V0, 0x7B / LD B, V0 / LD V2, [I] / DRW V0, V0, 2 / JP 0x20A
+    const std::array<uint8_t, 12> program = { 0xA3, 0x00, 0x60, 0x7B, 0xF0, 0x33, 0xF2, 0x65, 0xD0, 0x02, 0x12, 0x0A };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    chipotto::Debugger debugger;
+    debugger.AddWatchpoint(0x301, 1, chipotto::MemoryAccess::Write);
+    debugger.AddWatchpoint(0x302, 1, chipotto::MemoryAccess::Read);
+
+    chipotto::DebugStop stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::Watchpoint);
+    CLOVE_IS_TRUE(stop.Access == chipotto::MemoryAccess::Write);
+    CLOVE_INT_EQ(0x301, static_cast<int>(stop.Address));
+    CLOVE_INT_EQ(3, static_cast<int>(stop.Executed));
+    CLOVE_INT_EQ(0x206, emulator.GetPC());
+
+    // Fx65 reads 0x300-0x302, so only the read watchpoint fires.
+    stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::Watchpoint);
+    CLOVE_IS_TRUE(stop.Access == chipotto::MemoryAccess::Read);
+    CLOVE_INT_EQ(0x302, static_cast<int>(stop.Address));
+    CLOVE_INT_EQ(0x208, emulator.GetPC());
+    CLOVE_INT_EQ(3, emulator.GetRegisters()[2]);
+
+    // The two-row sprite at 0x300 doesn't reach 0x302.
+    stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::None);
+
+    debugger.ClearWatchpoints();
+    debugger.AddWatchpoint(0x300, 2, chipotto::MemoryAccess::ReadWrite);
+    emulator.LoadFromMemory(program);
+    emulator.GetCpuState().PC = 0x208;
+    stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::Watchpoint);
+    CLOVE_INT_EQ(0x300, static_cast<int>(stop.Address));
+    CLOVE_INT_EQ(0x20A, emulator.GetPC());
+}
+
+CLOVE_TEST(Debugger_RegisterConditions)
+{
+    // LD V1, 9 / ADD V0, 1 / JP 0x202
+    const std::array<uint8_t, 6> program = { 0x61, 0x09, 0x70, 0x01, 0x12, 0x02 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    chipotto::Debugger debugger;
+    debugger.BreakOnRegisterChange(1);
+    debugger.BreakOnRegisterValue(0, 5);
+
+    chipotto::DebugStop stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::RegisterCondition);
+    CLOVE_INT_EQ(1, stop.Register);
+    CLOVE_INT_EQ(9, stop.Value);
+
+    stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::RegisterCondition);
+    CLOVE_INT_EQ(0, stop.Register);
+    CLOVE_INT_EQ(5, stop.Value);
+    CLOVE_INT_EQ(9, static_cast<int>(stop.Executed));
+
+    debugger.ClearRegisterConditions();
+    stop = debugger.Run(emulator, 100);
+    CLOVE_IS_TRUE(stop.Reason == chipotto::StopReason::None);
+}
+
+CLOVE_TEST(Debugger_BlockExecutionMatchesInterpreter)
+{
+    // Random programs jump around and rewrite themselves; with breakpoints set where they are
+    // never reached, block-at-a-time execution must end in the same state as plain ticks.
+    for (uint64_t seed = 1; seed <= 200; ++seed)
+    {
+        const std::vector<uint8_t> program = chipotto::GenerateRandomProgram(seed, 64, chipotto::QuirkProfile::Chipotto);
+        chipotto::Emulator expected;
+        chipotto::Emulator actual;
+        expected.LoadFromMemory(program);
+        actual.LoadFromMemory(program);
+        chipotto::Debugger debugger;
+        debugger.SetBreakpoint(0xFFF0);
+
+        uint32_t executed = 0;
+        bool running = true;
+        while (running && executed < 2000 && !expected.GetSuspended())
+        {
+            executed++;
+            running = expected.Tick();
+        }
+        const chipotto::DebugStop stop = debugger.Run(actual, 2000);
+        CLOVE_INT_EQ(static_cast<int>(executed), static_cast<int>(stop.Executed));
+        CLOVE_IS_TRUE(running == (stop.Reason != chipotto::StopReason::Halted));
+        CLOVE_ULLONG_EQ(expected.GetStateChecksum(), actual.GetStateChecksum());
+    }
+}
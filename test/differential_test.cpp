@@ -0,0 +1,90 @@
+#define CLOVE_SUITE_NAME DifferentialTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "differential.h"
+#include <array>
+#include <string>
+#include <vector>
+
+static bool RunInterpreter(chipotto::Emulator& emulator, const uint32_t instructions)
+{
+    return emulator.RunFrame(instructions);
+}
+
+// The interpreter with a planted bug: 8xy4 flips VF after setting it.
+static bool RunBrokenAdd(chipotto::Emulator& emulator, const uint32_t instructions)
+{
+    for (uint32_t i = 0; i < instructions; ++i)
+    {
+        const uint16_t pc = emulator.GetPC();
+        const uint16_t opcode = (emulator.GetMemoryMapping()[pc] << 8) | emulator.GetMemoryMapping()[pc + 1];
+        if (!emulator.Tick()) return false;
+        if ((opcode & 0xF00F) == 0x8004) emulator.GetCpuState().Registers[0xF] ^= 1;
+        if (emulator.GetSuspended()) break;
+    }
+    emulator.TickTimers();
+    return true;
+}
+
+CLOVE_TEST(Differential_InterpreterMatchesItself)
+{
+    const chipotto::DifferentialEngine engine{ "interpreter", RunInterpreter };
+    for (const chipotto::QuirkProfile quirks : { chipotto::QuirkProfile::CosmacVip, chipotto::QuirkProfile::XoChip, chipotto::QuirkProfile::MegaChip })
+    {
+        chipotto::DifferentialOptions options;
+        options.Quirks = quirks;
+        options.Steps = 200;
+        options.ThreadCount = 4;
+        const chipotto::DifferentialReport report = chipotto::RunDifferentialTests(engine, 100, options);
+        CLOVE_ULLONG_EQ(100, report.Programs);
+        CLOVE_IS_TRUE(report.Steps > 100);
+        CLOVE_INT_EQ(0, static_cast<int>(report.Failures.size()));
+    }
+}
+
+CLOVE_TEST(Differential_ShrinksFailureToOneInstruction)
+{
+    const chipotto::DifferentialEngine engine{ "broken add", RunBrokenAdd };
+    chipotto::DifferentialOptions options;
+    options.Steps = 200;
+    options.ThreadCount = 4;
+    options.MaxFailures = 3;
+    const chipotto::DifferentialReport report = chipotto::RunDifferentialTests(engine, 1000, options);
+    CLOVE_INT_EQ(3, static_cast<int>(report.Failures.size()));
+    for (const chipotto::DifferentialFailure& failure : report.Failures)
+    {
+        CLOVE_INT_EQ(2, static_cast<int>(failure.Program.size()));
+        CLOVE_INT_EQ(0x8004, ((failure.Program[0] << 8) | failure.Program[1]) & 0xF00F);
+        CLOVE_INT_EQ(0, static_cast<int>(failure.Step));
+        CLOVE_IS_TRUE(failure.Difference.starts_with("VF: "));
+        CLOVE_IS_TRUE(failure.OriginalSize > failure.Program.size());
+    }
+    CLOVE_IS_TRUE(report.Failures[0].Index < report.Failures[1].Index);
+
+    // The same failure, rebuilt from the reported seed.
+    const std::vector<uint8_t> program = chipotto::GenerateRandomProgram(report.Failures[0].Seed, options.ProgramInstructions, options.Quirks);
+    chipotto::DifferentialFailure again;
+    CLOVE_IS_FALSE(chipotto::CheckProgram(engine, program, options, report.Failures[0].Seed, again));
+    CLOVE_IS_TRUE(report.Failures[0].Program == again.Program);
+}
+
+CLOVE_TEST(Differential_ChecksRomsAtBlockGranularity)
+{
+    // LD V0, 0x80 / LD V1, 0x90 / LD V2, 3 / ADD V0, V1 / JP 0x208
+    const std::vector<uint8_t> rom = { 0x60, 0x80, 0x61, 0x90, 0x62, 0x03, 0x80, 0x14, 0x12, 0x08 };
+    const std::vector<std::vector<uint8_t>> roms = { { 0x12, 0x00 }, rom };
+    const chipotto::DifferentialEngine engine{ "broken add", RunBrokenAdd };
+    chipotto::DifferentialOptions options;
+    options.Steps = 50;
+    options.InstructionsPerStep = 3;
+    options.Shrink = false;
+    const chipotto::DifferentialReport report = chipotto::RunDifferentialTests(engine, roms, options);
+    CLOVE_ULLONG_EQ(2, report.Programs);
+    CLOVE_INT_EQ(1, static_cast<int>(report.Failures.size()));
+    const chipotto::DifferentialFailure& failure = report.Failures[0];
+    CLOVE_ULLONG_EQ(1, failure.Index);
+    // The ADD is the fourth instruction, in the second step of three.
+    CLOVE_INT_EQ(1, static_cast<int>(failure.Step));
+    CLOVE_STRING_EQ("VF: 0x01 != 0x00", failure.Difference.c_str());
+    CLOVE_IS_TRUE(rom == failure.Program);
+}
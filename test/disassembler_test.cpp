@@ -0,0 +1,111 @@
+#define CLOVE_SUITE_NAME DisassemblerTestSuite
+#include "clove-unit.h"
+#include "disassembler.h"
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+
+static std::string DisassembleText(const uint16_t opcode, const uint16_t operand = 0, const chipotto::QuirkProfile quirks = chipotto::QuirkProfile::XoChip)
+{
+    char text[chipotto::MaxDisassemblyLength];
+    const size_t length = chipotto::Disassemble(opcode, operand, quirks, text);
+    return std::string(text, length);
+}
+
+CLOVE_TEST(Disassemble_FormatsEveryHandler)
+{
+    CLOVE_STRING_EQ("CLS", DisassembleText(0x00E0).c_str());
+    CLOVE_STRING_EQ("SCD 4", DisassembleText(0x00C4).c_str());
+    CLOVE_STRING_EQ("JP 0x2A0", DisassembleText(0x12A0).c_str());
+    CLOVE_STRING_EQ("CALL 0x30C", DisassembleText(0x230C).c_str());
+    CLOVE_STRING_EQ("SE VA, 0x07", DisassembleText(0x3A07).c_str());
+    CLOVE_STRING_EQ("SAVE V1 - V4", DisassembleText(0x5142).c_str());
+    CLOVE_STRING_EQ("ADD V3, 0xFF", DisassembleText(0x73FF).c_str());
+    CLOVE_STRING_EQ("SUBN V1, V2", DisassembleText(0x8127).c_str());
+    CLOVE_STRING_EQ("SHL V1{, V2}", DisassembleText(0x812E).c_str());
+    CLOVE_STRING_EQ("LD I, 0x22A", DisassembleText(0xA22A).c_str());
+    CLOVE_STRING_EQ("JP V0, 0x300", DisassembleText(0xB300).c_str());
+    CLOVE_STRING_EQ("DRW V0, V1, F", DisassembleText(0xD01F).c_str());
+    CLOVE_STRING_EQ("SKNP V5", DisassembleText(0xE5A1).c_str());
+    CLOVE_STRING_EQ("LD V2, [I]", DisassembleText(0xF265).c_str());
+    CLOVE_STRING_EQ("LD I, long 0xABCD", DisassembleText(0xF000, 0xABCD).c_str());
+    CLOVE_STRING_EQ("LDHI I, 0x12ABCD", DisassembleText(0x0112, 0xABCD, chipotto::QuirkProfile::MegaChip).c_str());
+    CLOVE_STRING_EQ("BMODE 4", DisassembleText(0x0804, 0, chipotto::QuirkProfile::MegaChip).c_str());
+}
+
+CLOVE_TEST(Disassemble_UnknownOpcodesAreData)
+{
+    CLOVE_STRING_EQ("DW 0x5128", DisassembleText(0x5128).c_str());
+    CLOVE_STRING_EQ("DW 0x80AF", DisassembleText(0x80AF).c_str());
+    CLOVE_STRING_EQ("DW 0xFFFF", DisassembleText(0xFFFF).c_str());
+    CLOVE_STRING_EQ("DW 0x0000", DisassembleText(0x0000).c_str());
+
+    // MEGA-CHIP forms only run under the MEGA-CHIP profile.
+    CLOVE_STRING_EQ("DW 0x0112", DisassembleText(0x0112, 0xABCD).c_str());
+    CLOVE_STRING_EQ("DW 0x0804", DisassembleText(0x0804, 0, chipotto::QuirkProfile::SuperChip).c_str());
+}
+
+CLOVE_TEST(DisassembleListing_StreamsThroughSmallBuffer)
+{
+    // LD I, 0x22A / F000 1234 / JP 0x200 / odd trailing byte
+    const std::array<uint8_t, 9> code = { 0xA2, 0x2A, 0xF0, 0x00, 0x12, 0x34, 0x12, 0x00, 0xFF };
+    const std::string expected =
+        "0200: A22A       LD I, 0x22A\n"
+        "0202: F000 1234  LD I, long 0x1234\n"
+        "0206: 1200       JP 0x200\n"
+        "0208: FF         DB 0xFF\n";
+
+    // Room for one line at a time, fed three bytes at a time so chunks end inside instructions.
+    std::array<char, chipotto::MaxListingLineLength> buffer;
+    std::string listing;
+    std::vector<uint8_t> pending;
+    size_t read = 0;
+    uint32_t address = 0x200;
+    while (read < code.size() || !pending.empty())
+    {
+        const size_t chunk = std::min<size_t>(3, code.size() - read);
+        pending.insert(pending.end(), code.begin() + read, code.begin() + read + chunk);
+        read += chunk;
+        const bool final = read == code.size();
+        size_t consumed = 0;
+        const size_t written = chipotto::DisassembleListing(pending, address, chipotto::QuirkProfile::XoChip, buffer, consumed, final);
+        listing.append(buffer.data(), written);
+        pending.erase(pending.begin(), pending.begin() + consumed);
+        address += static_cast<uint32_t>(consumed);
+    }
+    CLOVE_STRING_EQ(expected.c_str(), listing.c_str());
+
+    // Everything at once when the buffer is large enough.
+    std::array<char, 4 * chipotto::MaxListingLineLength> large;
+    size_t consumed = 0;
+    const size_t written = chipotto::DisassembleListing(code, 0x200, chipotto::QuirkProfile::XoChip, large, consumed);
+    CLOVE_INT_EQ(static_cast<int>(code.size()), static_cast<int>(consumed));
+    CLOVE_STRING_EQ(expected.c_str(), std::string(large.data(), written).c_str());
+}
+
+CLOVE_TEST(DisassembleListing_LeavesCutOffInstructionsForTheNextChunk)
+{
+    // LD I, 0x22A / the first half of F000 1234
+    const std::array<uint8_t, 5> code = { 0xA2, 0x2A, 0xF0, 0x00, 0x12 };
+    std::array<char, 4 * chipotto::MaxListingLineLength> buffer;
+    size_t consumed = 0;
+    size_t written = chipotto::DisassembleListing(code, 0x200, chipotto::QuirkProfile::XoChip, buffer, consumed, false);
+    CLOVE_INT_EQ(2, static_cast<int>(consumed));
+    CLOVE_STRING_EQ("0200: A22A       LD I, 0x22A\n", std::string(buffer.data(), written).c_str());
+
+    // An odd byte waits too.
+    written = chipotto::DisassembleListing(std::span<const uint8_t>(code).first(3), 0x200, chipotto::QuirkProfile::XoChip, buffer, consumed, false);
+    CLOVE_INT_EQ(2, static_cast<int>(consumed));
+
+    // At the end of the ROM both are listed as data.
+    written = chipotto::DisassembleListing(std::span<const uint8_t>(code).subspan(2), 0x202, chipotto::QuirkProfile::XoChip, buffer, consumed);
+    CLOVE_INT_EQ(3, static_cast<int>(consumed));
+    CLOVE_STRING_EQ("0202: F000       DW 0xF000\n0204: 12         DB 0x12\n", std::string(buffer.data(), written).c_str());
+
+    // Outside MEGA-CHIP, 01nn is two bytes of data rather than a cut-off LDHI.
+    const std::array<uint8_t, 2> ldhi = { 0x01, 0x12 };
+    written = chipotto::DisassembleListing(ldhi, 0x200, chipotto::QuirkProfile::XoChip, buffer, consumed, false);
+    CLOVE_INT_EQ(2, static_cast<int>(consumed));
+    CLOVE_STRING_EQ("0200: 0112       DW 0x0112\n", std::string(buffer.data(), written).c_str());
+}
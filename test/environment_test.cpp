@@ -0,0 +1,122 @@
+#define CLOVE_SUITE_NAME EnvironmentTestSuite
+#include "clove-unit.h"
+#include "environment.h"
+#include <array>
+#include <vector>
+
+// Draws the font '0' at (5, 5), then counts V0 up at 0x300 while key 5 is held and exits
+// when it reaches 5.
+static const std::array<uint8_t, 18> ScoringProgram =
+{
+    0x65, 0x05, 0xD5, 0x55, 0xE5, 0xA1, 0x70, 0x01, 0xA3, 0x00,
+    0xF0, 0x55, 0x30, 0x05, 0x12, 0x04, 0x00, 0xFD
+};
+
+static chipotto::EnvironmentConfig ScoringConfig()
+{
+    chipotto::EnvironmentConfig config;
+    config.InstructionsPerFrame = 6;
+    config.FramesPerStep = 1;
+    config.MaxNoopFrames = 0;
+    config.Rewards.push_back({ 0x300, chipotto::RewardEncoding::Byte, 0.5f });
+    return config;
+}
+
+CLOVE_TEST(Environment_StepRewardsAndDones)
+{
+    chipotto::BatchedEnvironment environment(chipotto::MemoryImage::Create(ScoringProgram), ScoringConfig(), 2);
+    CLOVE_INT_EQ(256, static_cast<int>(environment.GetObservationSize()));
+
+    std::vector<uint8_t> observations(environment.GetObservationSize() * 2);
+    environment.Reset(1, observations.data());
+    CLOVE_INT_EQ(0, observations[5 * 8]);
+
+    const std::array<uint16_t, 2> actions = { 1 << 5, 0 };
+    std::array<float, 2> rewards{};
+    std::array<uint8_t, 2> dones{};
+    float total = 0.0f;
+    int steps = 0;
+    while (!dones[0] && steps < 100)
+    {
+        environment.Step(actions.data(), observations.data(), rewards.data(), dones.data());
+        CLOVE_INT_EQ(0x07, observations[5 * 8]);
+        CLOVE_INT_EQ(0x80, observations[5 * 8 + 1]);
+        total += rewards[0];
+        CLOVE_IS_TRUE(rewards[1] == 0.0f);
+        CLOVE_INT_EQ(0, dones[1]);
+        steps++;
+    }
+    CLOVE_INT_EQ(1, dones[0]);
+    CLOVE_IS_TRUE(total == 2.5f);
+    CLOVE_INT_EQ(0x07, observations[256 + 5 * 8]);
+
+    // The finished instance starts over on its next step.
+    environment.Step(actions.data(), observations.data(), rewards.data(), dones.data());
+    CLOVE_INT_EQ(0, dones[0]);
+    CLOVE_IS_TRUE(rewards[0] > 0.0f);
+}
+
+CLOVE_TEST(Environment_StepPressesPastKeyWait)
+{
+    // 0x200: LD V0, K / LD I, 0x300 / LD [I], V0 / JP 0x206: scores the key pressed at the prompt.
+    const std::array<uint8_t, 8> program = { 0xF0, 0x0A, 0xA3, 0x00, 0xF0, 0x55, 0x12, 0x06 };
+    chipotto::EnvironmentConfig config = ScoringConfig();
+    config.Rewards[0].Scale = 1.0f;
+    chipotto::BatchedEnvironment environment(chipotto::MemoryImage::Create(program), config, 1);
+    std::vector<uint8_t> observations(environment.GetObservationSize());
+    environment.Reset(0, observations.data());
+
+    uint16_t action = 0;
+    float reward = 0.0f;
+    uint8_t done = 0;
+    environment.Step(&action, observations.data(), &reward, &done);
+    CLOVE_IS_TRUE(reward == 0.0f);
+    action = 1 << 7;
+    environment.Step(&action, observations.data(), &reward, &done);
+    CLOVE_IS_TRUE(reward == 7.0f);
+    CLOVE_INT_EQ(0, done);
+}
+
+CLOVE_TEST(Environment_DownsampledObservation)
+{
+    chipotto::EnvironmentConfig config = ScoringConfig();
+    config.Observation = chipotto::ObservationFormat::Downsampled;
+    config.Downsample = 2;
+    chipotto::BatchedEnvironment environment(chipotto::MemoryImage::Create(ScoringProgram), config, 1);
+    CLOVE_INT_EQ(32, environment.GetObservationWidth());
+    CLOVE_INT_EQ(16, environment.GetObservationHeight());
+
+    std::vector<uint8_t> observations(environment.GetObservationSize());
+    environment.Reset(0, observations.data());
+    const uint16_t action = 0;
+    float reward;
+    uint8_t done;
+    environment.Step(&action, observations.data(), &reward, &done);
+    CLOVE_INT_EQ(63, observations[2 * 32 + 2]);
+    CLOVE_INT_EQ(127, observations[3 * 32 + 2]);
+    CLOVE_INT_EQ(0, observations[0]);
+}
+
+CLOVE_TEST(Environment_SeedsNoopStarts)
+{
+    chipotto::EnvironmentConfig config = ScoringConfig();
+    config.MaxNoopFrames = 30;
+    config.MaxEpisodeFrames = 3;
+    chipotto::BatchedEnvironment first(chipotto::MemoryImage::Create(ScoringProgram), config, 4);
+    chipotto::BatchedEnvironment second(chipotto::MemoryImage::Create(ScoringProgram), config, 4);
+
+    std::vector<uint8_t> observations(first.GetObservationSize() * 4);
+    first.Reset(42, observations.data());
+    second.Reset(42, observations.data());
+    const std::array<uint16_t, 4> actions = { 0, 0, 0, 0 };
+    std::array<float, 4> rewards{};
+    std::array<uint8_t, 4> first_dones{};
+    std::array<uint8_t, 4> second_dones{};
+    for (int step = 0; step < 3; ++step)
+    {
+        first.Step(actions.data(), observations.data(), rewards.data(), first_dones.data());
+        second.Step(actions.data(), observations.data(), rewards.data(), second_dones.data());
+    }
+    CLOVE_IS_TRUE(first_dones == second_dones);
+    CLOVE_INT_EQ(1, first_dones[0]);
+}
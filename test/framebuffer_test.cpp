@@ -0,0 +1,102 @@
+#define CLOVE_SUITE_NAME FramebufferTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include <array>
+
+CLOVE_TEST(Opcode0_HIGH_LOW)
+{
+    chipotto::Emulator emulator;
+
+    CLOVE_INT_EQ(64, emulator.GetWidth());
+    CLOVE_INT_EQ(32, emulator.GetHeight());
+    emulator.Opcode0(0x00FF);
+    CLOVE_INT_EQ(128, emulator.GetWidth());
+    CLOVE_INT_EQ(64, emulator.GetHeight());
+    emulator.Opcode0(0x00FE);
+    CLOVE_INT_EQ(64, emulator.GetWidth());
+}
+
+CLOVE_TEST(OpcodeD_LargeSpriteCrossesWordBoundary)
+{
+    const std::array<uint8_t, 32> sprite = { 0xFF, 0xFF, 0x80, 0x01 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(sprite);
+    emulator.Opcode0(0x00FF);
+    emulator.Opcode6(0x603C);
+    emulator.OpcodeA(0xA200);
+    emulator.OpcodeD(0xD010);
+
+    const chipotto::Framebuffer& framebuffer = emulator.GetFramebuffer();
+    CLOVE_ULLONG_EQ(0xFULL, framebuffer.Rows[0][0]);
+    CLOVE_ULLONG_EQ(0xFFF0000000000000ULL, framebuffer.Rows[0][1]);
+    CLOVE_IS_TRUE(framebuffer.GetPixel(60, 1));
+    CLOVE_IS_TRUE(framebuffer.GetPixel(75, 1));
+    CLOVE_IS_FALSE(framebuffer.GetPixel(61, 1));
+    CLOVE_INT_EQ(0, emulator.GetRegisters()[0xF]);
+}
+
+CLOVE_TEST(Opcode0_Scroll)
+{
+    chipotto::Emulator emulator;
+    emulator.Opcode0(0x00FF);
+    emulator.OpcodeA(0xA000);
+    emulator.OpcodeD(0xD001);
+
+    emulator.Opcode0(0x00C3);
+    CLOVE_ULLONG_EQ(0ULL, emulator.GetFramebuffer().Rows[0][0]);
+    CLOVE_ULLONG_EQ(0xF000000000000000ULL, emulator.GetFramebuffer().Rows[3][0]);
+
+    emulator.Opcode0(0x00FB);
+    CLOVE_ULLONG_EQ(0x0F00000000000000ULL, emulator.GetFramebuffer().Rows[3][0]);
+    for (int i = 0; i < 15; ++i) emulator.Opcode0(0x00FB);
+    CLOVE_ULLONG_EQ(0x0ULL, emulator.GetFramebuffer().Rows[3][0]);
+    CLOVE_ULLONG_EQ(0xF000000000000000ULL, emulator.GetFramebuffer().Rows[3][1]);
+
+    emulator.Opcode0(0x00FC);
+    CLOVE_ULLONG_EQ(0xFULL, emulator.GetFramebuffer().Rows[3][0]);
+    CLOVE_ULLONG_EQ(0x0ULL, emulator.GetFramebuffer().Rows[3][1]);
+}
+
+CLOVE_TEST(OpcodeF_BigFontAndFlags)
+{
+    chipotto::Emulator emulator;
+    emulator.Opcode6(0x6002);
+    emulator.Opcode6(0x6107);
+    emulator.OpcodeF(0xF030);
+    CLOVE_INT_EQ(0x50 + 20, emulator.GetI());
+    CLOVE_INT_EQ(0xFF, emulator.GetMemoryMapping()[emulator.GetI()]);
+
+    emulator.OpcodeF(0xF175);
+    emulator.Opcode6(0x6000);
+    emulator.Opcode6(0x6100);
+    emulator.OpcodeF(0xF185);
+    CLOVE_INT_EQ(2, emulator.GetRegisters()[0]);
+    CLOVE_INT_EQ(7, emulator.GetRegisters()[1]);
+}
+
+CLOVE_TEST(Opcode0_EXIT)
+{
+    const std::array<uint8_t, 2> program = { 0x00, 0xFD };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    CLOVE_IS_FALSE(emulator.Tick());
+}
+
+CLOVE_TEST(RowEquals_FindsChangedRows)
+{
+    const std::array<uint8_t, 1> sprite = { 0x80 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(sprite);
+    const chipotto::Framebuffer previous = emulator.GetFramebuffer();
+
+    emulator.OpcodeA(0xA200);
+    emulator.Opcode6(0x6105);
+    emulator.OpcodeD(0xD011);
+    const chipotto::Framebuffer& current = emulator.GetFramebuffer();
+    CLOVE_IS_TRUE(current.HasSameLayout(previous));
+    CLOVE_IS_TRUE(current.RowEquals(previous, 4));
+    CLOVE_IS_FALSE(current.RowEquals(previous, 5));
+
+    emulator.Opcode0(0x00FF);
+    CLOVE_IS_FALSE(emulator.GetFramebuffer().HasSameLayout(previous));
+}
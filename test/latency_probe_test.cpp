@@ -0,0 +1,36 @@
+#define CLOVE_SUITE_NAME LatencyProbeTestSuite
+#include "clove-unit.h"
+#include "latency_probe.h"
+#include <chrono>
+
+CLOVE_TEST(LatencyProbe_Statistics)
+{
+    using namespace std::chrono_literals;
+    chipotto::LatencyProbe probe;
+
+    CLOVE_ULLONG_EQ(0ULL, probe.GetCount());
+    CLOVE_LLONG_EQ(0LL, probe.GetPercentile(0.5).count());
+    for (int i = 1; i <= 100; ++i)
+    {
+        probe.Record(std::chrono::microseconds(i * 100 - 50));
+    }
+    CLOVE_ULLONG_EQ(100ULL, probe.GetCount());
+    CLOVE_LLONG_EQ(std::chrono::nanoseconds(50us).count(), probe.GetMin().count());
+    CLOVE_LLONG_EQ(std::chrono::nanoseconds(9950us).count(), probe.GetMax().count());
+    CLOVE_LLONG_EQ(std::chrono::nanoseconds(5000us).count(), probe.GetMean().count());
+    CLOVE_LLONG_EQ(std::chrono::nanoseconds(5000us).count(), probe.GetPercentile(0.5).count());
+    CLOVE_LLONG_EQ(std::chrono::nanoseconds(9900us).count(), probe.GetPercentile(0.99).count());
+}
+
+CLOVE_TEST(LatencyProbe_ClampsOutliers)
+{
+    using namespace std::chrono_literals;
+    chipotto::LatencyProbe probe;
+
+    probe.Record(1s);
+    probe.Record(-1ms);
+    CLOVE_LLONG_EQ(0LL, probe.GetMin().count());
+    CLOVE_LLONG_EQ(std::chrono::nanoseconds(100ms).count(), probe.GetPercentile(1.0).count());
+    probe.Reset();
+    CLOVE_ULLONG_EQ(0ULL, probe.GetCount());
+}
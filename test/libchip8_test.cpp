@@ -0,0 +1,104 @@
+#define CLOVE_SUITE_NAME LibChip8TestSuite
+#include "clove-unit.h"
+#include "chip8.h"
+#include "test_programs.h"
+#include <array>
+
+CLOVE_TEST(LibChip8_RunsFramesThroughCApi)
+{
+    chip8_t* emulator = chip8_create();
+    CLOVE_NOT_NULL(emulator);
+    CLOVE_INT_EQ(1, chip8_load_rom(emulator, CountingProgram.data(), CountingProgram.size(), 0));
+    CLOVE_INT_EQ(1, chip8_set_quirks(emulator, CHIP8_QUIRKS_SUPER_CHIP));
+    CLOVE_INT_EQ(CHIP8_QUIRKS_SUPER_CHIP, chip8_get_quirks(emulator));
+
+    // The state pointer aliases the emulator, so it sees every step without being fetched again.
+    const chip8_cpu_t* cpu = chip8_get_cpu(emulator);
+    CLOVE_INT_EQ(0x200, cpu->pc);
+    CLOVE_INT_EQ(1, chip8_run_cycles(emulator, 4));
+    CLOVE_INT_EQ(0x208, cpu->pc);
+    CLOVE_INT_EQ(1, cpu->registers[0]);
+
+    CLOVE_INT_EQ(1, chip8_run_frame(emulator, 7));
+    CLOVE_INT_EQ(2, cpu->registers[0]);
+    uint8_t value = 0;
+    chip8_read_memory(emulator, 0x300, &value, 1);
+    CLOVE_INT_EQ(1, value);
+
+    chip8_set_keys(emulator, 0x8001);
+    CLOVE_INT_EQ(0x8001, cpu->keys);
+    chip8_destroy(emulator);
+}
+
+CLOVE_TEST(LibChip8_SetKeysEndsKeyWait)
+{
+    // 0x200: LD V3, K / 0x202: JP 0x202
+    const std::array<uint8_t, 4> program = { 0xF3, 0x0A, 0x12, 0x02 };
+    chip8_t* emulator = chip8_create();
+    chip8_load_rom(emulator, program.data(), program.size(), 0);
+    const chip8_cpu_t* cpu = chip8_get_cpu(emulator);
+    CLOVE_INT_EQ(1, chip8_run_cycles(emulator, 1));
+    CLOVE_INT_EQ(1, cpu->suspended);
+
+    // Keys already held don't count as a press.
+    chip8_set_keys(emulator, 0x0000);
+    CLOVE_INT_EQ(1, cpu->suspended);
+    chip8_set_keys(emulator, 0x0020);
+    CLOVE_INT_EQ(0, cpu->suspended);
+    CLOVE_INT_EQ(5, cpu->registers[3]);
+    CLOVE_INT_EQ(0x202, cpu->pc);
+    chip8_destroy(emulator);
+}
+
+CLOVE_TEST(LibChip8_ExposesFramebuffer)
+{
+    chip8_t* emulator = chip8_create();
+    chip8_load_rom(emulator, CountingProgram.data(), CountingProgram.size(), 0);
+    chip8_run_cycles(emulator, 3);
+
+    int width = 0;
+    int height = 0;
+    chip8_get_screen_size(emulator, &width, &height);
+    CLOVE_INT_EQ(64, width);
+    CLOVE_INT_EQ(32, height);
+
+    // Digit 0 is 0xF0 0x90 0x90 0x90 0xF0, drawn at the top-left corner.
+    const uint64_t* plane = chip8_get_plane(emulator, 0);
+    CLOVE_NOT_NULL(plane);
+    CLOVE_ULLONG_EQ(0xF000000000000000ULL, plane[0]);
+    CLOVE_ULLONG_EQ(0x9000000000000000ULL, plane[2]);
+    CLOVE_NULL(chip8_get_plane(emulator, 1));
+    CLOVE_NULL(chip8_get_mega_pixels(emulator));
+    chip8_destroy(emulator);
+}
+
+CLOVE_TEST(LibChip8_SavesAndLoadsState)
+{
+    chip8_t* emulator = chip8_create();
+    chip8_load_rom(emulator, CountingProgram.data(), CountingProgram.size(), 0);
+    chip8_state_t* state = chip8_state_create();
+    CLOVE_INT_EQ(0, chip8_load_state(emulator, state));
+
+    chip8_run_frame(emulator, 7);
+    CLOVE_INT_EQ(1, chip8_save_state(emulator, state));
+    const uint64_t checksum = chip8_get_checksum(emulator);
+    chip8_run_frame(emulator, 7);
+    CLOVE_IS_TRUE(checksum != chip8_get_checksum(emulator));
+
+    CLOVE_INT_EQ(1, chip8_load_state(emulator, state));
+    CLOVE_ULLONG_EQ(checksum, chip8_get_checksum(emulator));
+    CLOVE_INT_EQ(1, chip8_get_cpu(emulator)->registers[0]);
+
+    chip8_state_destroy(state);
+    chip8_destroy(emulator);
+}
+
+CLOVE_TEST(LibChip8_RejectsInvalidArguments)
+{
+    chip8_t* emulator = chip8_create();
+    static std::array<uint8_t, 0x1000> program{};
+    CLOVE_INT_EQ(0, chip8_load_rom(emulator, program.data(), program.size(), 0x1000));
+    CLOVE_INT_EQ(0, chip8_set_quirks(emulator, static_cast<chip8_quirks>(9)));
+    CLOVE_INT_EQ(CHIP8_ABI_VERSION, chip8_get_abi_version());
+    chip8_destroy(emulator);
+}
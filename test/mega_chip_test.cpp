@@ -0,0 +1,124 @@
+#define CLOVE_SUITE_NAME MegaChipTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "mega_chip.h"
+#include <array>
+#include <vector>
+
+CLOVE_TEST(Opcode0_MEGAON_MEGAOFF)
+{
+    chipotto::Emulator emulator;
+
+    emulator.Opcode0(0x0011);
+    CLOVE_INT_EQ(256, emulator.GetWidth());
+    CLOVE_INT_EQ(192, emulator.GetHeight());
+    CLOVE_NOT_NULL(emulator.GetFramebuffer().Mega.get());
+    emulator.Opcode0(0x0010);
+    CLOVE_INT_EQ(64, emulator.GetWidth());
+    CLOVE_NULL(emulator.GetFramebuffer().Mega.get());
+}
+
+CLOVE_TEST(Opcode0_LDHI_LDPAL)
+{
+    const std::array<uint8_t, 12> program = { 0x01, 0x00, 0x02, 0x08, 0x02, 0x01, 0x00, 0x00, 0x80, 0x11, 0x22, 0x33 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program, chipotto::MemoryImage::MegaSize);
+    emulator.Opcode0(0x0011);
+    CLOVE_IS_TRUE(emulator.Tick());
+    CLOVE_INT_EQ(0x000208, emulator.GetI());
+    CLOVE_INT_EQ(0x204, emulator.GetPC());
+    CLOVE_IS_TRUE(emulator.Tick());
+    CLOVE_ULLONG_EQ(0x80332211ULL, emulator.GetFramebuffer().Mega->Palette[1]);
+}
+
+CLOVE_TEST(OpcodeD_MegaSpriteTransparencyAndCollision)
+{
+    const std::array<uint8_t, 6> sprite = { 0x01, 0x00, 0x02, 0x03, 0x00, 0x04 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(sprite);
+    emulator.Opcode0(0x0011);
+    emulator.Opcode0(0x0303);
+    emulator.Opcode0(0x0402);
+    emulator.Opcode0(0x0902);
+    emulator.OpcodeA(0xA200);
+    emulator.Opcode6(0x6002);
+    emulator.OpcodeD(0xD000);
+
+    const chipotto::MegaScreen& screen = *emulator.GetFramebuffer().Mega;
+    CLOVE_INT_EQ(1, screen.GetRow(2)[2]);
+    CLOVE_INT_EQ(0, screen.GetRow(2)[3]);
+    CLOVE_INT_EQ(2, screen.GetRow(2)[4]);
+    CLOVE_INT_EQ(4, screen.GetRow(3)[4]);
+    CLOVE_INT_EQ(0, emulator.GetRegisters()[0xF]);
+
+    // Drawing over collision colour 2 sets VF; the transparent pixel leaves it alone.
+    emulator.Opcode6(0x6102);
+    emulator.OpcodeA(0xA202);
+    emulator.Opcode0(0x0301);
+    emulator.Opcode0(0x0401);
+    emulator.Opcode6(0x6004);
+    emulator.OpcodeD(0xD010);
+    CLOVE_INT_EQ(1, emulator.GetRegisters()[0xF]);
+    CLOVE_INT_EQ(2, screen.GetRow(2)[4]);
+}
+
+CLOVE_TEST(OpcodeD_MegaSpriteClipsAtEdges)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(std::vector<uint8_t>(0x100, 0x07));
+    emulator.Opcode0(0x0011);
+    emulator.Opcode0(0x0310);
+    emulator.Opcode0(0x0410);
+    emulator.OpcodeA(0xA200);
+    emulator.Opcode6(0x60F8);
+    emulator.Opcode6(0x61B8);
+    emulator.OpcodeD(0xD010);
+
+    const chipotto::MegaScreen& screen = *emulator.GetFramebuffer().Mega;
+    CLOVE_INT_EQ(7, screen.GetRow(191)[255]);
+    CLOVE_INT_EQ(0, screen.GetRow(0)[0]);
+}
+
+CLOVE_TEST(BlitMegaRow_MatchesScalar)
+{
+    std::array<uint8_t, 77> sprite;
+    std::array<uint8_t, 77> destination;
+    for (int i = 0; i < 77; ++i)
+    {
+        sprite[i] = static_cast<uint8_t>((i % 3) ? i : 0);
+        destination[i] = static_cast<uint8_t>(i % 5 ? 9 : 0);
+    }
+    std::array<uint8_t, 77> expected = destination;
+    for (int i = 0; i < 77; ++i)
+    {
+        if (sprite[i]) expected[i] = sprite[i];
+    }
+
+    CLOVE_IS_FALSE(chipotto::BlitMegaRow(destination.data(), sprite.data(), 77, 0xAA));
+    CLOVE_IS_TRUE(destination == expected);
+    // Only an opaque sprite pixel over the collision colour counts; index 76 is the scalar tail.
+    destination[76] = 0xAA;
+    CLOVE_IS_TRUE(chipotto::BlitMegaRow(destination.data(), sprite.data(), 77, 0xAA));
+    destination[75] = 0xAA;
+    CLOVE_IS_FALSE(chipotto::BlitMegaRow(destination.data(), sprite.data(), 75, 0xAA));
+}
+
+CLOVE_TEST(ExpandMegaPalette_MatchesLookup)
+{
+    std::array<uint32_t, 0x100> palette;
+    for (int i = 0; i < 0x100; ++i)
+    {
+        palette[i] = 0xFF000000u | (i * 0x010101u);
+    }
+    std::array<uint8_t, 45> indices;
+    for (int i = 0; i < 45; ++i)
+    {
+        indices[i] = static_cast<uint8_t>(i * 7);
+    }
+    std::array<uint32_t, 45> output{};
+    chipotto::ExpandMegaPalette(indices.data(), 45, palette.data(), output.data());
+    for (int i = 0; i < 45; ++i)
+    {
+        CLOVE_ULLONG_EQ(palette[indices[i]], output[i]);
+    }
+}
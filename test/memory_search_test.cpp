@@ -0,0 +1,99 @@
+#define CLOVE_SUITE_NAME MemorySearchTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "memory_search.h"
+#include <array>
+#include <vector>
+
+// 0x200: ADD V0, 1 / ADD V1, 3 / LD I, 0x300 / LD [I], V1 / JP 0x200
+// One pass of the loop is a frame: 0x300 counts up by 1 and 0x301 by 3.
+static const std::array<uint8_t, 10> CounterProgram = {
+    0x70, 0x01, 0x71, 0x03, 0xA3, 0x00, 0xF1, 0x55, 0x12, 0x00
+};
+
+static void RunFrame(chipotto::Emulator& emulator)
+{
+    for (int i = 0; i < 5; ++i)
+    {
+        emulator.Tick();
+    }
+}
+
+CLOVE_TEST(MemorySearch_NarrowFindsCounters)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(CounterProgram);
+    chipotto::MemorySearch search;
+    search.Reset(emulator);
+    CLOVE_INT_EQ(0x1000, static_cast<int>(search.GetSize()));
+    CLOVE_INT_EQ(0x1000, static_cast<int>(search.GetCandidateCount()));
+
+    RunFrame(emulator);
+    search.Capture(emulator);
+    CLOVE_INT_EQ(2, static_cast<int>(search.Narrow(chipotto::SearchCondition::Increased)));
+    CLOVE_IS_TRUE(search.IsCandidate(0x300));
+    CLOVE_IS_TRUE(search.IsCandidate(0x301));
+
+    RunFrame(emulator);
+    search.Capture(emulator);
+    CLOVE_INT_EQ(1, static_cast<int>(search.Narrow(chipotto::SearchCondition::IncreasedBy, 3)));
+    const std::vector<uint32_t> found = search.GetCandidates();
+    CLOVE_INT_EQ(1, static_cast<int>(found.size()));
+    CLOVE_INT_EQ(0x301, static_cast<int>(found[0]));
+    CLOVE_INT_EQ(6, search.GetValue(2, 0x301));
+
+    search.ClearHistory();
+    CLOVE_INT_EQ(1, static_cast<int>(search.GetSnapshotCount()));
+    CLOVE_INT_EQ(6, search.GetValue(0, 0x301));
+}
+
+CLOVE_TEST(MemorySearch_NarrowAcrossManySnapshots)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(CounterProgram);
+    chipotto::MemorySearch search;
+    search.Reset(emulator);
+    for (int frame = 0; frame < 100; ++frame)
+    {
+        RunFrame(emulator);
+        search.Capture(emulator);
+    }
+    CLOVE_INT_EQ(101, static_cast<int>(search.GetSnapshotCount()));
+
+    // Only the two counters ever change.
+    CLOVE_INT_EQ(0x1000 - 2, static_cast<int>(search.NarrowAcross(chipotto::SearchCondition::Unchanged, 0, 0)));
+    CLOVE_IS_FALSE(search.IsCandidate(0x300));
+    CLOVE_IS_TRUE(search.IsCandidate(0x200));
+
+    // 0x301 wraps past 255 during the next 100 frames: IncreasedBy wraps with it, Increased doesn't.
+    search.Reset(emulator);
+    for (int frame = 0; frame < 100; ++frame)
+    {
+        RunFrame(emulator);
+        search.Capture(emulator);
+    }
+    CLOVE_INT_EQ(1, static_cast<int>(search.NarrowAcross(chipotto::SearchCondition::IncreasedBy, 3, 0)));
+    CLOVE_IS_TRUE(search.IsCandidate(0x301));
+    CLOVE_INT_EQ(0, static_cast<int>(search.NarrowAcross(chipotto::SearchCondition::Increased, 0, 0)));
+}
+
+CLOVE_TEST(MemorySearch_CheatTableFreezesValues)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(CounterProgram);
+    chipotto::CheatTable cheats;
+    cheats.Freeze(0x301, 0x40);
+    cheats.Freeze(0x301, 0x50);
+    CLOVE_INT_EQ(1, static_cast<int>(cheats.GetFrozen().size()));
+
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        cheats.Apply(emulator);
+        CLOVE_INT_EQ(0x50, emulator.GetMemoryMapping().Read(0x301));
+        RunFrame(emulator);
+    }
+    CLOVE_INT_EQ(10, emulator.GetMemoryMapping().Read(0x300));
+
+    cheats.Unfreeze(0x301);
+    CLOVE_IS_TRUE(cheats.GetFrozen().empty());
+}
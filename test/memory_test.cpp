@@ -0,0 +1,91 @@
+#define CLOVE_SUITE_NAME MemoryTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include <array>
+
+CLOVE_TEST(Image_HasFontAndProgram)
+{
+    const std::array<uint8_t, 2> program = { 0x12, 0x00 };
+    auto image = chipotto::MemoryImage::Create(program);
+
+    chipotto::PagedMemory memory;
+    memory.Map(image);
+    CLOVE_INT_EQ(0xF0, memory[0x0]);
+    CLOVE_INT_EQ(0x70, memory[0x9]);
+    CLOVE_INT_EQ(0x12, memory[0x200]);
+    CLOVE_INT_EQ(0x00, memory[0x201]);
+    CLOVE_INT_EQ(0, memory.GetPrivatePageCount());
+}
+
+CLOVE_TEST(Write_CopiesOnlyTouchedPage)
+{
+    const std::array<uint8_t, 2> program = { 0x12, 0x00 };
+    auto image = chipotto::MemoryImage::Create(program);
+
+    chipotto::PagedMemory first;
+    chipotto::PagedMemory second;
+    first.Map(image);
+    second.Map(image);
+
+    first.Write(0x201, 0x34);
+    CLOVE_INT_EQ(0x34, first[0x201]);
+    CLOVE_INT_EQ(0x00, second[0x201]);
+    CLOVE_INT_EQ(0x12, first[0x200]);
+    CLOVE_INT_EQ(1, first.GetPrivatePageCount());
+    CLOVE_INT_EQ(0, second.GetPrivatePageCount());
+    CLOVE_INT_EQ(0x00, image->GetPage(2)[1]);
+}
+
+CLOVE_TEST(Write_KeepsContentHash)
+{
+    const std::array<uint8_t, 2> program = { 0x12, 0x00 };
+    chipotto::PagedMemory memory;
+    memory.Map(chipotto::MemoryImage::Create(program, chipotto::MemoryImage::ExtendedSize));
+    CLOVE_ULLONG_EQ(0, memory.GetContentHash());
+
+    memory.Write(0x300, 1);
+    memory.Write(0xFFFF, 2);
+    memory.Write(0x200, 0x13);
+    const uint64_t hash = memory.GetContentHash();
+    CLOVE_IS_TRUE(hash != 0);
+    CLOVE_ULLONG_EQ(memory.ComputeContentHash(), hash);
+
+    // Writing the same value changes nothing; the hash depends on contents, not on history.
+    memory.Write(0x300, 1);
+    memory.Write(0x301, 5);
+    memory.Write(0x301, 0);
+    CLOVE_ULLONG_EQ(hash, memory.GetContentHash());
+
+    memory.Write(0x300, 0);
+    memory.Write(0xFFFF, 0);
+    memory.Write(0x200, 0x12);
+    CLOVE_ULLONG_EQ(0, memory.GetContentHash());
+    CLOVE_ULLONG_EQ(0, memory.ComputeContentHash());
+}
+
+CLOVE_TEST(Map_ReleasesPrivatePages)
+{
+    chipotto::PagedMemory memory;
+    memory.Write(0x300, 0x1);
+    memory.Write(0x400, 0x1);
+    CLOVE_INT_EQ(2, memory.GetPrivatePageCount());
+    memory.Map(chipotto::MemoryImage::Blank());
+    CLOVE_INT_EQ(0, memory.GetPrivatePageCount());
+    CLOVE_INT_EQ(0, memory[0x300]);
+}
+
+CLOVE_TEST(Emulator_SharesImage)
+{
+    const std::array<uint8_t, 4> program = { 0x60, 0x05, 0xF0, 0x33 };
+    auto image = chipotto::MemoryImage::Create(program);
+
+    chipotto::Emulator first;
+    chipotto::Emulator second;
+    first.LoadFromImage(image);
+    second.LoadFromImage(image);
+    first.OpcodeA(0xA300);
+    first.OpcodeF(0xF033);
+    CLOVE_INT_EQ(1, first.GetMemoryMapping().GetPrivatePageCount());
+    CLOVE_INT_EQ(0, second.GetMemoryMapping().GetPrivatePageCount());
+    CLOVE_IS_TRUE(sizeof(chipotto::Emulator) <= chipotto::Emulator::SizeBudget);
+}
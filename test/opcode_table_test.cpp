@@ -0,0 +1,84 @@
+#define CLOVE_SUITE_NAME OpcodeTableTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "opcode_table.h"
+#include <array>
+
+static chipotto::OpcodeStatus Execute(chipotto::Emulator& emulator, const uint16_t opcode)
+{
+    switch (opcode >> 12)
+    {
+    case 0x0: return emulator.Opcode0(opcode);
+    case 0x1: return emulator.Opcode1(opcode);
+    case 0x2: return emulator.Opcode2(opcode);
+    case 0x3: return emulator.Opcode3(opcode);
+    case 0x4: return emulator.Opcode4(opcode);
+    case 0x5: return emulator.Opcode5(opcode);
+    case 0x6: return emulator.Opcode6(opcode);
+    case 0x7: return emulator.Opcode7(opcode);
+    case 0x8: return emulator.Opcode8(opcode);
+    case 0x9: return emulator.Opcode9(opcode);
+    case 0xA: return emulator.OpcodeA(opcode);
+    case 0xB: return emulator.OpcodeB(opcode);
+    case 0xC: return emulator.OpcodeC(opcode);
+    case 0xD: return emulator.OpcodeD(opcode);
+    case 0xE: return emulator.OpcodeE(opcode);
+    default: return emulator.OpcodeF(opcode);
+    }
+}
+
+// Recreates the display in the given mode, dropping whatever the last opcode changed.
+static void SetMegaMode(chipotto::Emulator& emulator, const bool mega)
+{
+    Execute(emulator, 0x0010);
+    if (mega) Execute(emulator, 0x0011);
+}
+
+CLOVE_TEST(OpcodeTable_MatchesInterpreterForEveryOpcode)
+{
+    // 0x200: SE V0, 0x00 over the opcode under test.
+    static const std::array<uint8_t, 4> program = { 0x30, 0x00, 0x00, 0x00 };
+    for (const bool mega : { false, true })
+    {
+        chipotto::Emulator emulator;
+        emulator.LoadFromMemory(program);
+        SetMegaMode(emulator, mega);
+        const chipotto::CpuState start = emulator.GetCpuState();
+        int mismatches = 0;
+        for (uint32_t value = 0; value <= 0xFFFF; ++value)
+        {
+            const uint16_t opcode = static_cast<uint16_t>(value);
+            const chipotto::OpcodeForm* form = chipotto::FindOpcodeForm(opcode);
+            const bool valid = form && (!form->MegaOnly || mega);
+
+            // The skip steps over as many bytes as the form says.
+            emulator.GetCpuState() = start;
+            emulator.WriteMemory(0x202, static_cast<uint8_t>(opcode >> 8));
+            emulator.WriteMemory(0x203, static_cast<uint8_t>(opcode));
+            Execute(emulator, 0x3000);
+            const uint32_t length = valid ? form->Length : 2;
+            if (emulator.GetPC() != 0x200 + length) mismatches++;
+
+            emulator.GetCpuState() = start;
+            const bool implemented = Execute(emulator, opcode) != chipotto::OpcodeStatus::NotImplemented;
+            if (implemented != valid) mismatches++;
+            if ((opcode >> 12) == 0x0) SetMegaMode(emulator, mega);
+        }
+        CLOVE_INT_EQ(0, mismatches);
+    }
+}
+
+CLOVE_TEST(OpcodeTable_ValidityFollowsProfile)
+{
+    CLOVE_IS_TRUE(chipotto::IsValidOpcode(0x0804, chipotto::QuirkProfile::MegaChip));
+    CLOVE_IS_FALSE(chipotto::IsValidOpcode(0x0805, chipotto::QuirkProfile::MegaChip));
+    CLOVE_IS_FALSE(chipotto::IsValidOpcode(0x0804, chipotto::QuirkProfile::XoChip));
+    CLOVE_IS_TRUE(chipotto::IsValidOpcode(0xF000, chipotto::QuirkProfile::CosmacVip));
+    CLOVE_IS_FALSE(chipotto::IsValidOpcode(0x5121, chipotto::QuirkProfile::Chipotto));
+
+    const chipotto::OpcodeForm* form = chipotto::FindOpcodeForm(0x0112);
+    CLOVE_NOT_NULL(form);
+    CLOVE_INT_EQ(4, form->Length);
+    CLOVE_IS_TRUE(form->MegaOnly);
+    CLOVE_INT_EQ(static_cast<int>(chipotto::ControlFlow::Wait), static_cast<int>(chipotto::FindOpcodeForm(0xF30A)->Flow));
+}
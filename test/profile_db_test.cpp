@@ -0,0 +1,63 @@
+#define CLOVE_SUITE_NAME ProfileDatabaseTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "profile_db.h"
+#include "rom_hash.h"
+#include <array>
+#include <string_view>
+
+static std::span<const uint8_t> AsBytes(std::string_view text)
+{
+    return { reinterpret_cast<const uint8_t*>(text.data()), text.size() };
+}
+
+CLOVE_TEST(HashRom_MatchesXXH64)
+{
+    CLOVE_ULLONG_EQ(0xEF46DB3751D8E999ULL, chipotto::HashRom(AsBytes("")));
+    CLOVE_ULLONG_EQ(0xD24EC4F1A98C6E5BULL, chipotto::HashRom(AsBytes("a")));
+    CLOVE_ULLONG_EQ(0x44BC2CF5AD770999ULL, chipotto::HashRom(AsBytes("abc")));
+
+    std::array<uint8_t, 100> counting;
+    for (size_t i = 0; i < counting.size(); ++i) counting[i] = static_cast<uint8_t>(i);
+    CLOVE_ULLONG_EQ(0x6AC1E58032166597ULL, chipotto::HashRom(counting));
+}
+
+CLOVE_TEST(Emulator_HashesLoadedProgram)
+{
+    const std::array<uint8_t, 2> program = { 0x12, 0x00 };
+    chipotto::Emulator emulator;
+    CLOVE_IS_TRUE(emulator.LoadFromMemory(program));
+    CLOVE_ULLONG_EQ(chipotto::HashRom(program), emulator.GetProgramHash());
+}
+
+CLOVE_TEST(ProfileDatabase_RoundTrip)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "chipotto_profiles_test.txt";
+
+    chipotto::ProfileDatabase database;
+    database.Set(0x1234, { 30, chipotto::QuirkProfile::SuperChip, true, false, 2 });
+    CLOVE_IS_TRUE(database.SaveToFile(path));
+
+    chipotto::ProfileDatabase loaded;
+    CLOVE_IS_TRUE(loaded.LoadFromFile(path));
+    const chipotto::ExecutionProfile* profile = loaded.Find(0x1234);
+    CLOVE_NOT_NULL(profile);
+    CLOVE_INT_EQ(30, profile->InstructionsPerFrame);
+    CLOVE_INT_EQ(static_cast<int>(chipotto::QuirkProfile::SuperChip), static_cast<int>(profile->Quirks));
+    CLOVE_IS_TRUE(profile->IdleSkipSafe);
+    CLOVE_IS_FALSE(profile->RecompilerEligible);
+    CLOVE_INT_EQ(2, profile->RunAheadFrames);
+    CLOVE_NULL(loaded.Find(0x5678));
+    CLOVE_INT_EQ(10, loaded.Lookup(0x5678).InstructionsPerFrame);
+    std::filesystem::remove(path);
+}
+
+CLOVE_TEST(RunFrame_SkipsIdleLoop)
+{
+    const std::array<uint8_t, 4> program = { 0x70, 0x01, 0x12, 0x02 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    CLOVE_IS_TRUE(emulator.RunFrame(100, true));
+    CLOVE_INT_EQ(0x202, emulator.GetPC());
+    CLOVE_INT_EQ(1, emulator.GetRegisters()[0]);
+}
@@ -0,0 +1,83 @@
+#define CLOVE_SUITE_NAME QuirksTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include <array>
+
+CLOVE_TEST(Shift_UsesVYOnCosmacVip)
+{
+    chipotto::Emulator emulator;
+
+    emulator.Opcode6(0x6005);
+    emulator.Opcode6(0x6103);
+    emulator.Opcode8<chipotto::CosmacVipQuirks>(0x8016);
+    CLOVE_INT_EQ(1, emulator.GetRegisters()[0]);
+    CLOVE_INT_EQ(1, emulator.GetRegisters()[0xF]);
+
+    emulator.Opcode6(0x6005);
+    emulator.Opcode8<chipotto::SuperChipQuirks>(0x8016);
+    CLOVE_INT_EQ(2, emulator.GetRegisters()[0]);
+    CLOVE_INT_EQ(1, emulator.GetRegisters()[0xF]);
+}
+
+CLOVE_TEST(LoadStore_IncrementsIOnCosmacVip)
+{
+    chipotto::Emulator emulator;
+
+    emulator.OpcodeA(0xA300);
+    emulator.OpcodeF<chipotto::CosmacVipQuirks>(0xF255);
+    CLOVE_INT_EQ(0x303, emulator.GetI());
+    emulator.OpcodeA(0xA300);
+    emulator.OpcodeF<chipotto::SuperChipQuirks>(0xF255);
+    CLOVE_INT_EQ(0x300, emulator.GetI());
+}
+
+CLOVE_TEST(Jump_UsesVXOnSuperChip)
+{
+    chipotto::Emulator emulator;
+
+    emulator.Opcode6(0x6004);
+    emulator.Opcode6(0x6210);
+    emulator.OpcodeB<chipotto::SuperChipQuirks>(0xB220);
+    CLOVE_INT_EQ(0x230 - 2, emulator.GetPC());
+    emulator.OpcodeB<chipotto::CosmacVipQuirks>(0xB220);
+    CLOVE_INT_EQ(0x224 - 2, emulator.GetPC());
+}
+
+CLOVE_TEST(Sprites_WrapOnXoChip)
+{
+    chipotto::Emulator emulator;
+
+    emulator.Opcode6(0x603E);
+    emulator.OpcodeA(0xA000);
+    emulator.OpcodeD<chipotto::XoChipQuirks>(0xD011);
+    CLOVE_ULLONG_EQ(0xC000000000000003ULL, emulator.GetFramebuffer().Rows[0][0]);
+
+    chipotto::Emulator clipped;
+    clipped.Opcode6(0x603E);
+    clipped.OpcodeA(0xA000);
+    clipped.OpcodeD<chipotto::CosmacVipQuirks>(0xD011);
+    CLOVE_ULLONG_EQ(0x3ULL, clipped.GetFramebuffer().Rows[0][0]);
+}
+
+CLOVE_TEST(Logic_ResetsVFOnCosmacVip)
+{
+    chipotto::Emulator emulator;
+
+    emulator.Opcode6(0x6F01);
+    emulator.Opcode8<chipotto::CosmacVipQuirks>(0x8011);
+    CLOVE_INT_EQ(0, emulator.GetRegisters()[0xF]);
+    emulator.Opcode6(0x6F01);
+    emulator.Opcode8<chipotto::ChipottoQuirks>(0x8011);
+    CLOVE_INT_EQ(1, emulator.GetRegisters()[0xF]);
+}
+
+CLOVE_TEST(SetQuirks_SelectsInterpreter)
+{
+    const std::array<uint8_t, 6> program = { 0x60, 0x05, 0x61, 0x03, 0x80, 0x16 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    emulator.SetQuirks(chipotto::QuirkProfile::CosmacVip);
+    CLOVE_INT_EQ(static_cast<int>(chipotto::QuirkProfile::CosmacVip), static_cast<int>(emulator.GetQuirks()));
+    emulator.RunFrame(3);
+    CLOVE_INT_EQ(1, emulator.GetRegisters()[0]);
+}
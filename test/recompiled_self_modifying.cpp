@@ -0,0 +1,83 @@
+// Generated by the chipotto static recompiler. Do not edit.
+// ROM 0x497EEA4637C311FA, chipotto quirks, 3 blocks.
+#include "recompiled_program.h"
+
+namespace
+{
+	using chipotto::CpuState;
+	using chipotto::Emulator;
+	using Quirks = chipotto::ChipottoQuirks;
+
+	constexpr uint64_t ProgramHash = 0x497EEA4637C311FAULL;
+	constexpr chipotto::QuirkProfile Profile = chipotto::QuirkProfile::Chipotto;
+
+	bool Block_0200(Emulator& emu, CpuState& cpu)
+	{
+		[[maybe_unused]] auto& v = cpu.Registers;
+		// 0x0200: 0x6103  LD V1, 0x03
+		v[0x1] = 0x03;
+		// 0x0202: 0x6071  LD V0, 0x71
+		v[0x0] = 0x71;
+		// 0x0204: 0xA208  LD I, 0x208
+		cpu.I = 0x208;
+		// 0x0206: 0xF055  LD [I], V0
+		cpu.PC = 0x0206;
+		if (!chipotto::CompleteRecompiledInstruction(cpu, emu.OpcodeF<Quirks>(0xF055))) return false;
+		cpu.PC = 0x0208;
+		return true;
+	}
+
+	bool Block_0208(Emulator& emu, CpuState& cpu)
+	{
+		[[maybe_unused]] auto& v = cpu.Registers;
+		// 0x0208: 0x6105  LD V1, 0x05
+		v[0x1] = 0x05;
+		cpu.PC = 0x020A;
+		return true;
+	}
+
+	bool Block_020A(Emulator& emu, CpuState& cpu)
+	{
+		[[maybe_unused]] auto& v = cpu.Registers;
+		// 0x020A: 0x120A  JP 0x20A
+		cpu.PC = 0x020A;
+		return true;
+	}
+
+	bool RunFrame(Emulator& emu, const uint32_t instructions)
+	{
+		if (emu.GetProgramHash() != ProgramHash || emu.GetQuirks() != Profile) return emu.RunFrame(instructions);
+
+		CpuState& cpu = emu.GetCpuState();
+		const chipotto::PagedMemory& memory = emu.GetMemoryMapping();
+		uint32_t budget = instructions;
+		while (budget > 0 && !cpu.Suspended)
+		{
+			switch (cpu.PC)
+			{
+			case 0x0200:
+				if (budget < 4 || chipotto::IsRecompiledCodeModified(memory, 0x0200, 8)) break;
+				budget -= 4;
+				if (!Block_0200(emu, cpu)) return false;
+				continue;
+			case 0x0208:
+				if (budget < 1 || chipotto::IsRecompiledCodeModified(memory, 0x0208, 2)) break;
+				budget -= 1;
+				if (!Block_0208(emu, cpu)) return false;
+				continue;
+			case 0x020A:
+				if (budget < 1 || chipotto::IsRecompiledCodeModified(memory, 0x020A, 2)) break;
+				budget -= 1;
+				if (!Block_020A(emu, cpu)) return false;
+				continue;
+			}
+			// Undiscovered or overwritten code, or a block longer than what is left of the frame.
+			if (!emu.Tick()) return false;
+			budget--;
+		}
+		emu.TickTimers();
+		return true;
+	}
+}
+
+extern const chipotto::RecompiledProgram RecompiledSelfModifying = { ProgramHash, Profile, RunFrame };
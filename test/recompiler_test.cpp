@@ -0,0 +1,132 @@
+#define CLOVE_SUITE_NAME RecompilerTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "differential.h"
+#include "recompiled_program.h"
+#include "recompiler.h"
+#include "test_programs.h"
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+// 0x200: LD V1, 3 / LD V0, 0x71 / LD I, 0x208 / LD [I], V0, which turns 0x208 into ADD V1, 5 /
+// 0x208: LD V1, 5 / 0x20A: JP 0x20A
+static const std::array<uint8_t, 12> SelfModifyingProgram = { 0x61, 0x03, 0x60, 0x71, 0xA2, 0x08, 0xF0, 0x55, 0x61, 0x05, 0x12, 0x0A };
+
+// recompiled_self_modifying.cpp is RecompileRom's output for SelfModifyingProgram, compiled into
+// the tests so the generated code itself runs against the interpreter.
+extern const chipotto::RecompiledProgram RecompiledSelfModifying;
+
+CLOVE_TEST(Recompiler_SingleLoopIsOneBlock)
+{
+    auto image = chipotto::MemoryImage::Create(CountingProgram);
+    chipotto::RecompilerStats stats;
+    const std::string source = chipotto::RecompileRom(*image, chipotto::QuirkProfile::SuperChip, "Counting", &stats);
+
+    CLOVE_INT_EQ(1, stats.Blocks);
+    CLOVE_INT_EQ(CountingInstructions, stats.Instructions);
+    // Fx29, 7xnn, Annn and the jump; CLS, DRW and the store call the handlers.
+    CLOVE_INT_EQ(4, stats.Inlined);
+    CLOVE_IS_TRUE(source.find("bool Block_0200(") != std::string::npos);
+    CLOVE_IS_TRUE(source.find("case 0x0200:") != std::string::npos);
+    CLOVE_IS_TRUE(source.find("emu.OpcodeD<Quirks>(0xD005)") != std::string::npos);
+    CLOVE_IS_TRUE(source.find("using Quirks = chipotto::SuperChipQuirks;") != std::string::npos);
+    CLOVE_IS_TRUE(source.find("extern const chipotto::RecompiledProgram Counting = ") != std::string::npos);
+}
+
+CLOVE_TEST(Recompiler_SplitsBlocksAtBranches)
+{
+    // 0x200: SE V0, 1 / 0x202: CALL 0x20A / 0x204: JP 0x200 / 0x206: F000 0300 / 0x20A: RET
+    const std::array<uint8_t, 12> program = { 0x30, 0x01, 0x22, 0x0A, 0x12, 0x00, 0xF0, 0x00, 0x03, 0x00, 0x00, 0xEE };
+    auto image = chipotto::MemoryImage::Create(program);
+    chipotto::RecompilerStats stats;
+    const std::string source = chipotto::RecompileRom(*image, chipotto::QuirkProfile::XoChip, "Branches", &stats);
+
+    // 0x200, the skip's two successors 0x202 and 0x204, and the call target 0x20A. 0x206 is unreachable.
+    CLOVE_INT_EQ(4, stats.Blocks);
+    CLOVE_IS_TRUE(source.find("cpu.PC = v[0x0] == 0x01 ? 0x0204 : 0x0202;") != std::string::npos);
+    CLOVE_IS_TRUE(source.find("case 0x020A:") != std::string::npos);
+    CLOVE_IS_TRUE(source.find("case 0x0206:") == std::string::npos);
+}
+
+CLOVE_TEST(Recompiler_SkipOverLongInstructionSkipsFourBytes)
+{
+    // 0x200: SNE V0, 0 / 0x202: F000 0300 / 0x206: JP 0x206
+    const std::array<uint8_t, 8> program = { 0x40, 0x00, 0xF0, 0x00, 0x03, 0x00, 0x12, 0x06 };
+    auto image = chipotto::MemoryImage::Create(program, chipotto::MemoryImage::ExtendedSize);
+    const std::string source = chipotto::RecompileRom(*image, chipotto::QuirkProfile::XoChip, "LongSkip");
+
+    CLOVE_IS_TRUE(source.find("cpu.PC = v[0x0] != 0x00 ? 0x0206 : 0x0202;") != std::string::npos);
+}
+
+CLOVE_TEST(Recompiler_SubnWritesVx)
+{
+    // 0x200: SUBN V1, V2 / 0x202: JP 0x202
+    const std::array<uint8_t, 4> program = { 0x81, 0x27, 0x12, 0x02 };
+    auto image = chipotto::MemoryImage::Create(program);
+    const std::string source = chipotto::RecompileRom(*image, chipotto::QuirkProfile::Chipotto, "Subn");
+
+    CLOVE_IS_TRUE(source.find("v[0x1] = static_cast<uint8_t>(v[0x2] - v[0x1]); v[0xF] = flag;") != std::string::npos);
+}
+
+CLOVE_TEST(Recompiler_MakesNameAnIdentifier)
+{
+    auto image = chipotto::MemoryImage::Create(CountingProgram);
+    const std::string source = chipotto::RecompileRom(*image, chipotto::QuirkProfile::Chipotto, "15 puzzle.ch8");
+
+    CLOVE_IS_TRUE(source.find("RecompiledProgram Rom_15_puzzle_ch8 = ") != std::string::npos);
+}
+
+CLOVE_TEST(RecompiledProgram_DetectsOverwrittenCode)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(CountingProgram);
+    const chipotto::PagedMemory& memory = emulator.GetMemoryMapping();
+    CLOVE_IS_FALSE(chipotto::IsRecompiledCodeModified(memory, 0x200, 14));
+
+    // Storing V0 at 0x300 makes page 3 private without touching the code in page 2.
+    emulator.RunFrame(CountingInstructions);
+    CLOVE_IS_FALSE(chipotto::IsRecompiledCodeModified(memory, 0x200, 14));
+
+    // Point I into the program and store over the JP.
+    emulator.GetCpuState().I = 0x20C;
+    emulator.OpcodeF(0xF055);
+    CLOVE_IS_TRUE(chipotto::IsRecompiledCodeModified(memory, 0x200, 14));
+    CLOVE_IS_FALSE(chipotto::IsRecompiledCodeModified(memory, 0x200, 12));
+}
+
+CLOVE_TEST(Recompiler_SplitsBlocksAfterStoresIntoCode)
+{
+    auto image = chipotto::MemoryImage::Create(SelfModifyingProgram);
+    chipotto::RecompilerStats stats;
+    const std::string source = chipotto::RecompileRom(*image, chipotto::QuirkProfile::Chipotto, "RecompiledSelfModifying", &stats);
+
+    // The store ends the first block, so 0x208 is checked before it runs.
+    CLOVE_INT_EQ(3, stats.Blocks);
+    CLOVE_IS_TRUE(source.find("case 0x0208:") != std::string::npos);
+
+    // The compiled fixture must be what the recompiler generates today.
+    std::ifstream file(std::filesystem::path(__FILE__).replace_filename("recompiled_self_modifying.cpp"), std::ios::binary);
+    std::string fixture(std::istreambuf_iterator<char>(file), {});
+    std::erase(fixture, '\r');
+    CLOVE_IS_TRUE(fixture == source);
+}
+
+CLOVE_TEST(RecompiledProgram_MatchesInterpreter)
+{
+    const chipotto::DifferentialEngine engine{ "recompiled", RecompiledSelfModifying.RunFrame };
+    chipotto::DifferentialOptions options;
+    // Long enough steps for whole blocks to run instead of falling back to the interpreter.
+    options.InstructionsPerStep = 8;
+    options.Steps = 16;
+    options.Shrink = false;
+    chipotto::DifferentialFailure failure;
+    CLOVE_IS_TRUE(chipotto::CheckProgram(engine, SelfModifyingProgram, options, 1, failure));
+
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(SelfModifyingProgram);
+    CLOVE_IS_TRUE(RecompiledSelfModifying.RunFrame(emulator, 8));
+    CLOVE_INT_EQ(8, emulator.GetRegisters()[1]);
+}
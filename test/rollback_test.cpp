@@ -0,0 +1,122 @@
+#define CLOVE_SUITE_NAME RollbackTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "rollback.h"
+#include "udp_socket.h"
+#include <array>
+
+// Adds the index of every held key to V2 in a loop and stores V0-V2 at 0x300, so the state
+// depends on exactly which keys were down on which frame.
+static const std::array<uint8_t, 20> KeypadProgram =
+{
+    0x61, 0x00, 0xE1, 0xA1, 0x82, 0x14, 0x71, 0x01, 0x31, 0x10,
+    0x12, 0x02, 0x72, 0x03, 0xA3, 0x00, 0xF2, 0x55, 0x12, 0x00
+};
+static constexpr uint32_t KeypadInstructions = 100;
+
+static uint16_t PlayerOneKeys(const uint32_t frame) { return (frame / 7) % 3 == 0 ? 0x0002 : 0x0000; }
+static uint16_t PlayerTwoKeys(const uint32_t frame) { return (frame / 5) % 2 ? 0x0400 : 0x0010; }
+
+struct LoopbackPair
+{
+    chipotto::UdpSocket SocketOne;
+    chipotto::UdpSocket SocketTwo;
+    chipotto::Emulator EmulatorOne;
+    chipotto::Emulator EmulatorTwo;
+
+    bool Open()
+    {
+        if (!SocketOne.Open(0) || !SocketTwo.Open(0)) return false;
+        SocketOne.SetPeer("127.0.0.1", SocketTwo.GetPort());
+        SocketTwo.SetPeer("127.0.0.1", SocketOne.GetPort());
+        EmulatorOne.LoadFromMemory(KeypadProgram);
+        EmulatorTwo.LoadFromMemory(KeypadProgram);
+        return true;
+    }
+};
+
+CLOVE_TEST(UdpSocket_LoopbackRoundTrip)
+{
+    chipotto::UdpSocket one;
+    chipotto::UdpSocket two;
+    CLOVE_IS_TRUE(one.Open(0));
+    CLOVE_IS_TRUE(two.Open(0));
+    CLOVE_IS_TRUE(one.SetPeer("127.0.0.1", two.GetPort()));
+    CLOVE_IS_TRUE(two.SetPeer("127.0.0.1", one.GetPort()));
+
+    std::array<uint8_t, 8> buffer{};
+    CLOVE_INT_EQ(-1, two.Receive(buffer));
+    const std::array<uint8_t, 3> message = { 1, 2, 3 };
+    CLOVE_IS_TRUE(one.Send(message));
+    int size = -1;
+    for (int attempt = 0; attempt < 100000 && size < 0; ++attempt)
+    {
+        size = two.Receive(buffer);
+    }
+    CLOVE_INT_EQ(3, size);
+    CLOVE_INT_EQ(3, buffer[2]);
+}
+
+CLOVE_TEST(Rollback_StaysInSyncThroughMispredictions)
+{
+    LoopbackPair pair;
+    CLOVE_IS_TRUE(pair.Open());
+    chipotto::RollbackSession one(pair.EmulatorOne, pair.SocketOne, KeypadInstructions);
+    chipotto::RollbackSession two(pair.EmulatorTwo, pair.SocketTwo, KeypadInstructions);
+
+    // Let each peer run a few frames ahead of the other in turn so remote input always
+    // arrives late and predictions of key changes are wrong.
+    bool stopped = false;
+    for (int round = 0; round < 80 && !stopped; ++round)
+    {
+        chipotto::RollbackSession& leader = round % 2 ? two : one;
+        chipotto::RollbackSession& follower = round % 2 ? one : two;
+        for (int step = 0; step < 3; ++step)
+        {
+            stopped |= leader.AdvanceFrame(round % 2 ? PlayerTwoKeys(leader.GetFrame()) : PlayerOneKeys(leader.GetFrame())) == chipotto::RollbackStatus::Stopped;
+        }
+        for (int step = 0; step < 3; ++step)
+        {
+            stopped |= follower.AdvanceFrame(round % 2 ? PlayerOneKeys(follower.GetFrame()) : PlayerTwoKeys(follower.GetFrame())) == chipotto::RollbackStatus::Stopped;
+        }
+    }
+
+    CLOVE_IS_FALSE(stopped);
+    CLOVE_IS_FALSE(one.HasDesynced());
+    CLOVE_IS_FALSE(two.HasDesynced());
+    CLOVE_IS_TRUE(one.GetRollbackCount() > 0);
+    CLOVE_IS_TRUE(two.GetRollbackCount() > 0);
+    CLOVE_IS_TRUE(one.GetVerifiedFrames() > 20);
+    CLOVE_IS_TRUE(two.GetVerifiedFrames() > 20);
+}
+
+CLOVE_TEST(Rollback_DetectsDesync)
+{
+    LoopbackPair pair;
+    CLOVE_IS_TRUE(pair.Open());
+    // The COSMAC VIP quirks leave I past the stored registers, so the states diverge.
+    pair.EmulatorTwo.SetQuirks(chipotto::QuirkProfile::CosmacVip);
+    chipotto::RollbackSession one(pair.EmulatorOne, pair.SocketOne, KeypadInstructions);
+    chipotto::RollbackSession two(pair.EmulatorTwo, pair.SocketTwo, KeypadInstructions);
+
+    for (int frame = 0; frame < 60 && !one.HasDesynced(); ++frame)
+    {
+        one.AdvanceFrame(PlayerOneKeys(one.GetFrame()));
+        two.AdvanceFrame(PlayerTwoKeys(two.GetFrame()));
+    }
+    CLOVE_IS_TRUE(one.HasDesynced());
+}
+
+CLOVE_TEST(Rollback_WaitsForSilentPeer)
+{
+    LoopbackPair pair;
+    CLOVE_IS_TRUE(pair.Open());
+    chipotto::RollbackSession one(pair.EmulatorOne, pair.SocketOne, KeypadInstructions);
+
+    for (uint32_t frame = 0; frame < chipotto::RollbackSession::MaxRollback; ++frame)
+    {
+        CLOVE_INT_EQ(static_cast<int>(chipotto::RollbackStatus::Advanced), static_cast<int>(one.AdvanceFrame(0)));
+    }
+    CLOVE_INT_EQ(static_cast<int>(chipotto::RollbackStatus::Waiting), static_cast<int>(one.AdvanceFrame(0)));
+    CLOVE_INT_EQ(static_cast<int>(chipotto::RollbackSession::MaxRollback), static_cast<int>(one.GetFrame()));
+}
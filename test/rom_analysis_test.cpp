@@ -0,0 +1,126 @@
+#define CLOVE_SUITE_NAME RomAnalysisTestSuite
+#include "clove-unit.h"
+#include "rom_analysis.h"
+#include <array>
+#include <vector>
+
+CLOVE_TEST(RomAnalysis_FollowsSkipsCallsAndJumps)
+{
+    // 0x200: SE V0, 1 / 0x202: CALL 0x20A / 0x204: JP 0x200 / 0x206: F000 0300 / 0x20A: RET
+    const std::array<uint8_t, 12> program = { 0x30, 0x01, 0x22, 0x0A, 0x12, 0x00, 0xF0, 0x00, 0x03, 0x00, 0x00, 0xEE };
+    auto image = chipotto::MemoryImage::Create(program);
+    const chipotto::RomAnalysis analysis = chipotto::AnalyseRom(*image, chipotto::QuirkProfile::XoChip);
+
+    CLOVE_INT_EQ(4, static_cast<int>(analysis.Blocks.size()));
+    const chipotto::BasicBlock* skip = analysis.FindBlock(0x200);
+    CLOVE_NOT_NULL(skip);
+    CLOVE_IS_TRUE(skip->Exit == chipotto::ControlFlow::Skip);
+    CLOVE_INT_EQ(0x202, skip->Successors[0]);
+    CLOVE_INT_EQ(0x204, skip->Successors[1]);
+    const chipotto::BasicBlock* call = analysis.FindBlock(0x202);
+    CLOVE_NOT_NULL(call);
+    CLOVE_IS_TRUE(call->Exit == chipotto::ControlFlow::Call);
+    CLOVE_INT_EQ(0x20A, call->Successors[0]);
+    CLOVE_INT_EQ(0x204, call->Successors[1]);
+    CLOVE_IS_TRUE(analysis.FindBlock(0x20A)->Exit == chipotto::ControlFlow::Dynamic);
+    CLOVE_NULL(analysis.FindBlock(0x206));
+
+    CLOVE_INT_EQ(2, static_cast<int>(analysis.Subroutines.size()));
+    CLOVE_INT_EQ(0x20A, analysis.Subroutines[1]);
+    CLOVE_INT_EQ(1, static_cast<int>(analysis.Calls.size()));
+    CLOVE_INT_EQ(0x200, analysis.Calls[0].Caller);
+    CLOVE_INT_EQ(0x202, analysis.Calls[0].Site);
+    CLOVE_INT_EQ(0x20A, analysis.Calls[0].Callee);
+    CLOVE_IS_FALSE(analysis.HasDynamicCode());
+}
+
+CLOVE_TEST(RomAnalysis_ClassifiesSpritesAsData)
+{
+    // 0x200: LD I, 0x20A / 0x202: DRW V0, V0, 5 / 0x204: ADD V0, 1 / 0x206: JP 0x204 / 0x208: unused / 0x20A: sprite
+    const std::array<uint8_t, 16> program = { 0xA2, 0x0A, 0xD0, 0x05, 0x70, 0x01, 0x12, 0x04, 0xFF, 0xFF, 0xF0, 0x90, 0x90, 0x90, 0xF0, 0x00 };
+    auto image = chipotto::MemoryImage::Create(program);
+    const chipotto::RomAnalysis analysis = chipotto::AnalyseRom(*image, chipotto::QuirkProfile::Chipotto);
+
+    CLOVE_IS_TRUE(analysis.Bytes[0x200] == chipotto::ByteClass::Code);
+    CLOVE_IS_TRUE(analysis.Bytes[0x207] == chipotto::ByteClass::Code);
+    CLOVE_IS_TRUE(analysis.Bytes[0x208] == chipotto::ByteClass::Unknown);
+    for (uint32_t address = 0x20A; address < 0x20F; ++address)
+    {
+        CLOVE_IS_TRUE(analysis.Bytes[address] == chipotto::ByteClass::Data);
+    }
+    CLOVE_IS_TRUE(analysis.Bytes[0x20F] == chipotto::ByteClass::Unknown);
+
+    // The loop back to 0x204 starts a second block.
+    CLOVE_INT_EQ(2, static_cast<int>(analysis.Blocks.size()));
+    CLOVE_INT_EQ(4, static_cast<int>(analysis.OpcodeHistogram.size()));
+    CLOVE_INT_EQ(1, analysis.OpcodeHistogram.at(0xA000));
+    CLOVE_INT_EQ(1, analysis.OpcodeHistogram.at(0xD000));
+    CLOVE_INT_EQ(1, analysis.OpcodeHistogram.at(0x7000));
+    CLOVE_INT_EQ(1, analysis.OpcodeHistogram.at(0x1000));
+}
+
+CLOVE_TEST(RomAnalysis_FlagsDynamicCode)
+{
+    // Stores into its own code.
+    const std::array<uint8_t, 6> self_modifying = { 0xA2, 0x00, 0xF0, 0x55, 0x12, 0x04 };
+    auto image = chipotto::MemoryImage::Create(self_modifying);
+    chipotto::RomAnalysis analysis = chipotto::AnalyseRom(*image, chipotto::QuirkProfile::Chipotto);
+    CLOVE_IS_TRUE(analysis.FindBlock(0x200)->WritesCode);
+    CLOVE_IS_FALSE(analysis.FindBlock(0x200)->UnresolvedWrite);
+    CLOVE_IS_TRUE(analysis.HasDynamicCode());
+
+    // Stores through an I that depends on a register.
+    const std::array<uint8_t, 6> indexed = { 0xF0, 0x1E, 0xF0, 0x55, 0x12, 0x04 };
+    image = chipotto::MemoryImage::Create(indexed);
+    analysis = chipotto::AnalyseRom(*image, chipotto::QuirkProfile::Chipotto);
+    CLOVE_IS_TRUE(analysis.FindBlock(0x200)->UnresolvedWrite);
+    CLOVE_IS_TRUE(analysis.HasDynamicCode());
+
+    // Jumps through V0.
+    const std::array<uint8_t, 4> computed = { 0x60, 0x02, 0xB3, 0x00 };
+    image = chipotto::MemoryImage::Create(computed);
+    analysis = chipotto::AnalyseRom(*image, chipotto::QuirkProfile::Chipotto);
+    CLOVE_INT_EQ(1, static_cast<int>(analysis.Blocks.size()));
+    CLOVE_IS_TRUE(analysis.Blocks[0].ComputedJump);
+    CLOVE_IS_TRUE(analysis.HasDynamicCode());
+}
+
+CLOVE_TEST(RomAnalysis_StopsAtOpcodesTheInterpreterRejects)
+{
+    // 0x200: MEGAON / 0x202: BMODE 4 / 0x204: 0805, which names no blend mode / 0x206: CLS
+    const std::array<uint8_t, 8> program = { 0x00, 0x11, 0x08, 0x04, 0x08, 0x05, 0x00, 0xE0 };
+    auto image = chipotto::MemoryImage::Create(program);
+    const chipotto::RomAnalysis analysis = chipotto::AnalyseRom(*image, chipotto::QuirkProfile::MegaChip);
+
+    CLOVE_INT_EQ(1, static_cast<int>(analysis.Blocks.size()));
+    CLOVE_INT_EQ(3, static_cast<int>(analysis.Blocks[0].Instructions));
+    CLOVE_IS_TRUE(analysis.Blocks[0].Exit == chipotto::ControlFlow::Dynamic);
+    CLOVE_IS_TRUE(analysis.Bytes[0x206] == chipotto::ByteClass::Unknown);
+    CLOVE_INT_EQ(1, analysis.OpcodeHistogram.at(0x0804));
+    CLOVE_INT_EQ(1, analysis.OpcodeHistogram.at(0x0805));
+}
+
+CLOVE_TEST(RomAnalysis_ParallelMatchesSequential)
+{
+    std::vector<std::shared_ptr<const chipotto::MemoryImage>> images;
+    std::vector<chipotto::QuirkProfile> quirks;
+    for (uint8_t i = 0; i < 64; ++i)
+    {
+        // LD V0, i / SE V0, i / CALL 0x20C / JP 0x200 / DRW V0, V0, i / unused / RET
+        const std::array<uint8_t, 14> program = { 0x60, i, 0x30, i, 0x22, 0x0C, 0x12, 0x00, 0xD0, static_cast<uint8_t>(i & 0xF), 0x00, 0x00, 0x00, 0xEE };
+        images.push_back(chipotto::MemoryImage::Create(program));
+        quirks.push_back(i % 2 ? chipotto::QuirkProfile::SuperChip : chipotto::QuirkProfile::CosmacVip);
+    }
+
+    const std::vector<chipotto::RomAnalysis> results = chipotto::AnalyseRoms(images, quirks, 4);
+    CLOVE_INT_EQ(64, static_cast<int>(results.size()));
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        const chipotto::RomAnalysis expected = chipotto::AnalyseRom(*images[i], quirks[i]);
+        CLOVE_IS_TRUE(results[i].Quirks == quirks[i]);
+        CLOVE_INT_EQ(static_cast<int>(expected.Blocks.size()), static_cast<int>(results[i].Blocks.size()));
+        CLOVE_IS_TRUE(expected.OpcodeHistogram == results[i].OpcodeHistogram);
+        CLOVE_IS_TRUE(expected.Bytes == results[i].Bytes);
+        CLOVE_INT_EQ(static_cast<int>(expected.Calls.size()), static_cast<int>(results[i].Calls.size()));
+    }
+}
@@ -0,0 +1,93 @@
+#define CLOVE_SUITE_NAME RomPackTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "rom_pack.h"
+#include <array>
+#include <vector>
+
+CLOVE_TEST(LoadFromMemory_RejectsOversizedProgram)
+{
+    chipotto::Emulator emulator;
+
+    std::vector<uint8_t> program(0xE01, 0x00);
+    CLOVE_IS_FALSE(emulator.LoadFromMemory(program, chipotto::MemoryImage::DefaultSize));
+    CLOVE_IS_TRUE(emulator.LoadFromMemory(program));
+    CLOVE_INT_EQ(chipotto::MemoryImage::ExtendedSize, emulator.GetMemoryMapping().GetSize());
+    program.resize(0x10000 - 0x1FF);
+    CLOVE_IS_FALSE(emulator.LoadFromMemory(program, chipotto::MemoryImage::ExtendedSize));
+    program.resize(0xE00);
+    program[0] = 0xAB;
+    CLOVE_IS_TRUE(emulator.LoadFromMemory(program));
+    CLOVE_INT_EQ(0xAB, emulator.GetMemoryMapping()[0x200]);
+}
+
+CLOVE_TEST(RomPack_RoundTrip)
+{
+    const std::array<uint8_t, 4> pong = { 0x6A, 0x02, 0x6B, 0x0C };
+    const std::array<uint8_t, 2> maze = { 0xA2, 0x1E };
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "chipotto_rom_pack_test.c8pk";
+
+    chipotto::RomPackBuilder builder;
+    builder.Add("PONG", pong);
+    builder.Add("MAZE", maze);
+    CLOVE_IS_TRUE(builder.Write(path));
+
+    chipotto::RomPack pack;
+    CLOVE_IS_TRUE(pack.Open(path));
+    CLOVE_INT_EQ(2, pack.GetCount());
+
+    std::span<const uint8_t> rom = pack.Find("PONG");
+    CLOVE_INT_EQ(4, static_cast<int>(rom.size()));
+    CLOVE_INT_EQ(0x6B, rom[2]);
+    CLOVE_INT_EQ(2, static_cast<int>(pack.Find("MAZE").size()));
+    CLOVE_IS_TRUE(pack.Find("TETRIS").empty());
+
+    chipotto::Emulator emulator;
+    CLOVE_IS_TRUE(emulator.LoadFromMemory(pack.Find("MAZE")));
+    CLOVE_INT_EQ(0xA2, emulator.GetMemoryMapping()[0x200]);
+
+    pack.Close();
+    std::filesystem::remove(path);
+}
+
+CLOVE_TEST(RomPack_RejectsGarbage)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "chipotto_rom_pack_garbage.c8pk";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "definitely not a rom pack";
+    }
+
+    chipotto::RomPack pack;
+    CLOVE_IS_FALSE(pack.Open(path));
+    CLOVE_IS_FALSE(pack.IsValid());
+    std::filesystem::remove(path);
+}
+
+CLOVE_TEST(RomPack_CreateImageFitsLargeRoms)
+{
+    // Past the 3.5 KB a 4 KB image holds, so it needs XO-CHIP's 64 KB.
+    std::vector<uint8_t> large(0x1000, 0x00);
+    large.back() = 0xCD;
+    const std::array<uint8_t, 2> small = { 0x12, 0x00 };
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "chipotto_rom_pack_large.c8pk";
+
+    chipotto::RomPackBuilder builder;
+    builder.Add("LARGE", large);
+    builder.Add("SMALL", small);
+    CLOVE_IS_TRUE(builder.Write(path));
+    chipotto::RomPack pack;
+    CLOVE_IS_TRUE(pack.Open(path));
+
+    std::shared_ptr<const chipotto::MemoryImage> image = pack.CreateImage("LARGE");
+    CLOVE_NOT_NULL(image.get());
+    CLOVE_INT_EQ(chipotto::MemoryImage::ExtendedSize, image->GetSize());
+    chipotto::Emulator emulator;
+    emulator.LoadFromImage(image);
+    CLOVE_INT_EQ(0xCD, emulator.GetMemoryMapping()[0x11FF]);
+    CLOVE_INT_EQ(chipotto::MemoryImage::DefaultSize, pack.CreateImage("SMALL")->GetSize());
+    CLOVE_NULL(pack.CreateImage("TETRIS").get());
+
+    pack.Close();
+    std::filesystem::remove(path);
+}
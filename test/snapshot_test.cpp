@@ -0,0 +1,135 @@
+#define CLOVE_SUITE_NAME SnapshotTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "differential.h"
+#include "run_ahead.h"
+#include "test_programs.h"
+#include <vector>
+
+CLOVE_TEST(Snapshot_RestoresCpuMemoryAndDisplay)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(CountingProgram);
+    emulator.SetQuirks(chipotto::QuirkProfile::SuperChip);
+    emulator.RunFrame(CountingInstructions);
+
+    chipotto::Snapshot snapshot;
+    emulator.SaveState(snapshot);
+    const chipotto::Framebuffer::Plane rows = emulator.GetFramebuffer().Rows;
+    emulator.RunFrame(CountingInstructions);
+    emulator.RunFrame(CountingInstructions);
+    CLOVE_INT_EQ(3, emulator.GetMemoryMapping()[0x300]);
+
+    emulator.SetQuirks(chipotto::QuirkProfile::Chipotto);
+    emulator.LoadState(snapshot);
+    CLOVE_INT_EQ(1, emulator.GetRegisters()[0]);
+    CLOVE_INT_EQ(1, emulator.GetMemoryMapping()[0x300]);
+    CLOVE_IS_TRUE(rows == emulator.GetFramebuffer().Rows);
+    CLOVE_INT_EQ(static_cast<int>(chipotto::QuirkProfile::SuperChip), static_cast<int>(emulator.GetQuirks()));
+}
+
+CLOVE_TEST(Snapshot_KeepsPrivatePagesOnRestore)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(CountingProgram);
+
+    chipotto::Snapshot snapshot;
+    emulator.SaveState(snapshot);
+    CLOVE_INT_EQ(0, emulator.GetMemoryMapping().GetPrivatePageCount());
+    emulator.RunFrame(CountingInstructions);
+    CLOVE_INT_EQ(1, emulator.GetMemoryMapping().GetPrivatePageCount());
+
+    // The written page goes back to the image contents but stays private, ready for reuse.
+    emulator.LoadState(snapshot);
+    CLOVE_INT_EQ(1, emulator.GetMemoryMapping().GetPrivatePageCount());
+    CLOVE_INT_EQ(0, emulator.GetMemoryMapping()[0x300]);
+}
+
+CLOVE_TEST(Snapshot_RestoresRandomState)
+{
+    chipotto::Emulator emulator;
+    emulator.SetSeed(42);
+    chipotto::Snapshot snapshot;
+    emulator.SaveState(snapshot);
+    const uint64_t checksum = emulator.GetStateChecksum();
+
+    emulator.OpcodeC(0xC0FF);
+    const uint8_t value = emulator.GetRegisters()[0];
+    CLOVE_IS_TRUE(checksum != emulator.GetStateChecksum());
+
+    emulator.LoadState(snapshot);
+    CLOVE_ULLONG_EQ(checksum, emulator.GetStateChecksum());
+    emulator.OpcodeC(0xC0FF);
+    CLOVE_INT_EQ(value, emulator.GetRegisters()[0]);
+}
+
+CLOVE_TEST(StateChecksum_IncrementalHashesMatchRecomputation)
+{
+    // Random XO-CHIP programs draw, scroll, clear and store all over 64 KB.
+    int mismatches = 0;
+    for (uint64_t seed = 1; seed <= 20; ++seed)
+    {
+        const std::vector<uint8_t> program = chipotto::GenerateRandomProgram(seed, 64, chipotto::QuirkProfile::XoChip);
+        chipotto::Emulator emulator;
+        emulator.LoadFromMemory(program, chipotto::MemoryImage::ExtendedSize);
+        emulator.SetQuirks(chipotto::QuirkProfile::XoChip);
+        emulator.SetSeed(seed);
+        chipotto::Snapshot snapshot;
+        for (int step = 0; step < 500 && emulator.Tick(); ++step)
+        {
+            const bool memory_match = emulator.GetMemoryMapping().GetContentHash() == emulator.GetMemoryMapping().ComputeContentHash();
+            const bool pixels_match = emulator.GetFramebuffer().GetPixelHash() == emulator.GetFramebuffer().ComputePixelHash();
+            emulator.SaveState(snapshot);
+            const bool snapshot_match = snapshot.GetChecksum() == emulator.GetStateChecksum();
+            if (!(memory_match && pixels_match && snapshot_match)) mismatches++;
+        }
+    }
+    CLOVE_INT_EQ(0, mismatches);
+}
+
+CLOVE_TEST(StateChecksum_DependsOnStateNotHistory)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(CountingProgram);
+    chipotto::Snapshot start;
+    emulator.SaveState(start);
+    const uint64_t initial = emulator.GetStateChecksum();
+
+    // The program writes 0x300 and draws; putting both back gives the initial checksum again.
+    emulator.RunFrame(CountingInstructions * 3);
+    CLOVE_IS_TRUE(initial != emulator.GetStateChecksum());
+    emulator.WriteMemory(0x300, 0);
+    emulator.Opcode0(0x00E0);
+    emulator.GetCpuState() = start.Cpu;
+    CLOVE_ULLONG_EQ(initial, emulator.GetStateChecksum());
+
+    // A fresh instance in the same state agrees, and so does the restored snapshot.
+    emulator.RunFrame(CountingInstructions * 2);
+    chipotto::Emulator other;
+    other.LoadFromMemory(CountingProgram);
+    other.RunFrame(CountingInstructions * 2);
+    CLOVE_ULLONG_EQ(other.GetStateChecksum(), emulator.GetStateChecksum());
+    emulator.LoadState(start);
+    CLOVE_ULLONG_EQ(initial, emulator.GetStateChecksum());
+    CLOVE_ULLONG_EQ(initial, start.GetChecksum());
+}
+
+CLOVE_TEST(RunAhead_PresentsFutureFrame)
+{
+    chipotto::Emulator primary;
+    primary.LoadFromMemory(CountingProgram);
+    chipotto::Emulator reference;
+    reference.LoadFromMemory(CountingProgram);
+
+    chipotto::RunAhead run_ahead(2);
+    CLOVE_IS_TRUE(run_ahead.RunFrame(primary, CountingInstructions, false));
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        reference.RunFrame(CountingInstructions);
+    }
+
+    CLOVE_INT_EQ(1, primary.GetRegisters()[0]);
+    CLOVE_IS_TRUE(reference.GetFramebuffer().Rows == run_ahead.GetFramebuffer(primary).Rows);
+    CLOVE_IS_FALSE(primary.GetFramebuffer().Rows == run_ahead.GetFramebuffer(primary).Rows);
+    CLOVE_ULLONG_EQ(static_cast<unsigned long long>(run_ahead.GetLastOverhead().count()), static_cast<unsigned long long>(run_ahead.GetMaxOverhead().count()));
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Clears the screen, draws the font digit for V0, increments V0 and stores it at 0x300.
+static constexpr std::array<uint8_t, 14> CountingProgram =
+{
+    0x00, 0xE0, 0xF0, 0x29, 0xD0, 0x05, 0x70, 0x01, 0xA3, 0x00, 0xF0, 0x55, 0x12, 0x00
+};
+// One pass of CountingProgram's loop.
+static constexpr uint32_t CountingInstructions = 7;
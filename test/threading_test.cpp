@@ -0,0 +1,105 @@
+#define CLOVE_SUITE_NAME ThreadingTestSuite
+#include "clove-unit.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+#include <array>
+#include <thread>
+
+CLOVE_TEST(SpscQueue_FullAndEmpty)
+{
+    chipotto::SpscQueue<int, 4> queue;
+    int value = 0;
+
+    CLOVE_IS_FALSE(queue.Pop(value));
+    for (int i = 0; i < 4; ++i)
+    {
+        CLOVE_IS_TRUE(queue.Push(i));
+    }
+    CLOVE_IS_FALSE(queue.Push(4));
+    CLOVE_IS_TRUE(queue.Pop(value));
+    CLOVE_INT_EQ(0, value);
+    CLOVE_IS_TRUE(queue.Push(4));
+}
+
+CLOVE_TEST(SpscQueue_KeepsOrderAcrossThreads)
+{
+    chipotto::SpscQueue<int, 64> queue;
+    constexpr int count = 100000;
+
+    std::thread producer([&queue]()
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                while (!queue.Push(i)) std::this_thread::yield();
+            }
+        });
+
+    int expected = 0;
+    bool ordered = true;
+    while (expected < count)
+    {
+        int value;
+        if (!queue.Pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered &= value == expected;
+        expected++;
+    }
+    producer.join();
+    CLOVE_IS_TRUE(ordered);
+}
+
+CLOVE_TEST(TripleBuffer_ConsumesLatest)
+{
+    chipotto::TripleBuffer<int> buffer;
+
+    CLOVE_IS_FALSE(buffer.Consume());
+    buffer.GetWriteBuffer() = 1;
+    buffer.Publish();
+    buffer.GetWriteBuffer() = 2;
+    buffer.Publish();
+    CLOVE_IS_TRUE(buffer.Consume());
+    CLOVE_INT_EQ(2, buffer.GetReadBuffer());
+    CLOVE_IS_FALSE(buffer.Consume());
+    CLOVE_INT_EQ(2, buffer.GetReadBuffer());
+}
+
+CLOVE_TEST(TripleBuffer_FramesArriveWholeAcrossThreads)
+{
+    // Every published frame holds one value repeated; a torn read would mix two of them.
+    chipotto::TripleBuffer<std::array<int, 64>> buffer;
+    constexpr int count = 20000;
+
+    std::thread producer([&buffer]()
+        {
+            for (int i = 1; i <= count; ++i)
+            {
+                buffer.GetWriteBuffer().fill(i);
+                buffer.Publish();
+            }
+        });
+
+    bool whole = true;
+    bool increasing = true;
+    int last = 0;
+    while (last < count)
+    {
+        if (!buffer.Consume())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const std::array<int, 64>& frame = buffer.GetReadBuffer();
+        for (const int value : frame)
+        {
+            whole &= value == frame[0];
+        }
+        increasing &= frame[0] > last;
+        last = frame[0];
+    }
+    producer.join();
+    CLOVE_IS_TRUE(whole);
+    CLOVE_IS_TRUE(increasing);
+}
@@ -0,0 +1,163 @@
+#define CLOVE_SUITE_NAME TimeTravelTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "debugger.h"
+#include "time_travel.h"
+#include <array>
+#include <vector>
+
+// 0x200: RND V0, 0xFF / LD DT, V0 / LD V1, DT / LD I, 0x300 / ADD I, V1 / LD [I], V0 /
+// 0x20C: SKP V2 / ADD V2, 1 / JP 0x200
+static const std::array<uint8_t, 18> TimerProgram = {
+    0xC0, 0xFF, 0xF0, 0x15, 0xF1, 0x07, 0xA3, 0x00, 0xF1, 0x1E, 0xF0, 0x55, 0xE2, 0x9E, 0x72, 0x01, 0x12, 0x00
+};
+
+struct RecordedRun
+{
+    // Checksum of the state at every position.
+    std::vector<uint64_t> Checksums;
+    // Positions where the next instruction was the LD [I], V0 at 0x20A, and where it stored to 0x300.
+    std::vector<uint64_t> StoreVisits;
+    std::vector<uint64_t> StoresTo300;
+};
+
+// Runs frames of 10 instructions, each followed by a timer tick and new keys.
+static RecordedRun RecordFrames(chipotto::TimeTravelSession& session, const chipotto::Emulator& emulator, const int frames)
+{
+    RecordedRun run;
+    run.Checksums.push_back(emulator.GetStateChecksum());
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            if (emulator.GetPC() == 0x20A)
+            {
+                run.StoreVisits.push_back(session.GetPosition());
+                if (emulator.GetCpuState().I == 0x300) run.StoresTo300.push_back(session.GetPosition());
+            }
+            session.Run(1);
+            if (i < 9) run.Checksums.push_back(emulator.GetStateChecksum());
+        }
+        session.TickTimers();
+        session.SetKeys(static_cast<uint16_t>(frame * 0x1357));
+        run.Checksums.push_back(emulator.GetStateChecksum());
+    }
+    return run;
+}
+
+CLOVE_TEST(TimeTravel_StepBackRestoresEveryPosition)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(TimerProgram);
+    emulator.SetSeed(7);
+    chipotto::Debugger debugger;
+    chipotto::TimeTravelSession session(emulator, debugger, 64);
+    const RecordedRun run = RecordFrames(session, emulator, 200);
+    CLOVE_ULLONG_EQ(2000, session.GetEnd());
+    CLOVE_INT_EQ(2000 / 64 + 1, static_cast<int>(session.GetKeyframeCount()));
+
+    bool all_match = true;
+    for (uint64_t position = 2000; position > 0; --position)
+    {
+        CLOVE_IS_TRUE(session.StepBack());
+        all_match &= session.GetPosition() == position - 1 && emulator.GetStateChecksum() == run.Checksums[position - 1];
+    }
+    CLOVE_IS_TRUE(all_match);
+    CLOVE_IS_FALSE(session.StepBack());
+    CLOVE_IS_TRUE(session.IsReplaying());
+
+    // Running forward again follows the log, timer ticks and keys included.
+    chipotto::DebugStop stop = session.Run(1234);
+    CLOVE_INT_EQ(1234, static_cast<int>(stop.Executed));
+    CLOVE_ULLONG_EQ(run.Checksums[1234], emulator.GetStateChecksum());
+    CLOVE_IS_TRUE(session.Seek(2000));
+    CLOVE_ULLONG_EQ(run.Checksums[2000], emulator.GetStateChecksum());
+    CLOVE_IS_FALSE(session.IsReplaying());
+    CLOVE_IS_FALSE(session.Seek(2001));
+}
+
+CLOVE_TEST(TimeTravel_ReverseContinueAndReverseToWrite)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(TimerProgram);
+    emulator.SetSeed(3);
+    chipotto::Debugger debugger;
+    chipotto::TimeTravelSession session(emulator, debugger, 64);
+    const RecordedRun run = RecordFrames(session, emulator, 300);
+    CLOVE_IS_TRUE(run.StoreVisits.size() > 2);
+    CLOVE_IS_TRUE(run.StoresTo300.size() > 1);
+
+    debugger.SetBreakpoint(0x20A);
+    CLOVE_IS_TRUE(session.ReverseContinue());
+    CLOVE_ULLONG_EQ(run.StoreVisits.back(), session.GetPosition());
+    CLOVE_INT_EQ(0x20A, emulator.GetPC());
+    CLOVE_IS_TRUE(session.ReverseContinue());
+    CLOVE_ULLONG_EQ(run.StoreVisits[run.StoreVisits.size() - 2], session.GetPosition());
+    debugger.ClearBreakpoints();
+
+    CLOVE_IS_TRUE(session.Seek(session.GetEnd()));
+    CLOVE_IS_TRUE(session.ReverseToWrite(0x300));
+    CLOVE_ULLONG_EQ(run.StoresTo300.back(), session.GetPosition());
+    CLOVE_INT_EQ(0x300, static_cast<int>(emulator.GetCpuState().I));
+    CLOVE_IS_TRUE(session.ReverseToWrite(0x300));
+    CLOVE_ULLONG_EQ(run.StoresTo300[run.StoresTo300.size() - 2], session.GetPosition());
+
+    // Nothing writes to 0x2FF: the search ends at the start of the recording.
+    CLOVE_IS_FALSE(session.ReverseToWrite(0x2FF));
+    CLOVE_ULLONG_EQ(0, session.GetPosition());
+}
+
+CLOVE_TEST(TimeTravel_InputInThePastStartsNewFuture)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(TimerProgram);
+    chipotto::Debugger debugger;
+    chipotto::TimeTravelSession session(emulator, debugger, 64);
+    RecordFrames(session, emulator, 50);
+    CLOVE_INT_EQ(8, static_cast<int>(session.GetKeyframeCount()));
+
+    CLOVE_IS_TRUE(session.Seek(100));
+    session.SetKeys(0xFFFF);
+    CLOVE_ULLONG_EQ(100, session.GetEnd());
+    CLOVE_INT_EQ(2, static_cast<int>(session.GetKeyframeCount()));
+    CLOVE_IS_FALSE(session.IsReplaying());
+
+    session.Run(500);
+    CLOVE_ULLONG_EQ(600, session.GetEnd());
+    const uint64_t checksum = emulator.GetStateChecksum();
+    CLOVE_IS_TRUE(session.Seek(50));
+    CLOVE_IS_TRUE(session.Seek(600));
+    CLOVE_ULLONG_EQ(checksum, emulator.GetStateChecksum());
+}
+
+CLOVE_TEST(TimeTravel_LongRunTakesKeyframesEveryInterval)
+{
+    chipotto::Emulator reference;
+    reference.LoadFromMemory(TimerProgram);
+    reference.SetSeed(5);
+    std::vector<uint64_t> checksums;
+    checksums.push_back(reference.GetStateChecksum());
+    for (int i = 0; i < 2000; ++i)
+    {
+        reference.Tick();
+        checksums.push_back(reference.GetStateChecksum());
+    }
+
+    // Recording the same 2000 instructions in one call still takes a keyframe every interval.
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(TimerProgram);
+    emulator.SetSeed(5);
+    chipotto::Debugger debugger;
+    chipotto::TimeTravelSession session(emulator, debugger, 64);
+    CLOVE_INT_EQ(2000, static_cast<int>(session.Run(2000).Executed));
+    CLOVE_INT_EQ(2000 / 64 + 1, static_cast<int>(session.GetKeyframeCount()));
+    CLOVE_ULLONG_EQ(checksums[2000], emulator.GetStateChecksum());
+
+    bool all_match = true;
+    for (uint64_t position = 2000; position > 1900; --position)
+    {
+        CLOVE_IS_TRUE(session.StepBack());
+        all_match &= emulator.GetStateChecksum() == checksums[position - 1];
+    }
+    CLOVE_IS_TRUE(all_match);
+}
@@ -0,0 +1,142 @@
+#define CLOVE_SUITE_NAME TraceTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include "trace.h"
+#include <array>
+#include <filesystem>
+#include <vector>
+
+// 0x200: ADD V0, 1 / 0x202: SKP V1 / 0x204: JP 0x200 / 0x206: LD V2, 5 / 0x208: JP 0x208
+static const std::array<uint8_t, 10> KeyLoopProgram = { 0x70, 0x01, 0xE1, 0x9E, 0x12, 0x00, 0x62, 0x05, 0x12, 0x08 };
+
+// Runs KeyLoopProgram for the given number of instructions, pressing key 0 before
+// instruction press_at.
+static bool WriteKeyLoopTrace(const std::filesystem::path& path, const uint32_t instructions, const uint32_t press_at)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(KeyLoopProgram);
+    chipotto::TraceWriter writer;
+    if (!writer.Open(path, emulator)) return false;
+    for (uint32_t i = 0; i < instructions; ++i)
+    {
+        if (i == press_at) emulator.KeyDown(0);
+        writer.Tick(emulator);
+    }
+    return writer.Close();
+}
+
+CLOVE_TEST(Trace_RoundTripsRecords)
+{
+    // LD I, 0x300 / LD V3, 0xA7 / LD B, V3 / RND V4, 0xFF / LD [I], V4 / JP 0x206
+    const std::array<uint8_t, 12> program = { 0xA3, 0x00, 0x63, 0xA7, 0xF3, 0x33, 0xC4, 0xFF, 0xF4, 0x55, 0x12, 0x06 };
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "chipotto_trace_test.c8tr";
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    emulator.SetQuirks(chipotto::QuirkProfile::SuperChip);
+
+    chipotto::TraceWriter writer;
+    CLOVE_IS_TRUE(writer.Open(path, emulator));
+    for (int frame = 0; frame < 200; ++frame)
+    {
+        CLOVE_IS_TRUE(writer.RunFrame(emulator, 200));
+    }
+    CLOVE_IS_TRUE(writer.Close());
+    CLOVE_ULLONG_EQ(40000, writer.GetInstructionCount());
+
+    chipotto::TraceReader reader;
+    CLOVE_IS_TRUE(reader.Open(path));
+    CLOVE_ULLONG_EQ(emulator.GetProgramHash(), reader.GetProgramHash());
+    CLOVE_IS_TRUE(reader.GetQuirks() == chipotto::QuirkProfile::SuperChip);
+    CLOVE_ULLONG_EQ(40000, reader.GetInstructionCount());
+    CLOVE_INT_EQ(3, static_cast<int>(reader.GetIndex().size()));
+
+    std::vector<chipotto::TraceRecord> records;
+    CLOVE_IS_TRUE(reader.ReadBlock(0, records));
+    CLOVE_INT_EQ(0x200, records[0].PC);
+    CLOVE_IS_TRUE(records[0].IChanged);
+    CLOVE_INT_EQ(0x300, records[0].I);
+    CLOVE_INT_EQ(1 << 3, records[1].ChangedRegisters);
+    CLOVE_INT_EQ(0xA7, records[1].Registers[3]);
+    // LD B, V3 stores 1, 6, 7 at I.
+    CLOVE_INT_EQ(3, records[2].WriteLength);
+    CLOVE_INT_EQ(0x300, records[2].WriteAddress);
+    CLOVE_INT_EQ(6, records[2].Written[1]);
+    // LD [I], V4 stores V0-V4 and, under SUPER-CHIP quirks, leaves I alone.
+    CLOVE_INT_EQ(0xF455, records[4].Opcode);
+    CLOVE_INT_EQ(5, records[4].WriteLength);
+    CLOVE_IS_FALSE(records[4].IChanged);
+
+    // Seek to the last block. Instruction 39999 is the loop's RND.
+    const size_t last = reader.FindBlock(39999);
+    CLOVE_INT_EQ(2, static_cast<int>(last));
+    CLOVE_INT_EQ(3, static_cast<int>(reader.FindBlock(40000)));
+    CLOVE_IS_TRUE(reader.ReadBlock(last, records));
+    CLOVE_INT_EQ(static_cast<int>(40000 - reader.GetIndex()[last].FirstInstruction), static_cast<int>(records.size()));
+    CLOVE_INT_EQ(0x206, records.back().PC);
+    CLOVE_INT_EQ(0xC4FF, records.back().Opcode);
+    std::filesystem::remove(path);
+}
+
+CLOVE_TEST(Trace_FindsFirstMismatch)
+{
+    const std::filesystem::path expected_path = std::filesystem::temp_directory_path() / "chipotto_trace_expected.c8tr";
+    const std::filesystem::path actual_path = std::filesystem::temp_directory_path() / "chipotto_trace_actual.c8tr";
+    CLOVE_IS_TRUE(WriteKeyLoopTrace(expected_path, 30000, UINT32_MAX));
+    CLOVE_IS_TRUE(WriteKeyLoopTrace(actual_path, 30000, UINT32_MAX));
+
+    chipotto::TraceReader expected;
+    chipotto::TraceReader actual;
+    chipotto::TraceMismatch mismatch;
+    CLOVE_IS_TRUE(expected.Open(expected_path));
+    CLOVE_IS_TRUE(actual.Open(actual_path));
+    CLOVE_IS_FALSE(chipotto::FindFirstTraceMismatch(expected, actual, mismatch));
+
+    // Pressed before instruction 20000 (a JP), the key makes the SKP at 20002 skip, so the
+    // traces part at 20003 in the second block.
+    CLOVE_IS_TRUE(WriteKeyLoopTrace(actual_path, 30000, 20000));
+    CLOVE_IS_TRUE(actual.Open(actual_path));
+    CLOVE_IS_TRUE(chipotto::FindFirstTraceMismatch(expected, actual, mismatch));
+    CLOVE_ULLONG_EQ(20003, mismatch.Instruction);
+    CLOVE_IS_TRUE(mismatch.HasExpected && mismatch.HasActual);
+    CLOVE_INT_EQ(0x204, mismatch.Expected.PC);
+    CLOVE_INT_EQ(0x206, mismatch.Actual.PC);
+    CLOVE_INT_EQ(0x6205, mismatch.Actual.Opcode);
+
+    // A shorter run of the same program ends where the longer one carries on.
+    CLOVE_IS_TRUE(WriteKeyLoopTrace(actual_path, 25000, UINT32_MAX));
+    CLOVE_IS_TRUE(actual.Open(actual_path));
+    CLOVE_IS_TRUE(chipotto::FindFirstTraceMismatch(expected, actual, mismatch));
+    CLOVE_ULLONG_EQ(25000, mismatch.Instruction);
+    CLOVE_IS_TRUE(mismatch.HasExpected);
+    CLOVE_IS_FALSE(mismatch.HasActual);
+
+    std::filesystem::remove(expected_path);
+    std::filesystem::remove(actual_path);
+}
+
+CLOVE_TEST(Trace_ReaderRebuildsMissingIndex)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "chipotto_trace_unclosed.c8tr";
+    CLOVE_IS_TRUE(WriteKeyLoopTrace(path, 20000, UINT32_MAX));
+
+    chipotto::TraceReader reader;
+    CLOVE_IS_TRUE(reader.Open(path));
+    const uint64_t index_offset = reader.GetIndex().back().Offset;
+    std::vector<chipotto::TraceRecord> complete;
+    CLOVE_IS_TRUE(reader.ReadBlock(1, complete));
+
+    // Cut off the index and footer, as if the writer had been killed.
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - sizeof(chipotto::TraceFooter) - 2 * sizeof(chipotto::TraceIndexEntry));
+    CLOVE_IS_TRUE(reader.Open(path));
+    CLOVE_ULLONG_EQ(20000, reader.GetInstructionCount());
+    CLOVE_ULLONG_EQ(index_offset, reader.GetIndex().back().Offset);
+    std::vector<chipotto::TraceRecord> rebuilt;
+    CLOVE_IS_TRUE(reader.ReadBlock(1, rebuilt));
+    CLOVE_IS_TRUE(complete == rebuilt);
+
+    // Without its last block's tail, only the first block is left.
+    std::filesystem::resize_file(path, index_offset + 40);
+    CLOVE_IS_TRUE(reader.Open(path));
+    CLOVE_ULLONG_EQ(chipotto::TraceWriter::BlockRecords, reader.GetInstructionCount());
+    std::filesystem::remove(path);
+}
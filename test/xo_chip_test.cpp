@@ -0,0 +1,98 @@
+#define CLOVE_SUITE_NAME XoChipTestSuite
+#include "clove-unit.h"
+#include "chip-8.h"
+#include <array>
+#include <vector>
+
+CLOVE_TEST(OpcodeF_LD_I_long)
+{
+    const std::array<uint8_t, 6> program = { 0xF0, 0x00, 0xAB, 0xCD, 0x00, 0xE0 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program, chipotto::MemoryImage::ExtendedSize);
+    CLOVE_IS_TRUE(emulator.Tick());
+    CLOVE_INT_EQ(0xABCD, emulator.GetI());
+    CLOVE_INT_EQ(0x204, emulator.GetPC());
+}
+
+CLOVE_TEST(Skip_StepsOverLongInstruction)
+{
+    const std::array<uint8_t, 8> program = { 0x30, 0x00, 0xF0, 0x00, 0x12, 0x34, 0x00, 0xE0 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    CLOVE_IS_TRUE(emulator.Tick());
+    CLOVE_INT_EQ(0x206, emulator.GetPC());
+}
+
+CLOVE_TEST(Opcode5_SaveLoadRange)
+{
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(std::vector<uint8_t>(0x10, 0x00));
+    emulator.Opcode6(0x6211);
+    emulator.Opcode6(0x6322);
+    emulator.Opcode6(0x6433);
+    emulator.OpcodeA(0xA300);
+    emulator.Opcode5(0x5242);
+    CLOVE_INT_EQ(0x11, emulator.GetMemoryMapping()[0x300]);
+    CLOVE_INT_EQ(0x33, emulator.GetMemoryMapping()[0x302]);
+    CLOVE_INT_EQ(0x300, emulator.GetI());
+
+    // Loading in reverse order puts the first byte into the higher register.
+    emulator.Opcode5(0x5863);
+    CLOVE_INT_EQ(0x11, emulator.GetRegisters()[8]);
+    CLOVE_INT_EQ(0x22, emulator.GetRegisters()[7]);
+    CLOVE_INT_EQ(0x33, emulator.GetRegisters()[6]);
+}
+
+CLOVE_TEST(OpcodeD_DrawsSelectedPlanes)
+{
+    const std::array<uint8_t, 2> sprite = { 0x80, 0xC0 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(sprite);
+    emulator.OpcodeA(0xA200);
+    emulator.OpcodeF(0xF301);
+    emulator.OpcodeD(0xD001);
+
+    const chipotto::Framebuffer& framebuffer = emulator.GetFramebuffer();
+    CLOVE_IS_TRUE(framebuffer.HasExtraPlanes());
+    CLOVE_INT_EQ(3, framebuffer.GetPixelIndex(0, 0));
+    CLOVE_INT_EQ(2, framebuffer.GetPixelIndex(1, 0));
+    CLOVE_INT_EQ(0, emulator.GetRegisters()[0xF]);
+
+    // Clearing with only plane 1 selected leaves plane 0 intact.
+    emulator.OpcodeF(0xF201);
+    emulator.Opcode0(0x00E0);
+    CLOVE_INT_EQ(1, framebuffer.GetPixelIndex(0, 0));
+    CLOVE_INT_EQ(0, framebuffer.GetPixelIndex(1, 0));
+}
+
+CLOVE_TEST(OpcodeF_AudioPatternAndPitch)
+{
+    std::array<uint8_t, 16> pattern;
+    for (uint8_t i = 0; i < pattern.size(); ++i)
+    {
+        pattern[i] = i;
+    }
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(pattern);
+    emulator.OpcodeA(0xA200);
+    emulator.OpcodeF(0xF002);
+    CLOVE_INT_EQ(0x0F, emulator.GetAudioPattern()[15]);
+
+    CLOVE_INT_EQ(4000, static_cast<int>(emulator.GetAudioPlaybackRate()));
+    emulator.Opcode6(0x6070);
+    emulator.OpcodeF(0xF03A);
+    CLOVE_INT_EQ(0x70, emulator.GetPitch());
+    CLOVE_INT_EQ(8000, static_cast<int>(emulator.GetAudioPlaybackRate() + 0.5));
+}
+
+CLOVE_TEST(SetMemorySize_KeepsProgramAndHash)
+{
+    const std::array<uint8_t, 2> program = { 0x12, 0x00 };
+    chipotto::Emulator emulator;
+    emulator.LoadFromMemory(program);
+    const uint64_t hash = emulator.GetProgramHash();
+    emulator.SetMemorySize(chipotto::MemoryImage::ExtendedSize);
+    CLOVE_INT_EQ(chipotto::MemoryImage::ExtendedSize, emulator.GetMemoryMapping().GetSize());
+    CLOVE_ULLONG_EQ(hash, emulator.GetProgramHash());
+    CLOVE_INT_EQ(0x12, emulator.GetMemoryMapping()[0x200]);
+}
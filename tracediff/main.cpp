@@ -0,0 +1,63 @@
+#include <cstdio>
+#include "disassembler.h"
+#include "trace.h"
+
+static void PrintRecord(const char* label, const bool present, const chipotto::TraceRecord& record, const chipotto::QuirkProfile quirks)
+{
+	if (!present)
+	{
+		std::printf("  %-8s (trace ends)\n", label);
+		return;
+	}
+	char mnemonic[chipotto::MaxDisassemblyLength];
+	chipotto::Disassemble(record.Opcode, 0, quirks, mnemonic);
+	std::printf("  %-8s 0x%04X: %04X  %-18s", label, record.PC, record.Opcode, mnemonic);
+	for (uint32_t index = 0; index < 0x10; ++index)
+	{
+		if (record.ChangedRegisters & (1 << index)) std::printf(" V%X=%02X", index, record.Registers[index]);
+	}
+	if (record.IChanged) std::printf(" I=%06X", record.I);
+	if (record.WriteLength)
+	{
+		std::printf(" [%06X]=", record.WriteAddress);
+		for (uint32_t offset = 0; offset < record.WriteLength; ++offset) std::printf("%02X", record.Written[offset]);
+	}
+	std::printf("\n");
+}
+
+// Reports the first instruction at which two traces written by chipotto::TraceWriter differ.
+// Exits with 0 when they match, 1 when they differ.
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "Usage: %s <expected trace> <actual trace>\n", argv[0]);
+		return -1;
+	}
+
+	chipotto::TraceReader expected;
+	chipotto::TraceReader actual;
+	if (!expected.Open(argv[1]))
+	{
+		std::fprintf(stderr, "Unable to read trace %s\n", argv[1]);
+		return -1;
+	}
+	if (!actual.Open(argv[2]))
+	{
+		std::fprintf(stderr, "Unable to read trace %s\n", argv[2]);
+		return -1;
+	}
+	if (expected.GetProgramHash() != actual.GetProgramHash()) std::printf("warning: the traces come from different ROMs\n");
+	if (expected.GetQuirks() != actual.GetQuirks()) std::printf("warning: the traces use different quirk profiles\n");
+
+	chipotto::TraceMismatch mismatch;
+	if (!chipotto::FindFirstTraceMismatch(expected, actual, mismatch))
+	{
+		std::printf("traces match over %llu instructions\n", static_cast<unsigned long long>(expected.GetInstructionCount()));
+		return 0;
+	}
+	std::printf("first mismatch at instruction %llu\n", static_cast<unsigned long long>(mismatch.Instruction));
+	PrintRecord("expected", mismatch.HasExpected, mismatch.Expected, expected.GetQuirks());
+	PrintRecord("actual", mismatch.HasActual, mismatch.Actual, actual.GetQuirks());
+	return 1;
+}